@@ -0,0 +1,49 @@
+﻿// Base64.h
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Base64 编解码 (RFC 4648 标准字母表)，邮件模块与文件系统模块共用
+// - x86/x64 上运行时检测 CPU，选择 AVX2 / SSSE3 / 标量实现，结果完全一致
+// - 输出追加到调用方的 std::string，不产生临时字符串
+namespace Base64 {
+
+    enum class Kernel {
+        Scalar,
+        Ssse3,
+        Avx2
+    };
+
+    enum class DecodeMode {
+        Strict,   // 只允许字母表字符，长度为 4 的倍数，'=' 只能出现在末尾
+        Lenient   // 跳过空白、换行等非字母表字符，末尾 '=' 可省略，'=' 之后的内容忽略
+    };
+
+    // 当前使用的实现及其名称 ("AVX2" / "SSSE3" / "Scalar")
+    Kernel ActiveKernel();
+    const char* KernelName(Kernel kernel);
+
+    // 指定实现 (基准测试用)；CPU 不支持时返回 false，保持原来的选择
+    bool SelectKernel(Kernel kernel);
+
+    // 编码后的长度 (含填充，不含换行)
+    size_t EncodedLength(size_t size);
+
+    // 编码并追加到 out
+    void EncodeTo(const void* data, size_t size, std::string& out);
+    std::string Encode(const std::string& data);
+
+    // 编码并按 lineLength 个字符换行 (MIME 为 76)，每行 (包括最后一行) 以 CRLF 结尾
+    // lineLength 会向下取整为 4 的倍数
+    void EncodeLinesTo(const void* data, size_t size, std::string& out, size_t lineLength = 76);
+
+    // 把已经编码好的 Base64 文本按 lineLength 个字符换行追加到 out，每行以 CRLF 结尾
+    void WrapLinesTo(const char* text, size_t size, std::string& out, size_t lineLength = 76);
+
+    // 解码并追加到 out；失败 (Strict 模式遇到非法输入) 时返回 false，out 保持调用前的内容
+    bool DecodeTo(const char* text, size_t size, std::string& out, DecodeMode mode = DecodeMode::Strict);
+
+    // 宽松解码，忽略非法字符
+    std::string Decode(const std::string& text);
+}
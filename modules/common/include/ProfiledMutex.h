@@ -0,0 +1,67 @@
+﻿// ProfiledMutex.h
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 锁等待/持有时间直方图的桶数。第 i 个桶统计 < 2^i 微秒的样本，最后一个桶为溢出桶
+const int LOCK_PROFILE_BUCKETS = 22;
+
+// 一个命名锁的统计快照 (同名的多个 ProfiledMutex 实例合并统计)
+struct LockProfileSnapshot {
+    std::string name;
+    uint64_t acquisitions;                      // 加锁次数
+    uint64_t contended;                         // 需要等待的次数 (try_lock 失败)
+    uint64_t waitMicrosTotal;                   // 等待总时长 (仅竞争时计时)
+    uint64_t waitMicrosMax;
+    uint64_t waitHistogram[LOCK_PROFILE_BUCKETS];
+    uint64_t holdSamples;                       // 持有时间的采样次数
+    uint64_t holdMicrosTotal;
+    uint64_t holdMicrosMax;
+    uint64_t holdHistogram[LOCK_PROFILE_BUCKETS];
+};
+
+// 进程内每个锁名对应一份累计统计 (原子计数，多个实例共享)
+class LockProfile;
+
+// 带竞争分析的互斥锁，可直接替换 std::mutex (满足 Lockable，可用于 lock_guard/unique_lock)
+// - 无竞争时只多一次 try_lock 和一次原子加法，不读时钟
+// - 竞争时记录等待时间；持有时间在竞争时以及每 HOLD_SAMPLE_PERIOD 次加锁中采样一次
+class ProfiledMutex {
+public:
+    explicit ProfiledMutex(const char* name);
+    ProfiledMutex(const ProfiledMutex&) = delete;
+    ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+    void lock();
+    bool try_lock();
+    void unlock();
+
+    static const uint32_t HOLD_SAMPLE_PERIOD = 16;
+
+private:
+    void OnAcquired(bool sampleHold);
+
+    std::mutex mutex_;
+    LockProfile* profile_;
+    // 以下字段只由持有锁的线程访问
+    uint32_t acquireCounter_;
+    bool holdSampled_;
+    std::chrono::steady_clock::time_point holdStart_;
+};
+
+// 报告接口
+namespace LockProfiler {
+    // 所有已注册锁的统计快照，按等待总时长降序
+    std::vector<LockProfileSnapshot> Snapshot();
+
+    // 文本报告：每个锁一行 (加锁次数、竞争次数与比例、等待总计/最大/p99、持有平均/最大/p99)
+    std::string Report();
+
+    // 从直方图估算分位数 (返回该分位所在桶的上界，微秒；落在溢出桶时没有上界，返回 UINT64_MAX)
+    uint64_t Percentile(const uint64_t (&histogram)[LOCK_PROFILE_BUCKETS], double quantile);
+}
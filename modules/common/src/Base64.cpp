@@ -0,0 +1,525 @@
+﻿// Base64.cpp
+#include "Base64.h"
+#include <atomic>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define BASE64_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// GCC/Clang 需要为使用 SSSE3/AVX2 指令的函数单独指定目标；MSVC 不需要
+#if defined(__GNUC__) && !defined(_MSC_VER)
+#define BASE64_TARGET(isa) __attribute__((target(isa)))
+#else
+#define BASE64_TARGET(isa)
+#endif
+
+// 128 位循环同时用于 SSSE3 实现和 AVX2 实现的尾部；强制内联使其在 AVX2 函数中按 VEX 编码生成，
+// 避免在 AVX2 与传统 SSE 指令之间切换带来的状态转换开销
+#if defined(_MSC_VER)
+#define BASE64_INLINE __forceinline
+#elif defined(__GNUC__)
+#define BASE64_INLINE inline __attribute__((always_inline))
+#else
+#define BASE64_INLINE inline
+#endif
+
+namespace {
+
+    const char ENCODE_TABLE[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+        "abcdefghijklmnopqrstuvwxyz"
+        "0123456789+/";
+
+    const uint8_t INVALID = 0xFF;
+
+    // 解码表：字符 -> 6 位值，非字母表字符为 INVALID (编译期生成，不在每次解码时重建)
+    struct DecodeTable {
+        uint8_t value[256];
+
+        constexpr DecodeTable() : value() {
+            for (int i = 0; i < 256; ++i) {
+                value[i] = INVALID;
+            }
+            for (int i = 0; i < 64; ++i) {
+                value[static_cast<unsigned char>(ENCODE_TABLE[i])] = static_cast<uint8_t>(i);
+            }
+        }
+    };
+    constexpr DecodeTable DECODE_TABLE;
+
+    // SIMD 解码每次写出 32 字节而只有 24 字节有效，输出缓冲区需要多留的空间
+    const size_t DECODE_SLACK = 32;
+
+    // 批量编码：只处理完整的块，返回已处理的输入字节数 (3 的倍数，输出为其 4/3)
+    // size 为本次要编码的字节数，readable 为从 src 起可以安全读取的字节数 (>= size)
+    typedef size_t (*EncodeBlocksFn)(const uint8_t* src, size_t size, size_t readable, char* dst);
+
+    // 批量解码：只处理不含非法字符的完整块，返回已处理的输入字符数 (4 的倍数，输出为其 3/4)
+    typedef size_t (*DecodeBlocksFn)(const char* src, size_t size, uint8_t* dst);
+
+    size_t EncodeBlocksScalar(const uint8_t*, size_t, size_t, char*) {
+        return 0;
+    }
+
+    size_t DecodeBlocksScalar(const char*, size_t, uint8_t*) {
+        return 0;
+    }
+
+#ifdef BASE64_X86
+
+    // ---------------- SSSE3 ----------------
+    // 编码：12 字节 -> 16 字符；pshufb 把每 3 字节展开到一个 32 位字，乘法移位得到 4 个 6 位索引，
+    // 再按索引区间查表得到 ASCII 偏移 (W. Muła 的算法)
+    BASE64_TARGET("ssse3")
+    BASE64_INLINE __m128i EncodeLookup128(__m128i indices) {
+        __m128i result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        const __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+        result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+        const __m128i shift = _mm_setr_epi8(
+            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+        result = _mm_shuffle_epi8(shift, result);
+        return _mm_add_epi8(result, indices);
+    }
+
+    BASE64_TARGET("ssse3")
+    BASE64_INLINE size_t EncodeLoop128(const uint8_t* src, size_t size, size_t readable, char* dst) {
+        const __m128i spread = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+        size_t i = 0;
+        for (; i + 12 <= size && i + 16 <= readable; i += 12, dst += 16) {
+            __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            in = _mm_shuffle_epi8(in, spread);
+            const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+            const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+            const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+            const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), EncodeLookup128(_mm_or_si128(t1, t3)));
+        }
+        return i;
+    }
+
+    BASE64_TARGET("ssse3")
+    size_t EncodeBlocksSsse3(const uint8_t* src, size_t size, size_t readable, char* dst) {
+        return EncodeLoop128(src, size, readable, dst);
+    }
+
+    // 解码：16 字符 -> 12 字节；按高/低半字节查表同时完成校验和字符到 6 位值的转换，
+    // 再用 pmaddubsw/pmaddwd 拼接位 (W. Muła / A. Klomp 的算法)
+    BASE64_TARGET("ssse3")
+    BASE64_INLINE size_t DecodeLoop128(const char* src, size_t size, uint8_t* dst) {
+        const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+            0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+        const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+        const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m128i mask2F = _mm_set1_epi8(0x2F);
+        const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+        const __m128i zero = _mm_setzero_si128();
+
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16, dst += 12) {
+            __m128i str = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            const __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(str, 4), mask2F);
+            const __m128i loNibbles = _mm_and_si128(str, mask2F);
+            const __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+            const __m128i lo = _mm_shuffle_epi8(lutLo, loNibbles);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), zero)) != 0xFFFF) {
+                break; // 含非法字符 (包括 '=' 和换行)，交给标量处理
+            }
+            const __m128i eq2F = _mm_cmpeq_epi8(str, mask2F);
+            const __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(eq2F, hiNibbles));
+            str = _mm_add_epi8(str, roll);
+
+            const __m128i merged = _mm_maddubs_epi16(str, _mm_set1_epi32(0x01400140));
+            __m128i out = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+            out = _mm_shuffle_epi8(out, pack);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), out);
+        }
+        return i;
+    }
+
+    BASE64_TARGET("ssse3")
+    size_t DecodeBlocksSsse3(const char* src, size_t size, uint8_t* dst) {
+        return DecodeLoop128(src, size, dst);
+    }
+
+    // ---------------- AVX2 ----------------
+    // 与 SSSE3 相同的算法，每个 128 位通道独立处理 12 字节 / 16 字符
+    BASE64_TARGET("avx2")
+    BASE64_INLINE __m256i EncodeLookup256(__m256i indices) {
+        __m256i result = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        const __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+        result = _mm256_or_si256(result, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+        const __m256i shift = _mm256_setr_epi8(
+            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+        result = _mm256_shuffle_epi8(shift, result);
+        return _mm256_add_epi8(result, indices);
+    }
+
+    BASE64_TARGET("avx2")
+    size_t EncodeBlocksAvx2(const uint8_t* src, size_t size, size_t readable, char* dst) {
+        const __m256i spread = _mm256_setr_epi8(
+            1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+            1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+        size_t i = 0;
+        for (; i + 24 <= size && i + 28 <= readable; i += 24, dst += 32) {
+            // 低通道取 src[i..i+11]，高通道取 src[i+12..i+23]
+            const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 12));
+            __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+            in = _mm256_shuffle_epi8(in, spread);
+            const __m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+            const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+            const __m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+            const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), EncodeLookup256(_mm256_or_si256(t1, t3)));
+        }
+        return i + EncodeLoop128(src + i, size - i, readable - i, dst);
+    }
+
+    BASE64_TARGET("avx2")
+    size_t DecodeBlocksAvx2(const char* src, size_t size, uint8_t* dst) {
+        const __m256i lutLo = _mm256_setr_epi8(
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+        const __m256i lutHi = _mm256_setr_epi8(
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+        const __m256i lutRoll = _mm256_setr_epi8(
+            0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+            0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m256i mask2F = _mm256_set1_epi8(0x2F);
+        const __m256i pack = _mm256_setr_epi8(
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+        const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+        const __m256i zero = _mm256_setzero_si256();
+
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32, dst += 24) {
+            __m256i str = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            const __m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4), mask2F);
+            const __m256i loNibbles = _mm256_and_si256(str, mask2F);
+            const __m256i hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+            const __m256i lo = _mm256_shuffle_epi8(lutLo, loNibbles);
+            if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(lo, hi), zero)) != -1) {
+                break;
+            }
+            const __m256i eq2F = _mm256_cmpeq_epi8(str, mask2F);
+            const __m256i roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(eq2F, hiNibbles));
+            str = _mm256_add_epi8(str, roll);
+
+            const __m256i merged = _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+            __m256i out = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+            out = _mm256_shuffle_epi8(out, pack);
+            out = _mm256_permutevar8x32_epi32(out, lanes); // 两个通道的 12 字节拼成连续的 24 字节
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), out);
+        }
+        return i + DecodeLoop128(src + i, size - i, dst);
+    }
+
+    // ---------------- CPU 检测 ----------------
+    void CpuId(int leaf, int subLeaf, unsigned int regs[4]) {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuidex(info, leaf, subLeaf);
+        for (int i = 0; i < 4; ++i) {
+            regs[i] = static_cast<unsigned int>(info[i]);
+        }
+#else
+        __cpuid_count(leaf, subLeaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    }
+
+    // 操作系统是否保存 YMM 寄存器 (XCR0 的 SSE 与 AVX 位)
+    bool OsSupportsAvx() {
+#if defined(_MSC_VER)
+        return (_xgetbv(0) & 6) == 6;
+#else
+        unsigned int lo = 0;
+        unsigned int hi = 0;
+        __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+        return (lo & 6) == 6;
+#endif
+    }
+
+    bool CpuSupports(Base64::Kernel kernel) {
+        unsigned int regs[4] = { 0, 0, 0, 0 };
+        CpuId(0, 0, regs);
+        const unsigned int maxLeaf = regs[0];
+
+        CpuId(1, 0, regs);
+        const bool ssse3 = (regs[2] & (1u << 9)) != 0;
+        const bool osxsave = (regs[2] & (1u << 27)) != 0;
+        if (kernel == Base64::Kernel::Ssse3) {
+            return ssse3;
+        }
+        if (kernel == Base64::Kernel::Avx2) {
+            if (!ssse3 || !osxsave || maxLeaf < 7 || !OsSupportsAvx()) {
+                return false;
+            }
+            CpuId(7, 0, regs);
+            return (regs[1] & (1u << 5)) != 0;
+        }
+        return true;
+    }
+
+#else
+
+    bool CpuSupports(Base64::Kernel kernel) {
+        return kernel == Base64::Kernel::Scalar;
+    }
+
+#endif
+
+    // ---------------- 分派 ----------------
+    Base64::Kernel DetectKernel() {
+        if (CpuSupports(Base64::Kernel::Avx2)) {
+            return Base64::Kernel::Avx2;
+        }
+        if (CpuSupports(Base64::Kernel::Ssse3)) {
+            return Base64::Kernel::Ssse3;
+        }
+        return Base64::Kernel::Scalar;
+    }
+
+    std::atomic<Base64::Kernel>& CurrentKernel() {
+        static std::atomic<Base64::Kernel> kernel(DetectKernel());
+        return kernel;
+    }
+
+    EncodeBlocksFn EncodeBlocksFor(Base64::Kernel kernel) {
+#ifdef BASE64_X86
+        if (kernel == Base64::Kernel::Avx2) {
+            return EncodeBlocksAvx2;
+        }
+        if (kernel == Base64::Kernel::Ssse3) {
+            return EncodeBlocksSsse3;
+        }
+#endif
+        (void)kernel;
+        return EncodeBlocksScalar;
+    }
+
+    DecodeBlocksFn DecodeBlocksFor(Base64::Kernel kernel) {
+#ifdef BASE64_X86
+        if (kernel == Base64::Kernel::Avx2) {
+            return DecodeBlocksAvx2;
+        }
+        if (kernel == Base64::Kernel::Ssse3) {
+            return DecodeBlocksSsse3;
+        }
+#endif
+        (void)kernel;
+        return DecodeBlocksScalar;
+    }
+
+    // 编码一段数据 (含末尾填充)：先批量处理，剩余部分用标量；返回写出的字符数
+    size_t EncodeChunk(EncodeBlocksFn blocks, const uint8_t* src, size_t size, size_t readable, char* dst) {
+        const size_t done = blocks(src, size, readable, dst);
+        char* out = dst + done / 3 * 4;
+
+        size_t i = done;
+        for (; i + 3 <= size; i += 3) {
+            const uint32_t v = (static_cast<uint32_t>(src[i]) << 16) |
+                (static_cast<uint32_t>(src[i + 1]) << 8) | src[i + 2];
+            out[0] = ENCODE_TABLE[(v >> 18) & 0x3F];
+            out[1] = ENCODE_TABLE[(v >> 12) & 0x3F];
+            out[2] = ENCODE_TABLE[(v >> 6) & 0x3F];
+            out[3] = ENCODE_TABLE[v & 0x3F];
+            out += 4;
+        }
+
+        if (i < size) {
+            uint32_t v = static_cast<uint32_t>(src[i]) << 16;
+            const bool twoBytes = (i + 1 < size);
+            if (twoBytes) {
+                v |= static_cast<uint32_t>(src[i + 1]) << 8;
+            }
+            out[0] = ENCODE_TABLE[(v >> 18) & 0x3F];
+            out[1] = ENCODE_TABLE[(v >> 12) & 0x3F];
+            out[2] = twoBytes ? ENCODE_TABLE[(v >> 6) & 0x3F] : '=';
+            out[3] = '=';
+            out += 4;
+        }
+
+        return static_cast<size_t>(out - dst);
+    }
+}
+
+namespace Base64 {
+
+    Kernel ActiveKernel() {
+        return CurrentKernel().load(std::memory_order_relaxed);
+    }
+
+    const char* KernelName(Kernel kernel) {
+        switch (kernel) {
+        case Kernel::Avx2:
+            return "AVX2";
+        case Kernel::Ssse3:
+            return "SSSE3";
+        default:
+            return "Scalar";
+        }
+    }
+
+    bool SelectKernel(Kernel kernel) {
+        if (!CpuSupports(kernel)) {
+            return false;
+        }
+        CurrentKernel().store(kernel, std::memory_order_relaxed);
+        return true;
+    }
+
+    size_t EncodedLength(size_t size) {
+        return (size + 2) / 3 * 4;
+    }
+
+    void EncodeTo(const void* data, size_t size, std::string& out) {
+        const size_t start = out.size();
+        out.resize(start + EncodedLength(size));
+        EncodeChunk(EncodeBlocksFor(ActiveKernel()), static_cast<const uint8_t*>(data), size, size, &out[start]);
+    }
+
+    std::string Encode(const std::string& data) {
+        std::string out;
+        EncodeTo(data.data(), data.size(), out);
+        return out;
+    }
+
+    // 逐行编码：每行 lineLength / 4 * 3 个字节，编码后直接写入 CRLF，不需要先编码再拆行
+    void EncodeLinesTo(const void* data, size_t size, std::string& out, size_t lineLength) {
+        const size_t lineChars = (lineLength < 4) ? 4 : lineLength / 4 * 4;
+        const size_t lineBytes = lineChars / 4 * 3;
+        const size_t lines = (size + lineBytes - 1) / lineBytes;
+
+        const size_t start = out.size();
+        out.resize(start + EncodedLength(size) + lines * 2);
+
+        const EncodeBlocksFn blocks = EncodeBlocksFor(ActiveKernel());
+        const uint8_t* src = static_cast<const uint8_t*>(data);
+        char* dst = &out[start];
+        for (size_t offset = 0; offset < size; offset += lineBytes) {
+            const size_t n = (size - offset < lineBytes) ? (size - offset) : lineBytes;
+            // 批量编码可以读到行尾之后 (readable 为剩余全部数据)，但只编码本行
+            dst += EncodeChunk(blocks, src + offset, n, size - offset, dst);
+            dst[0] = '\r';
+            dst[1] = '\n';
+            dst += 2;
+        }
+    }
+
+    void WrapLinesTo(const char* text, size_t size, std::string& out, size_t lineLength) {
+        if (lineLength == 0) {
+            lineLength = 76;
+        }
+        const size_t lines = (size + lineLength - 1) / lineLength;
+        out.reserve(out.size() + size + lines * 2);
+        for (size_t i = 0; i < size; i += lineLength) {
+            const size_t n = (size - i < lineLength) ? (size - i) : lineLength;
+            out.append(text + i, n);
+            out.append("\r\n", 2);
+        }
+    }
+
+    // 批量解码遇到非法字符 (换行、'=' 等) 后由标量逐个处理；凑满 4 个字符后再回到批量解码，
+    // 因此按 76 字符换行的 MIME 文本每行都能走 SIMD
+    bool DecodeTo(const char* text, size_t size, std::string& out, DecodeMode mode) {
+        const bool strict = (mode == DecodeMode::Strict);
+        if (strict && size % 4 != 0) {
+            return false;
+        }
+
+        const size_t start = out.size();
+        out.resize(start + size / 4 * 3 + 3 + DECODE_SLACK);
+
+        const DecodeBlocksFn blocks = DecodeBlocksFor(ActiveKernel());
+        uint8_t* const begin = reinterpret_cast<uint8_t*>(&out[start]);
+        uint8_t* dst = begin;
+
+        uint8_t quad[4];
+        int pending = 0;
+        size_t pos = 0;
+        bool padded = false;
+
+        while (pos < size) {
+            if (pending == 0) {
+                const size_t done = blocks(text + pos, size - pos, dst);
+                pos += done;
+                dst += done / 4 * 3;
+                if (pos >= size) {
+                    break;
+                }
+            }
+
+            const unsigned char c = static_cast<unsigned char>(text[pos]);
+            const uint8_t v = DECODE_TABLE.value[c];
+            if (v != INVALID) {
+                quad[pending++] = v;
+                ++pos;
+                if (pending == 4) {
+                    dst[0] = static_cast<uint8_t>((quad[0] << 2) | (quad[1] >> 4));
+                    dst[1] = static_cast<uint8_t>((quad[1] << 4) | (quad[2] >> 2));
+                    dst[2] = static_cast<uint8_t>((quad[2] << 6) | quad[3]);
+                    dst += 3;
+                    pending = 0;
+                }
+            }
+            else if (c == '=') {
+                padded = true;
+                break;
+            }
+            else if (strict) {
+                out.resize(start);
+                return false;
+            }
+            else {
+                ++pos; // 宽松模式跳过空白等字符
+            }
+        }
+
+        if (strict && padded) {
+            // 末尾只能是补齐最后一组的 '='
+            const size_t padding = size - pos;
+            bool valid = (pending == 2 && padding == 2) || (pending == 3 && padding == 1);
+            for (size_t i = pos; valid && i < size; ++i) {
+                valid = (text[i] == '=');
+            }
+            if (!valid) {
+                out.resize(start);
+                return false;
+            }
+        }
+
+        if (pending == 1 && strict) {
+            out.resize(start);
+            return false;
+        }
+        if (pending >= 2) {
+            *dst++ = static_cast<uint8_t>((quad[0] << 2) | (quad[1] >> 4));
+        }
+        if (pending == 3) {
+            *dst++ = static_cast<uint8_t>((quad[1] << 4) | (quad[2] >> 2));
+        }
+
+        out.resize(start + static_cast<size_t>(dst - begin));
+        return true;
+    }
+
+    std::string Decode(const std::string& text) {
+        std::string out;
+        DecodeTo(text.data(), text.size(), out, DecodeMode::Lenient);
+        return out;
+    }
+}
@@ -0,0 +1,212 @@
+﻿// ProfiledMutex.cpp
+#include "ProfiledMutex.h"
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+class LockProfile {
+public:
+    explicit LockProfile(const std::string& name) : name_(name) {
+        for (int i = 0; i < LOCK_PROFILE_BUCKETS; ++i) {
+            waitHistogram_[i].store(0, std::memory_order_relaxed);
+            holdHistogram_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void RecordAcquire() {
+        acquisitions_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void RecordWait(uint64_t micros) {
+        contended_.fetch_add(1, std::memory_order_relaxed);
+        waitMicrosTotal_.fetch_add(micros, std::memory_order_relaxed);
+        UpdateMax(waitMicrosMax_, micros);
+        waitHistogram_[Bucket(micros)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void RecordHold(uint64_t micros) {
+        holdSamples_.fetch_add(1, std::memory_order_relaxed);
+        holdMicrosTotal_.fetch_add(micros, std::memory_order_relaxed);
+        UpdateMax(holdMicrosMax_, micros);
+        holdHistogram_[Bucket(micros)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    LockProfileSnapshot Snapshot() const {
+        LockProfileSnapshot s{};
+        s.name = name_;
+        s.acquisitions = acquisitions_.load(std::memory_order_relaxed);
+        s.contended = contended_.load(std::memory_order_relaxed);
+        s.waitMicrosTotal = waitMicrosTotal_.load(std::memory_order_relaxed);
+        s.waitMicrosMax = waitMicrosMax_.load(std::memory_order_relaxed);
+        s.holdSamples = holdSamples_.load(std::memory_order_relaxed);
+        s.holdMicrosTotal = holdMicrosTotal_.load(std::memory_order_relaxed);
+        s.holdMicrosMax = holdMicrosMax_.load(std::memory_order_relaxed);
+        for (int i = 0; i < LOCK_PROFILE_BUCKETS; ++i) {
+            s.waitHistogram[i] = waitHistogram_[i].load(std::memory_order_relaxed);
+            s.holdHistogram[i] = holdHistogram_[i].load(std::memory_order_relaxed);
+        }
+        return s;
+    }
+
+private:
+    static int Bucket(uint64_t micros) {
+        int bucket = 0;
+        while (bucket < LOCK_PROFILE_BUCKETS - 1 && micros >= (1ull << bucket)) {
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    static void UpdateMax(std::atomic<uint64_t>& target, uint64_t value) {
+        uint64_t current = target.load(std::memory_order_relaxed);
+        while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    std::string name_;
+    std::atomic<uint64_t> acquisitions_{ 0 };
+    std::atomic<uint64_t> contended_{ 0 };
+    std::atomic<uint64_t> waitMicrosTotal_{ 0 };
+    std::atomic<uint64_t> waitMicrosMax_{ 0 };
+    std::atomic<uint64_t> waitHistogram_[LOCK_PROFILE_BUCKETS];
+    std::atomic<uint64_t> holdSamples_{ 0 };
+    std::atomic<uint64_t> holdMicrosTotal_{ 0 };
+    std::atomic<uint64_t> holdMicrosMax_{ 0 };
+    std::atomic<uint64_t> holdHistogram_[LOCK_PROFILE_BUCKETS];
+};
+
+namespace {
+    // 锁名 -> 统计。有意泄漏：静态析构阶段仍可能有锁被使用
+    struct ProfileRegistry {
+        std::mutex mutex;
+        std::map<std::string, LockProfile*> profiles;
+    };
+
+    ProfileRegistry& Registry() {
+        static ProfileRegistry* registry = new ProfileRegistry();
+        return *registry;
+    }
+
+    LockProfile* FindOrCreateProfile(const char* name) {
+        ProfileRegistry& registry = Registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        LockProfile*& profile = registry.profiles[name ? name : "unnamed"];
+        if (!profile) {
+            profile = new LockProfile(name ? name : "unnamed");
+        }
+        return profile;
+    }
+
+    uint64_t MicrosSince(std::chrono::steady_clock::time_point start) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+
+    // 分位数写作 "<上界"；落在溢出桶时写作 ">=溢出桶下界"
+    void AppendPercentile(std::ostringstream& out, const uint64_t (&histogram)[LOCK_PROFILE_BUCKETS], double quantile) {
+        const uint64_t bound = LockProfiler::Percentile(histogram, quantile);
+        if (bound == UINT64_MAX) {
+            out << ">=" << (1ull << (LOCK_PROFILE_BUCKETS - 2));
+        } else {
+            out << "<" << bound;
+        }
+    }
+}
+
+ProfiledMutex::ProfiledMutex(const char* name)
+    : profile_(FindOrCreateProfile(name)), acquireCounter_(0), holdSampled_(false) {
+}
+
+void ProfiledMutex::lock() {
+    if (mutex_.try_lock()) {
+        OnAcquired(false);
+        return;
+    }
+    auto waitStart = std::chrono::steady_clock::now();
+    mutex_.lock();
+    profile_->RecordWait(MicrosSince(waitStart));
+    OnAcquired(true);
+}
+
+bool ProfiledMutex::try_lock() {
+    if (!mutex_.try_lock()) {
+        return false;
+    }
+    OnAcquired(false);
+    return true;
+}
+
+void ProfiledMutex::OnAcquired(bool sampleHold) {
+    profile_->RecordAcquire();
+    // 竞争过的锁总是记录持有时间，其余按周期采样，避免无竞争时每次读取时钟
+    holdSampled_ = sampleHold || (++acquireCounter_ % HOLD_SAMPLE_PERIOD) == 0;
+    if (holdSampled_) {
+        holdStart_ = std::chrono::steady_clock::now();
+    }
+}
+
+void ProfiledMutex::unlock() {
+    if (holdSampled_) {
+        profile_->RecordHold(MicrosSince(holdStart_));
+        holdSampled_ = false;
+    }
+    mutex_.unlock();
+}
+
+namespace LockProfiler {
+    std::vector<LockProfileSnapshot> Snapshot() {
+        std::vector<LockProfileSnapshot> result;
+        {
+            ProfileRegistry& registry = Registry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            for (const auto& kv : registry.profiles) {
+                result.push_back(kv.second->Snapshot());
+            }
+        }
+        std::sort(result.begin(), result.end(), [](const LockProfileSnapshot& a, const LockProfileSnapshot& b) {
+            return a.waitMicrosTotal > b.waitMicrosTotal;
+        });
+        return result;
+    }
+
+    uint64_t Percentile(const uint64_t (&histogram)[LOCK_PROFILE_BUCKETS], double quantile) {
+        uint64_t total = 0;
+        for (int i = 0; i < LOCK_PROFILE_BUCKETS; ++i) {
+            total += histogram[i];
+        }
+        if (total == 0) {
+            return 0;
+        }
+        const uint64_t target = static_cast<uint64_t>(quantile * static_cast<double>(total - 1)) + 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < LOCK_PROFILE_BUCKETS; ++i) {
+            seen += histogram[i];
+            if (seen >= target) {
+                return (i < LOCK_PROFILE_BUCKETS - 1) ? (1ull << i) : UINT64_MAX;
+            }
+        }
+        return UINT64_MAX;
+    }
+
+    std::string Report() {
+        std::ostringstream out;
+        out << "Lock contention report (us)\n";
+        for (const auto& s : Snapshot()) {
+            const double contentionRate = s.acquisitions > 0 ? 100.0 * s.contended / s.acquisitions : 0.0;
+            const uint64_t holdAvg = s.holdSamples > 0 ? s.holdMicrosTotal / s.holdSamples : 0;
+            out << s.name
+                << ": acquisitions=" << s.acquisitions
+                << " contended=" << s.contended << " (" << contentionRate << "%)"
+                << " wait_total=" << s.waitMicrosTotal
+                << " wait_max=" << s.waitMicrosMax
+                << " wait_p99";
+            AppendPercentile(out, s.waitHistogram, 0.99);
+            out << " hold_avg=" << holdAvg
+                << " hold_max=" << s.holdMicrosMax
+                << " hold_p99";
+            AppendPercentile(out, s.holdHistogram, 0.99);
+            out << "\n";
+        }
+        return out.str();
+    }
+}
@@ -0,0 +1,296 @@
+﻿// 群发并发基准测试
+// 在本进程内启动一个模拟 SMTP 服务器（每次回复前固定延迟，模拟网络往返），
+// 用不同的工作线程数调用 SendBulkMailsTo，再用单线程的 AsyncSmtpClient 驱动不同数量的并发连接，
+// 输出耗时与吞吐量。
+//
+// 用法：EmailModule_Bench [收件人数=400] [响应延迟毫秒=5] [pipelining=0]
+// 需要与 EmailModule_Core 中除 EmailModule_Core.cpp 以外的源文件一起编译。
+#include "AsyncSmtpClient.h"
+#include "BulkSender.h"
+#include "Config.h"
+#include "EmailMessage.h"
+
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#pragma comment(lib, "Ws2_32.lib")
+
+namespace
+{
+    // --- 模拟 SMTP 服务器：每个连接一个线程，接受所有收件人 ---
+    class FakeSmtpServer
+    {
+    public:
+        FakeSmtpServer(int replyDelayMs, bool pipelining)
+            : listen_(INVALID_SOCKET)
+            , port_(0)
+            , delayMs_(replyDelayMs)
+            , pipelining_(pipelining)
+            , stopping_(false)
+            , messages_(0)
+        {
+        }
+
+        ~FakeSmtpServer()
+        {
+            Stop();
+        }
+
+        bool Start()
+        {
+            listen_ = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            if (listen_ == INVALID_SOCKET)
+                return false;
+
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = 0; // 由系统分配端口
+            ::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+            int addrLen = static_cast<int>(sizeof(addr));
+            if (::bind(listen_, reinterpret_cast<sockaddr*>(&addr), addrLen) == SOCKET_ERROR ||
+                ::listen(listen_, SOMAXCONN) == SOCKET_ERROR ||
+                ::getsockname(listen_, reinterpret_cast<sockaddr*>(&addr), reinterpret_cast<socklen_t*>(&addrLen)) == SOCKET_ERROR)
+            {
+                return false;
+            }
+            port_ = ntohs(addr.sin_port);
+
+            acceptThread_ = std::thread([this]() { AcceptLoop(); });
+            return true;
+        }
+
+        void Stop()
+        {
+            if (stopping_.exchange(true))
+                return;
+            ::shutdown(listen_, SD_BOTH);
+            ::closesocket(listen_);
+            if (acceptThread_.joinable())
+                acceptThread_.join();
+            for (auto& t : sessions_)
+            {
+                if (t.joinable())
+                    t.join();
+            }
+        }
+
+        int Port() const { return port_; }
+        int Messages() const { return messages_.load(); }
+
+    private:
+        void AcceptLoop()
+        {
+            while (!stopping_.load())
+            {
+                SOCKET s = ::accept(listen_, nullptr, nullptr);
+                if (s == INVALID_SOCKET)
+                    break;
+                sessions_.emplace_back([this, s]() { Serve(s); });
+            }
+        }
+
+        // 一次收到的全部命令（流水线时为一组）的响应合并发送，只计一次延迟
+        void Reply(SOCKET s, const std::string& text)
+        {
+            if (text.empty())
+                return;
+            if (delayMs_ > 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(delayMs_));
+            ::send(s, text.c_str(), static_cast<int>(text.size()), 0);
+        }
+
+        void Serve(SOCKET s)
+        {
+            std::string buffer;
+            bool        inData = false;
+            char        buf[4096];
+
+            Reply(s, "220 bench ESMTP\r\n");
+            while (true)
+            {
+                int n = ::recv(s, buf, sizeof(buf), 0);
+                if (n <= 0)
+                    break;
+                buffer.append(buf, n);
+
+                std::string out;
+                size_t      pos = 0;
+                while (true)
+                {
+                    if (inData)
+                    {
+                        size_t end = buffer.find("\r\n.\r\n", pos);
+                        if (end == std::string::npos)
+                            break;
+                        pos = end + 5;
+                        inData = false;
+                        ++messages_;
+                        out += "250 queued\r\n";
+                        continue;
+                    }
+
+                    size_t eol = buffer.find("\r\n", pos);
+                    if (eol == std::string::npos)
+                        break;
+                    std::string cmd = buffer.substr(pos, eol - pos);
+                    pos = eol + 2;
+
+                    std::string verb = cmd.substr(0, 4);
+                    if (verb == "EHLO")
+                    {
+                        out += pipelining_ ? "250-bench\r\n250 PIPELINING\r\n" : "250 bench\r\n";
+                    }
+                    else if (verb == "DATA")
+                    {
+                        out += "354 go ahead\r\n";
+                        inData = true;
+                        // 正文以 "\r\n.\r\n" 结束，从 DATA 行的换行开始查找
+                        pos -= 2;
+                    }
+                    else if (verb == "QUIT")
+                    {
+                        Reply(s, out + "221 bye\r\n");
+                        ::closesocket(s);
+                        return;
+                    }
+                    else
+                    {
+                        out += "250 OK\r\n";
+                    }
+                }
+                buffer.erase(0, pos);
+                Reply(s, out);
+            }
+            ::closesocket(s);
+        }
+
+        SOCKET                   listen_;
+        int                      port_;
+        int                      delayMs_;
+        bool                     pipelining_;
+        std::atomic<bool>        stopping_;
+        std::atomic<int>         messages_;
+        std::thread              acceptThread_;
+        std::vector<std::thread> sessions_;
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    const int  recipientCount = (argc > 1) ? std::atoi(argv[1]) : 400;
+    const int  delayMs = (argc > 2) ? std::atoi(argv[2]) : 5;
+    const bool pipelining = (argc > 3) && std::atoi(argv[3]) != 0;
+
+    WSADATA wsaData{};
+    if (::WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+    {
+        std::cerr << "WSAStartup 失败" << std::endl;
+        return 1;
+    }
+
+    FakeSmtpServer server(delayMs, pipelining);
+    if (!server.Start())
+    {
+        std::cerr << "模拟 SMTP 服务器启动失败" << std::endl;
+        ::WSACleanup();
+        return 1;
+    }
+
+    // 每封正文都带序号，不会被合并为多收件人事务
+    std::vector<BulkRecipient> recipients;
+    for (int i = 0; i < recipientCount; ++i)
+    {
+        recipients.push_back({ "user" + std::to_string(i) + "@bench.test", "User" + std::to_string(i) });
+    }
+    const std::string templateText = "你好，${name}！这是第 ${index} 封基准测试邮件。";
+
+    std::cout << "收件人 " << recipientCount << "，响应延迟 " << delayMs << " ms，PIPELINING "
+        << (pipelining ? "开启" : "关闭") << "\n\n";
+    std::cout << std::left << std::setw(10) << "线程数" << std::setw(12) << "耗时(s)"
+        << std::setw(14) << "封/秒" << std::setw(10) << "加速比" << "连接数\n";
+
+    double baseline = 0.0;
+    for (int workers : { 1, 2, 4, 8 })
+    {
+        SmtpConfig cfg;
+        cfg.serverIp = "127.0.0.1";
+        cfg.port = server.Port();
+        cfg.fromAddress = "bench@bench.test";
+        cfg.workerThreads = workers;
+        cfg.maxConnectionsPerServer = workers;
+
+        BulkSendSummary summary;
+        std::string     err;
+        auto start = std::chrono::steady_clock::now();
+        SendBulkMailsTo(cfg, recipients, templateText, summary, err);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (workers == 1)
+            baseline = seconds;
+
+        std::cout << std::left << std::setw(10) << workers
+            << std::setw(12) << std::fixed << std::setprecision(3) << seconds
+            << std::setw(14) << std::setprecision(1) << (summary.success / seconds)
+            << std::setw(10) << std::setprecision(2) << (baseline / seconds)
+            << summary.connections;
+        if (summary.fail > 0)
+            std::cout << "  （失败 " << summary.fail << " 封：" << err << "）";
+        std::cout << "\n";
+    }
+
+    // 单线程事件循环：连接数增加时吞吐量应近似线性增长，直到服务器或本机成为瓶颈
+    std::cout << "\nAsyncSmtpClient（单线程事件循环）\n";
+    std::cout << std::left << std::setw(10) << "连接数" << std::setw(12) << "耗时(s)"
+        << std::setw(14) << "封/秒" << "失败\n";
+
+    const int asyncCount = recipientCount * 4;
+    for (int connections : { 1, 16, 64, 256 })
+    {
+        SmtpConfig cfg;
+        cfg.serverIp = "127.0.0.1";
+        cfg.port = server.Port();
+        cfg.fromAddress = "bench@bench.test";
+
+        AsyncSmtpClient client(cfg, connections);
+        int  success = 0;
+        int  fail = 0;
+        for (int i = 0; i < asyncCount; ++i)
+        {
+            SimpleEmail mail;
+            mail.to = "user" + std::to_string(i) + "@bench.test";
+            mail.subject = "基准测试 #" + std::to_string(i);
+            mail.body = "异步发送基准测试。";
+            std::string raw;
+            std::string buildErr;
+            if (!EmailMessageBuilder::Build(cfg, mail, raw, buildErr))
+            {
+                ++fail;
+                continue;
+            }
+            client.Submit({ mail.to }, raw,
+                [&](const AsyncSendResult& result) { result.ok ? ++success : ++fail; });
+        }
+
+        std::string err;
+        auto start = std::chrono::steady_clock::now();
+        client.Run(err);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << std::left << std::setw(10) << connections
+            << std::setw(12) << std::fixed << std::setprecision(3) << seconds
+            << std::setw(14) << std::setprecision(1) << (success / seconds)
+            << fail << "\n";
+    }
+
+    server.Stop();
+    ::WSACleanup();
+    return 0;
+}
@@ -0,0 +1,722 @@
+﻿#include "AsyncSmtpClient.h"
+#include "LineConnection.h"
+#include "SmtpDataEncoder.h"
+#include "Utils.h"
+
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <mutex>
+
+#pragma comment(lib, "Ws2_32.lib")
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // 421：服务器即将关闭传输通道（RFC 5321 3.8）
+    const int SMTP_SERVICE_CLOSING = 421;
+
+    // 事件循环的最长等待时间，用于及时发现新提交的邮件和 Stop 请求
+    const int MAX_POLL_WAIT_MS = 50;
+
+    bool WouldBlock(int ec)
+    {
+        return ec == WSAEWOULDBLOCK || ec == WSAEINPROGRESS;
+    }
+
+    // 连接的状态：当前在等待哪条命令的响应
+    enum class SessionState
+    {
+        Connecting,  // 非阻塞 connect 进行中
+        Greeting,    // 欢迎语
+        Ehlo,
+        AuthLogin,
+        AuthUser,
+        AuthPass,
+        Idle,        // 已就绪，没有待发送的邮件
+        MailFrom,
+        RcptTo,
+        Data,
+        Body,        // 正文已发送，等待 250
+        Reset,       // 事务被拒绝后的 RSET
+        Quit
+    };
+}
+
+// 一封待发送的邮件
+struct AsyncSmtpJob
+{
+    std::vector<std::string> recipients;
+    std::string              data;          // DATA 编码后的正文（含结束行）
+    AsyncSendCallback        callback;
+    int                      failures = 0;
+    bool                     staleRetried = false; // 复用的连接失效后已免费重发过一次
+};
+
+// 一个非阻塞连接及其状态机
+struct AsyncSmtpSession
+{
+    SOCKET                        socket = INVALID_SOCKET;
+    SessionState                  state = SessionState::Connecting;
+    std::string                   in;           // 已接收、尚未解析的数据
+    std::string                   out;          // 待发送的数据
+    std::string                   replyText;    // 多行响应已收到的部分
+    std::unique_ptr<AsyncSmtpJob> job;
+    size_t                        rcptIndex = 0;
+    size_t                        accepted = 0;
+    std::vector<SmtpRejectedRecipient> rejected;
+    std::string                   firstError;
+    int                           messageCount = 0;
+    Clock::time_point             deadline = Clock::time_point::max();
+    bool                          closed = false;
+};
+
+struct AsyncSmtpClient::Impl
+{
+    Impl(const SmtpConfig& c, int maxConn)
+        : cfg(c)
+        , maxConnections(maxConn > 0 ? maxConn : 1)
+        , stopRequested(false)
+    {
+    }
+
+    SmtpConfig cfg;
+    int        maxConnections;
+
+    std::mutex                                 submitMutex;
+    std::deque<std::unique_ptr<AsyncSmtpJob>>  submitted;   // 其他线程提交、尚未被事件循环取走
+    std::atomic<bool>                          stopRequested;
+
+    std::deque<std::unique_ptr<AsyncSmtpJob>>      pending; // 等待分配连接
+    std::vector<std::unique_ptr<AsyncSmtpSession>> sessions;
+
+    sockaddr_storage serverAddr{};
+    int              serverAddrLen = 0;
+
+    // ---------------- 邮件完成 / 重试 ----------------
+
+    void Finish(std::unique_ptr<AsyncSmtpJob> job, AsyncSendResult& result)
+    {
+        if (job->callback)
+        {
+            job->callback(result);
+        }
+    }
+
+    void FailJob(std::unique_ptr<AsyncSmtpJob> job, const std::string& errorMsg)
+    {
+        AsyncSendResult result;
+        result.ok = false;
+        result.errorMsg = errorMsg;
+        Finish(std::move(job), result);
+    }
+
+    // 按 cfg.maxRetry 重新排队或以失败结束；reused 表示失败发生在复用的连接上（可能已被服务器空闲关闭）
+    void RetryOrFail(std::unique_ptr<AsyncSmtpJob> job, const std::string& errorMsg, bool reused)
+    {
+        if (reused && !job->staleRetried)
+        {
+            // 直接在新连接上重发（原连接已关闭，连接数不会超过上限），避免再次落到另一条复用的连接上
+            job->staleRetried = true;
+            OpenSession(std::move(job));
+            return;
+        }
+
+        int maxAttempt = (cfg.maxRetry < 1) ? 1 : cfg.maxRetry;
+        if (++job->failures < maxAttempt)
+        {
+            pending.push_front(std::move(job));
+            return;
+        }
+
+        FailJob(std::move(job), (maxAttempt > 1)
+            ? "尝试发送邮件 " + std::to_string(maxAttempt) + " 次仍失败。最后一次错误: " + errorMsg
+            : errorMsg);
+    }
+
+    // ---------------- 连接 ----------------
+
+    void Touch(AsyncSmtpSession& s)
+    {
+        s.deadline = (cfg.ioTimeoutMs > 0)
+            ? Clock::now() + std::chrono::milliseconds(cfg.ioTimeoutMs)
+            : Clock::time_point::max();
+    }
+
+    void CloseSocket(AsyncSmtpSession& s)
+    {
+        if (s.socket != INVALID_SOCKET)
+        {
+            ::closesocket(s.socket);
+            s.socket = INVALID_SOCKET;
+        }
+        s.closed = true;
+    }
+
+    // 连接级错误：关闭连接，正在发送的邮件重试或失败
+    void FailSession(AsyncSmtpSession& s, const std::string& errorMsg)
+    {
+        bool reused = s.messageCount > 0;
+        CloseSocket(s);
+        if (s.job)
+        {
+            RetryOrFail(std::move(s.job), errorMsg, reused);
+        }
+    }
+
+    // 为一封邮件建立新连接（非阻塞 connect）
+    void OpenSession(std::unique_ptr<AsyncSmtpJob> job)
+    {
+        std::unique_ptr<AsyncSmtpSession> s(new AsyncSmtpSession());
+        s->job = std::move(job);
+
+        s->socket = ::socket(serverAddr.ss_family, SOCK_STREAM, IPPROTO_TCP);
+        if (s->socket == INVALID_SOCKET)
+        {
+            FailSession(*s, "创建 socket 失败，错误码: " + std::to_string(::WSAGetLastError()));
+            return;
+        }
+
+        u_long nonBlocking = 1;
+        ::ioctlsocket(s->socket, FIONBIO, &nonBlocking);
+
+        Touch(*s);
+        if (::connect(s->socket, reinterpret_cast<const sockaddr*>(&serverAddr), serverAddrLen) == SOCKET_ERROR)
+        {
+            int ec = ::WSAGetLastError();
+            if (!WouldBlock(ec))
+            {
+                FailSession(*s, "无法连接到 SMTP 服务器，错误码: " + std::to_string(ec));
+                return;
+            }
+            s->state = SessionState::Connecting;
+        }
+        else
+        {
+            s->state = SessionState::Greeting;
+        }
+
+        sessions.push_back(std::move(s));
+    }
+
+    // ---------------- 发送 ----------------
+
+    // 尽量写出发送缓冲区；对端暂时不可写时留到下一次 POLLWRNORM
+    void Flush(AsyncSmtpSession& s)
+    {
+        while (!s.out.empty() && !s.closed)
+        {
+            int n = ::send(s.socket, s.out.data(), static_cast<int>(s.out.size()), 0);
+            if (n == SOCKET_ERROR)
+            {
+                int ec = ::WSAGetLastError();
+                if (!WouldBlock(ec))
+                {
+                    FailSession(s, "发送数据失败，错误码: " + std::to_string(ec));
+                }
+                return;
+            }
+            s.out.erase(0, static_cast<size_t>(n));
+            if (n > 0)
+                Touch(s);  // 数据仍在发出（对端在接收），不算超时
+        }
+    }
+
+    void SendLine(AsyncSmtpSession& s, const std::string& line, SessionState next)
+    {
+        s.out += line;
+        s.out += "\r\n";
+        s.state = next;
+        Touch(s);
+        Flush(s);
+    }
+
+    // 连接就绪后：取下一封邮件开始事务，没有邮件时空闲或 QUIT
+    void StartNext(AsyncSmtpSession& s)
+    {
+        if (cfg.maxMessagesPerConnection > 0 && s.messageCount >= cfg.maxMessagesPerConnection)
+        {
+            SendLine(s, "QUIT", SessionState::Quit);
+            return;
+        }
+
+        while (!s.job || s.job->recipients.empty())
+        {
+            if (s.job)
+            {
+                FailJob(std::move(s.job), "邮件没有收件人。");
+            }
+            if (pending.empty())
+            {
+                s.state = SessionState::Idle;
+                s.deadline = Clock::time_point::max();
+                return;
+            }
+            s.job = std::move(pending.front());
+            pending.pop_front();
+        }
+
+        s.rcptIndex = 0;
+        s.accepted = 0;
+        s.rejected.clear();
+        s.firstError.clear();
+        SendLine(s, "MAIL FROM:<" + cfg.fromAddress + ">", SessionState::MailFrom);
+    }
+
+    // 事务被拒绝：邮件按重试次数处理，连接 RSET 后继续使用
+    void RejectTransaction(AsyncSmtpSession& s, const std::string& errorMsg)
+    {
+        int maxAttempt = (cfg.maxRetry < 1) ? 1 : cfg.maxRetry;
+        if (++s.job->failures < maxAttempt)
+        {
+            pending.push_front(std::move(s.job));
+        }
+        else
+        {
+            AsyncSendResult result;
+            result.ok = false;
+            result.errorMsg = (maxAttempt > 1)
+                ? "尝试发送邮件 " + std::to_string(maxAttempt) + " 次仍失败。最后一次错误: " + errorMsg
+                : errorMsg;
+            result.rejected = std::move(s.rejected);
+            Finish(std::move(s.job), result);
+        }
+        SendLine(s, "RSET", SessionState::Reset);
+    }
+
+    // ---------------- 接收 ----------------
+
+    // 状态机：处理一条完整的响应
+    void HandleReply(AsyncSmtpSession& s, int code, const std::string& text)
+    {
+        const std::string reply = "SMTP 错误(" + std::to_string(code) + "): " + text;
+
+        if (s.state == SessionState::Quit)
+        {
+            CloseSocket(s);
+            return;
+        }
+        if (code == SMTP_SERVICE_CLOSING)
+        {
+            FailSession(s, reply);
+            return;
+        }
+
+        switch (s.state)
+        {
+        case SessionState::Greeting:
+            if (code / 100 != 2)
+                FailSession(s, "SMTP 服务器返回错误: " + text);
+            else
+                SendLine(s, "EHLO localhost", SessionState::Ehlo);
+            break;
+
+        case SessionState::Ehlo:
+            if (code / 100 != 2)
+                FailSession(s, reply);
+            else if (cfg.useAuth)
+                SendLine(s, "AUTH LOGIN", SessionState::AuthLogin);
+            else
+                StartNext(s);
+            break;
+
+        case SessionState::AuthLogin:
+            if (code / 100 != 3)
+                FailSession(s, reply);
+            else
+                SendLine(s, Base64Encode(cfg.username), SessionState::AuthUser);
+            break;
+
+        case SessionState::AuthUser:
+            if (code / 100 != 3)
+                FailSession(s, reply);
+            else
+                SendLine(s, Base64Encode(cfg.password), SessionState::AuthPass);
+            break;
+
+        case SessionState::AuthPass:
+            if (code / 100 != 2)
+                FailSession(s, reply);
+            else
+                StartNext(s);
+            break;
+
+        case SessionState::MailFrom:
+            if (code / 100 != 2)
+                RejectTransaction(s, reply);
+            else
+                SendLine(s, "RCPT TO:<" + s.job->recipients[0] + ">", SessionState::RcptTo);
+            break;
+
+        case SessionState::RcptTo:
+        {
+            const std::string& rcpt = s.job->recipients[s.rcptIndex];
+            if (code / 100 == 2)
+            {
+                ++s.accepted;
+            }
+            else
+            {
+                s.rejected.push_back({ rcpt, reply });
+                if (s.firstError.empty())
+                    s.firstError = "收件人 " + rcpt + " 被拒绝，" + reply;
+            }
+
+            if (++s.rcptIndex < s.job->recipients.size())
+                SendLine(s, "RCPT TO:<" + s.job->recipients[s.rcptIndex] + ">", SessionState::RcptTo);
+            else if (s.accepted == 0)
+                RejectTransaction(s, s.firstError);
+            else
+                SendLine(s, "DATA", SessionState::Data);
+            break;
+        }
+
+        case SessionState::Data:
+            if (code / 100 != 3)
+            {
+                RejectTransaction(s, reply);
+            }
+            else
+            {
+                s.out += s.job->data;
+                s.state = SessionState::Body;
+                Touch(s);
+                Flush(s);
+            }
+            break;
+
+        case SessionState::Body:
+        {
+            // DATA 结束后服务器已复位事务状态，不需要 RSET
+            if (code / 100 == 4)
+            {
+                // 暂时性失败（如 451 本地处理错误、452 存储不足）：按 cfg.maxRetry 重新排队，连接继续使用
+                RetryOrFail(std::move(s.job), "发送邮件失败: " + text, false);
+                StartNext(s);
+                break;
+            }
+            AsyncSendResult result;
+            result.ok = (code / 100 == 2);
+            result.errorMsg = result.ok ? std::string() : "发送邮件失败: " + text;
+            result.rejected = std::move(s.rejected);
+            if (result.ok)
+                ++s.messageCount;
+            Finish(std::move(s.job), result);
+            StartNext(s);
+            break;
+        }
+
+        case SessionState::Reset:
+            if (code / 100 != 2)
+                FailSession(s, reply);
+            else
+                StartNext(s);
+            break;
+
+        default:
+            // 没有在等待响应时收到的数据：协议错误
+            FailSession(s, "收到意外的 SMTP 响应: " + text);
+            break;
+        }
+    }
+
+    void OnReadable(AsyncSmtpSession& s)
+    {
+        char buf[4096];
+        bool peerClosed = false;
+        int  recvError = 0;
+        for (;;)
+        {
+            int n = ::recv(s.socket, buf, sizeof(buf), 0);
+            if (n == SOCKET_ERROR)
+            {
+                int ec = ::WSAGetLastError();
+                if (!WouldBlock(ec))
+                    recvError = ec;
+                break;
+            }
+            if (n == 0)
+            {
+                peerClosed = true;
+                break;
+            }
+            s.in.append(buf, n);
+        }
+
+        // 解析完整的响应行（多行响应读到最后一行 "250 ..." 才交给状态机）
+        size_t pos = 0;
+        size_t eol = 0;
+        while (!s.closed && (eol = s.in.find("\r\n", pos)) != std::string::npos)
+        {
+            std::string line = s.in.substr(pos, eol - pos);
+            pos = eol + 2;
+
+            s.replyText += line;
+            int code = ParseSmtpReplyCode(line);
+            if (code != 0 && line.size() > 3 && line[3] == '-')
+            {
+                s.replyText += "\r\n";
+                continue;
+            }
+
+            std::string text;
+            text.swap(s.replyText);
+            HandleReply(s, code, text);
+        }
+        s.in.erase(0, pos);
+
+        // 先处理关闭前收到的响应（如 421），再处理连接关闭
+        if (s.closed)
+            return;
+        if (recvError != 0)
+            FailSession(s, "接收数据失败，错误码: " + std::to_string(recvError));
+        else if (peerClosed && s.state == SessionState::Quit)
+            CloseSocket(s);
+        else if (peerClosed)
+            FailSession(s, "接收数据失败：服务器关闭连接。");
+    }
+
+    void OnWritable(AsyncSmtpSession& s)
+    {
+        if (s.state == SessionState::Connecting)
+        {
+            int       err = 0;
+            socklen_t len = static_cast<socklen_t>(sizeof(err));
+            ::getsockopt(s.socket, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&err), &len);
+            if (err != 0)
+            {
+                FailSession(s, "无法连接到 SMTP 服务器，错误码: " + std::to_string(err));
+                return;
+            }
+            s.state = SessionState::Greeting;
+            Touch(s);
+        }
+        Flush(s);
+    }
+
+    // ---------------- 事件循环 ----------------
+
+    bool Resolve(std::string& errorMsg)
+    {
+        struct addrinfo hints {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_protocol = IPPROTO_TCP;
+
+        struct addrinfo* result = nullptr;
+        int r = ::getaddrinfo(cfg.serverIp.c_str(), std::to_string(cfg.port).c_str(), &hints, &result);
+        if (r != 0 || result == nullptr)
+        {
+            errorMsg = "getaddrinfo 失败，错误码: " + std::to_string(r);
+            return false;
+        }
+        std::memcpy(&serverAddr, result->ai_addr, result->ai_addrlen);
+        serverAddrLen = static_cast<int>(result->ai_addrlen);
+        ::freeaddrinfo(result);
+        return true;
+    }
+
+    // 取走其他线程提交的邮件；返回 false 表示已没有任何待处理的邮件
+    bool CollectSubmitted()
+    {
+        std::lock_guard<std::mutex> lock(submitMutex);
+        while (!submitted.empty())
+        {
+            pending.push_back(std::move(submitted.front()));
+            submitted.pop_front();
+        }
+        return !pending.empty();
+    }
+
+    void FailEverything(const std::string& errorMsg)
+    {
+        // 按下标遍历并检查当前大小：FailJob 会执行回调，遍历期间不持有 sessions 的迭代器
+        for (size_t i = 0; i < sessions.size(); ++i)
+        {
+            AsyncSmtpSession& s = *sessions[i];
+            CloseSocket(s);
+            if (s.job)
+                FailJob(std::move(s.job), errorMsg);
+        }
+        sessions.clear();
+
+        CollectSubmitted();
+        while (!pending.empty())
+        {
+            std::unique_ptr<AsyncSmtpJob> job = std::move(pending.front());
+            pending.pop_front();
+            FailJob(std::move(job), errorMsg);
+        }
+    }
+
+    void Loop()
+    {
+        std::vector<WSAPOLLFD> fds;
+
+        while (!stopRequested.load())
+        {
+            bool haveWork = CollectSubmitted();
+
+            // 1. 待发送的邮件先分给空闲连接，再按上限建立新连接
+            //    StartNext 发送失败时会重试到新连接（OpenSession 向 sessions 追加），
+            //    因此按下标遍历进入本步骤时已有的连接，不使用可能失效的迭代器
+            const size_t existing = sessions.size();
+            for (size_t i = 0; i < existing; ++i)
+            {
+                if (pending.empty())
+                    break;
+                AsyncSmtpSession& s = *sessions[i];
+                if (!s.closed && s.state == SessionState::Idle)
+                    StartNext(s);
+            }
+            while (!pending.empty() && static_cast<int>(sessions.size()) < maxConnections)
+            {
+                std::unique_ptr<AsyncSmtpJob> job = std::move(pending.front());
+                pending.pop_front();
+                OpenSession(std::move(job));
+            }
+
+            // 2. 没有待发送的邮件时，空闲连接 QUIT
+            if (!haveWork)
+            {
+                const size_t sessionCount = sessions.size();
+                for (size_t i = 0; i < sessionCount; ++i)
+                {
+                    AsyncSmtpSession& s = *sessions[i];
+                    if (!s.closed && s.state == SessionState::Idle)
+                        SendLine(s, "QUIT", SessionState::Quit);
+                }
+            }
+
+            sessions.erase(std::remove_if(sessions.begin(), sessions.end(),
+                [](const std::unique_ptr<AsyncSmtpSession>& s) { return s->closed; }), sessions.end());
+
+            if (sessions.empty())
+            {
+                if (pending.empty() && !CollectSubmitted())
+                    return; // 全部完成
+                continue;
+            }
+
+            // 3. 等待读写事件，最长等到最近的超时时刻
+            Clock::time_point now = Clock::now();
+            Clock::time_point nearest = now + std::chrono::milliseconds(MAX_POLL_WAIT_MS);
+            fds.clear();
+            for (auto& s : sessions)
+            {
+                WSAPOLLFD fd{};
+                fd.fd = s->socket;
+                fd.events = POLLRDNORM;
+                if (s->state == SessionState::Connecting || !s->out.empty())
+                    fd.events |= POLLWRNORM;
+                fds.push_back(fd);
+                nearest = (std::min)(nearest, s->deadline);
+            }
+            int waitMs = static_cast<int>(std::max<long long>(0,
+                std::chrono::duration_cast<std::chrono::milliseconds>(nearest - now).count()));
+
+            int ready = ::WSAPoll(fds.data(), static_cast<unsigned long>(fds.size()), waitMs);
+            if (ready == SOCKET_ERROR)
+            {
+                FailEverything("WSAPoll 失败，错误码: " + std::to_string(::WSAGetLastError()));
+                return;
+            }
+
+            // 4. 处理事件（回调中可能提交新邮件，只追加到 submitted，不影响本轮遍历）
+            const size_t count = fds.size();
+            for (size_t i = 0; i < count; ++i)
+            {
+                AsyncSmtpSession& s = *sessions[i];
+                short revents = fds[i].revents;
+                if (s.closed || revents == 0)
+                    continue;
+
+                if (s.state == SessionState::Connecting && (revents & (POLLERR | POLLHUP)) != 0)
+                {
+                    FailSession(s, "无法连接到 SMTP 服务器。");
+                    continue;
+                }
+                if ((revents & POLLWRNORM) != 0)
+                    OnWritable(s);
+                if (!s.closed && (revents & (POLLRDNORM | POLLERR | POLLHUP)) != 0)
+                    OnReadable(s);
+            }
+
+            // 5. 超时
+            now = Clock::now();
+            for (size_t i = 0; i < count; ++i)
+            {
+                AsyncSmtpSession& s = *sessions[i];
+                if (!s.closed && now >= s.deadline)
+                {
+                    if (s.state == SessionState::Quit)
+                        CloseSocket(s);
+                    else
+                        FailSession(s, "等待 SMTP 服务器响应超时（" + std::to_string(cfg.ioTimeoutMs) + " ms）。");
+                }
+            }
+        }
+
+        FailEverything("异步发送已停止。");
+    }
+};
+
+AsyncSmtpClient::AsyncSmtpClient(const SmtpConfig& cfg, int maxConnections)
+    : impl_(new Impl(cfg, maxConnections))
+{
+}
+
+AsyncSmtpClient::~AsyncSmtpClient() = default;
+
+void AsyncSmtpClient::Submit(const std::vector<std::string>& recipients,
+    const std::string& rawEmail,
+    AsyncSendCallback callback)
+{
+    std::unique_ptr<AsyncSmtpJob> job(new AsyncSmtpJob());
+    job->recipients = recipients;
+    job->callback = std::move(callback);
+
+    // 编码为 DATA 传输格式（CRLF 规范化、点填充、结束行），发送时直接追加到输出缓冲区
+    job->data = SmtpDataEncoder::EncodeAll(rawEmail);
+
+    std::lock_guard<std::mutex> lock(impl_->submitMutex);
+    impl_->submitted.push_back(std::move(job));
+}
+
+bool AsyncSmtpClient::Run(std::string& errorMsg)
+{
+    impl_->stopRequested = false;
+
+    WSADATA wsaData{};
+    int r = ::WSAStartup(MAKEWORD(2, 2), &wsaData);
+    if (r != 0)
+    {
+        errorMsg = "WSAStartup 失败，错误码: " + std::to_string(r);
+        impl_->FailEverything(errorMsg);
+        return false;
+    }
+
+    bool ok = impl_->Resolve(errorMsg);
+    if (ok)
+    {
+        impl_->Loop();
+    }
+    else
+    {
+        impl_->FailEverything(errorMsg);
+    }
+
+    ::WSACleanup();
+    return ok;
+}
+
+void AsyncSmtpClient::Stop()
+{
+    impl_->stopRequested = true;
+}
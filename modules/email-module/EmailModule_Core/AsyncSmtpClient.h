@@ -0,0 +1,48 @@
+﻿#pragma once
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Config.h"
+#include "SmtpClient.h"
+
+// 异步发送一封邮件的结果
+struct AsyncSendResult
+{
+    bool        ok = false;
+    std::string errorMsg;
+    std::vector<SmtpRejectedRecipient> rejected; // 被拒绝的收件人（其余收件人已接收时 ok 仍为 true）
+};
+
+using AsyncSendCallback = std::function<void(const AsyncSendResult&)>;
+
+// 异步 SMTP 客户端：一个线程上的事件循环（WSAPoll）驱动大量非阻塞连接
+// - 每个连接是一个状态机：连接 → 欢迎语 → EHLO → [AUTH LOGIN] → (MAIL FROM → RCPT TO × N → DATA → 正文)* → QUIT
+// - 最多 maxConnections 个连接同时进行；连接空闲时直接取下一封待发送的邮件（单连接上限 cfg.maxMessagesPerConnection）
+// - 等待连接或响应超过 cfg.ioTimeoutMs 视为连接失效；连接失效、服务器返回 421 或正文结束后返回 4xx 时按 cfg.maxRetry 重试
+// - 完成回调在运行 Run 的线程中调用；需要多核时可以每个线程运行一个实例
+class AsyncSmtpClient
+{
+public:
+    AsyncSmtpClient(const SmtpConfig& cfg, int maxConnections);
+    ~AsyncSmtpClient();
+
+    AsyncSmtpClient(const AsyncSmtpClient&) = delete;
+    AsyncSmtpClient& operator=(const AsyncSmtpClient&) = delete;
+
+    // 提交一封邮件（可从任意线程或回调中调用）；rawEmail 由 EmailMessageBuilder 构造
+    void Submit(const std::vector<std::string>& recipients,
+        const std::string& rawEmail,
+        AsyncSendCallback callback);
+
+    // 在当前线程运行事件循环，直到已提交的邮件全部完成或调用 Stop
+    // 返回 false 表示无法开始（WinSock 初始化或服务器地址解析失败，已提交的邮件以失败回调结束）
+    bool Run(std::string& errorMsg);
+
+    // 让 Run 尽快返回（可从任意线程或回调中调用），未完成的邮件以失败回调结束
+    void Stop();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
@@ -0,0 +1,150 @@
+﻿#include "AttachmentCache.h"
+#include "MappedFile.h"
+
+#include <filesystem>
+
+namespace
+{
+    // Base64 每行 76 个字符（MIME）
+    const size_t BASE64_LINE_CHARS = 76;
+
+    // 读取文件的大小和修改时间
+    bool StatFile(const std::string& path, unsigned long long& size, long long& modifiedTime)
+    {
+        std::error_code ec;
+        const std::filesystem::path p(path);
+        size = static_cast<unsigned long long>(std::filesystem::file_size(p, ec));
+        if (ec)
+            return false;
+        modifiedTime = static_cast<long long>(std::filesystem::last_write_time(p, ec).time_since_epoch().count());
+        return !ec;
+    }
+
+    // 缓存键：weakly_canonical 规范化后的路径（Windows 上 "a\b.pdf" 与 "A/b.pdf" 得到同一个键），无法规范化时使用原路径
+    std::string CacheKey(const std::string& path)
+    {
+        std::error_code ec;
+        const std::filesystem::path canonical = std::filesystem::weakly_canonical(std::filesystem::path(path), ec);
+        return ec ? path : canonical.string();
+    }
+}
+
+AttachmentCache& AttachmentCache::Instance()
+{
+    static AttachmentCache instance;
+    return instance;
+}
+
+AttachmentCache::AttachmentCache(size_t maxBytes)
+    : maxBytes_(maxBytes)
+    , mapWindowBytes_(DEFAULT_MAP_WINDOW_BYTES)
+{
+}
+
+bool AttachmentCache::Get(const std::string& filePath, Buffer& encoded, std::string& errorMsg)
+{
+    unsigned long long fileSize = 0;
+    long long          modifiedTime = 0;
+    if (!StatFile(filePath, fileSize, modifiedTime))
+    {
+        errorMsg = "无法打开附件文件: " + filePath;
+        return false;
+    }
+
+    const std::string key = CacheKey(filePath);
+
+    // 1. 命中：文件未变化，移到 LRU 头部
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it != index_.end())
+        {
+            if (it->second->fileSize == fileSize && it->second->modifiedTime == modifiedTime)
+            {
+                lru_.splice(lru_.begin(), lru_, it->second);
+                encoded = it->second->encoded;
+                ++stats_.hits;
+                errorMsg.clear();
+                return true;
+            }
+
+            // 文件已变化，旧内容作废（仍在使用它的邮件不受影响）
+            stats_.bytes -= it->second->encoded->size();
+            lru_.erase(it->second);
+            index_.erase(it);
+        }
+        ++stats_.misses;
+    }
+
+    // 2. 未命中：在锁外映射文件并编码，不阻塞其他附件的查询
+    size_t windowBytes;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        windowBytes = mapWindowBytes_;
+    }
+
+    auto               buffer = std::make_shared<std::string>();
+    unsigned long long mappedSize = 0;
+    if (!EncodeFileBase64(filePath, BASE64_LINE_CHARS, windowBytes, *buffer, mappedSize, errorMsg))
+        return false;
+    if (mappedSize != fileSize)
+    {
+        errorMsg = "附件文件在读取过程中被修改: " + filePath;
+        return false;
+    }
+    encoded = buffer;
+
+    // 3. 放入缓存（并发编码同一文件时保留先放入的结果）
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (buffer->size() <= maxBytes_ && index_.find(key) == index_.end())
+    {
+        lru_.push_front(Entry{ key, fileSize, modifiedTime, encoded });
+        index_[key] = lru_.begin();
+        stats_.bytes += buffer->size();
+        EvictLocked();
+    }
+
+    errorMsg.clear();
+    return true;
+}
+
+void AttachmentCache::SetMaxBytes(size_t maxBytes)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    maxBytes_ = maxBytes;
+    EvictLocked();
+}
+
+void AttachmentCache::SetMapWindowBytes(size_t windowBytes)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    mapWindowBytes_ = windowBytes;
+}
+
+void AttachmentCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    lru_.clear();
+    index_.clear();
+    stats_.bytes = 0;
+}
+
+AttachmentCache::Stats AttachmentCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    stats.entries = lru_.size();
+    return stats;
+}
+
+void AttachmentCache::EvictLocked()
+{
+    while (stats_.bytes > maxBytes_ && !lru_.empty())
+    {
+        const Entry& victim = lru_.back();
+        stats_.bytes -= victim.encoded->size();
+        index_.erase(victim.path);
+        lru_.pop_back();
+        ++stats_.evictions;
+    }
+}
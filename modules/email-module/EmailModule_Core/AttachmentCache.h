@@ -0,0 +1,68 @@
+﻿#pragma once
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// 附件编码缓存：同一个附件文件只读取、编码一次，所有邮件共享同一份结果
+// - 内容为已按 76 字符加 CRLF 换行的 Base64，可直接作为 MIME 附件正文
+// - 以规范化后的文件路径为键（不同写法指向同一文件时只编码一次），文件大小或修改时间变化时重新编码
+// - 缓存内容不可修改，按引用计数共享：条目被淘汰后，仍在使用它的邮件不受影响
+// - 按最近最少使用淘汰，缓存总字节数不超过上限；单个超过上限的附件编码后直接返回，不进入缓存
+class AttachmentCache
+{
+public:
+    using Buffer = std::shared_ptr<const std::string>;
+
+    struct Stats
+    {
+        unsigned long long hits = 0;
+        unsigned long long misses = 0;
+        unsigned long long evictions = 0;
+        size_t             entries = 0;
+        size_t             bytes = 0;     // 缓存中编码结果的总字节数
+    };
+
+    static const size_t DEFAULT_MAX_BYTES = 256 * 1024 * 1024;
+
+    // 进程内共享的缓存（群发使用）
+    static AttachmentCache& Instance();
+
+    explicit AttachmentCache(size_t maxBytes = DEFAULT_MAX_BYTES);
+
+    AttachmentCache(const AttachmentCache&) = delete;
+    AttachmentCache& operator=(const AttachmentCache&) = delete;
+
+    // 取得文件的编码结果；缓存中没有或文件已变化时读取文件并编码
+    bool Get(const std::string& filePath, Buffer& encoded, std::string& errorMsg);
+
+    // 修改内存上限（立即按新上限淘汰），0 表示不缓存
+    void SetMaxBytes(size_t maxBytes);
+
+    // 编码时单个文件映射窗口的最大字节数（见 EncodeFileBase64）
+    void SetMapWindowBytes(size_t windowBytes);
+    void Clear();
+
+    Stats GetStats() const;
+
+private:
+    struct Entry
+    {
+        std::string        path;          // 缓存键（规范化后的路径）
+        unsigned long long fileSize;
+        long long          modifiedTime;
+        Buffer             encoded;
+    };
+
+    // 从尾部（最久未使用）淘汰，直到总字节数不超过上限；调用方持有 mutex_
+    void EvictLocked();
+
+    mutable std::mutex                                          mutex_;
+    std::list<Entry>                                            lru_;    // 头部为最近使用
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    size_t                                                      maxBytes_;
+    size_t                                                      mapWindowBytes_;
+    Stats                                                       stats_;
+};
@@ -1,8 +1,6 @@
 ﻿#include "AttachmentUtils.h"
-#include "Utils.h"
 
 #include <fstream>
-#include <sstream>
 #include <algorithm>
 
 // 从路径中提取文件名
@@ -55,12 +53,44 @@ static std::string GuessContentType(const std::string& fileName)
 }
 
 bool BuildAttachmentFromFile(
+    const std::string& filePath,
+    AttachmentInfo& out,
+    std::string& errorMsg,
+    std::size_t mapWindowBytes
+)
+{
+    // 1. 映射文件并直接编码（结果长度预先算出，只分配一次）
+    std::string        base64;
+    unsigned long long fileSize = 0;
+    if (!EncodeFileBase64(filePath, 0, mapWindowBytes, base64, fileSize, errorMsg))
+    {
+        return false;
+    }
+
+    // 2. 填充 AttachmentInfo
+    std::string fileName = ExtractFileName(filePath);
+    if (fileName.empty())
+    {
+        // 如果连文件名都解析不出，就用一个占位名字
+        fileName = "attachment.bin";
+    }
+
+    out.fileName = fileName;
+    out.contentType = GuessContentType(fileName);
+    out.base64Content = std::move(base64);
+    out.filePath.clear();
+    out.encodedLines.reset();
+
+    errorMsg.clear();
+    return true;
+}
+
+bool DescribeAttachmentFile(
     const std::string& filePath,
     AttachmentInfo& out,
     std::string& errorMsg
 )
 {
-    // 1. 打开文件（以二进制方式）
     std::ifstream ifs(filePath, std::ios::binary);
     if (!ifs.is_open())
     {
@@ -68,32 +98,46 @@ bool BuildAttachmentFromFile(
         return false;
     }
 
-    // 2. 读取整个文件内容到内存
-    std::ostringstream oss;
-    oss << ifs.rdbuf();
-
-    if (!ifs.good() && !ifs.eof())
+    std::string fileName = ExtractFileName(filePath);
+    if (fileName.empty())
     {
-        errorMsg = "读取附件文件时发生错误: " + filePath;
-        return false;
+        fileName = "attachment.bin";
     }
 
-    std::string fileData = oss.str();
+    out.fileName = fileName;
+    out.contentType = GuessContentType(fileName);
+    out.base64Content.clear();
+    out.filePath = filePath;
+    out.encodedLines.reset(); // encodedLines 优先于 filePath，复用的 AttachmentInfo 不能保留上一个附件的内容
+
+    errorMsg.clear();
+    return true;
+}
 
-    // 3. Base64 编码
-    std::string base64 = Base64Encode(fileData);
+bool BuildAttachmentFromCache(
+    const std::string& filePath,
+    AttachmentInfo& out,
+    std::string& errorMsg,
+    AttachmentCache& cache
+)
+{
+    AttachmentCache::Buffer encoded;
+    if (!cache.Get(filePath, encoded, errorMsg))
+    {
+        return false;
+    }
 
-    // 4. 填充 AttachmentInfo
     std::string fileName = ExtractFileName(filePath);
     if (fileName.empty())
     {
-        // 如果连文件名都解析不出，就用一个占位名字
         fileName = "attachment.bin";
     }
 
     out.fileName = fileName;
     out.contentType = GuessContentType(fileName);
-    out.base64Content = base64;
+    out.base64Content.clear();
+    out.filePath.clear();
+    out.encodedLines = encoded;
 
     errorMsg.clear();
     return true;
@@ -1,10 +1,12 @@
 ﻿#pragma once
 #include <string>
+#include "AttachmentCache.h"
 #include "EmailMessage.h"
+#include "MappedFile.h"
 
 // 从给定文件路径构造一个 AttachmentInfo：
-// - 读取整个文件内容
-// - 做 Base64 编码
+// - 只读映射文件，编码器直接读取映射区域（不把文件内容复制到内存）
+// - 做 Base64 编码；大于 mapWindowBytes 的文件按窗口逐段映射
 // - 根据路径推断文件名
 // - 根据扩展名推断一个大致的 Content-Type（仅简单匹配）
 //
@@ -12,7 +14,26 @@
 //   filePath : 要作为附件的文件路径
 //   out      : 输出的附件信息（fileName / contentType / base64Content）
 //   errorMsg : 出错时写入错误描述（例如“无法打开文件...”）
+//   mapWindowBytes : 单个映射窗口的最大字节数
 bool BuildAttachmentFromFile(
+    const std::string& filePath,
+    AttachmentInfo& out,
+    std::string& errorMsg,
+    std::size_t mapWindowBytes = DEFAULT_MAP_WINDOW_BYTES
+);
+
+// 从附件缓存取得文件的编码结果：填写 fileName / contentType / encodedLines。
+// 同一文件（路径、大小、修改时间均相同）只读取、编码一次，群发时所有邮件共享同一份内容。
+bool BuildAttachmentFromCache(
+    const std::string& filePath,
+    AttachmentInfo& out,
+    std::string& errorMsg,
+    AttachmentCache& cache = AttachmentCache::Instance()
+);
+
+// 只登记附件文件，不读取内容：填写 fileName / contentType / filePath，并确认文件可以打开。
+// 邮件发送时由 MimeMessageSource 分段读取并编码，适合大附件。
+bool DescribeAttachmentFile(
     const std::string& filePath,
     AttachmentInfo& out,
     std::string& errorMsg
@@ -1,154 +1,758 @@
 ﻿#include "BulkSender.h"
 
 #include "TemplateEngine.h"
+#include "RecipientCsv.h"
+#include "AttachmentUtils.h"
 #include "EmailMessage.h"
 #include "SmtpClient.h"
 #include "Logger.h"
 #include "Utils.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
+#include <mutex>
 #include <sstream>
+#include <thread>
 #include <vector>
+#include <functional>
 #include <map>
-#include <cctype>
+#include <memory>
 
 // 只在本文件内部使用的工具和数据结构
 namespace
 {
-    struct Recipient
+    // 从 mail_template.txt 读取整个模板文本
+    bool LoadMailTemplate(std::string& tpl, std::string& errorMsg)
+    {
+        std::ifstream ifs("mail_template.txt");
+        if (!ifs.is_open())
+        {
+            errorMsg = "无法打开 mail_template.txt，请确认文件在程序运行目录下。";
+            return false;
+        }
+
+        std::ostringstream oss;
+        oss << ifs.rdbuf();
+        tpl = oss.str();
+
+        if (tpl.empty())
+        {
+            errorMsg = "mail_template.txt 内容为空。";
+            return false;
+        }
+
+        return true;
+    }
+
+    // 群发取消代数：CancelBulkMails 递增，取消调用时正在进行的所有群发。
+    // 每次群发开始时记下当时的代数，之后代数变化即视为已取消；只增不减，不需要在任何地方清除
+    std::atomic<unsigned long long> g_bulkCancelGeneration(0);
+
+    // 一次群发的取消状态：调用方的取消令牌被取消，或开始之后调用过 CancelBulkMails
+    class BulkRunCancellation
+    {
+    public:
+        explicit BulkRunCancellation(const BulkCancelToken* token)
+            : token_(token), generation_(g_bulkCancelGeneration.load())
+        {
+        }
+
+        bool IsCancelled() const
+        {
+            return (token_ && token_->IsCancelled()) || g_bulkCancelGeneration.load() != generation_;
+        }
+
+    private:
+        const BulkCancelToken* token_;
+        unsigned long long     generation_;
+    };
+
+    // --- 每个 SMTP 服务器（地址:端口）的并发连接上限，进程内的所有群发共享 ---
+    class ServerConnectionLimiter
+    {
+    public:
+        static ServerConnectionLimiter& Instance()
+        {
+            static ServerConnectionLimiter instance;
+            return instance;
+        }
+
+        // 等待空闲名额；群发被取消时返回 false
+        bool Acquire(const std::string& server, int limit, const BulkRunCancellation& cancel)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [&]() {
+                return cancel.IsCancelled() || limit <= 0 || active_[server] < limit;
+            });
+            if (cancel.IsCancelled())
+            {
+                return false;
+            }
+            ++active_[server];
+            return true;
+        }
+
+        void Release(const std::string& server)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                --active_[server];
+            }
+            cv_.notify_all();
+        }
+
+        // 取消时唤醒所有等待者
+        void WakeAll()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+            }
+            cv_.notify_all();
+        }
+
+    private:
+        std::mutex                 mutex_;
+        std::condition_variable    cv_;
+        std::map<std::string, int> active_;
+    };
+
+    // 正文相同的一组连续收件人：(第几封, 邮箱)；seq 为组的顺序号
+    // message 是渲染阶段生成的完整邮件（头部、正文和附件引用），发送阶段直接流式发送
+    // 邮箱是 block 中的视图，block 随最后一个引用它的组释放
+    struct MailGroup
+    {
+        size_t seq = 0;
+        std::vector<std::pair<int, std::string_view>> members;
+        std::unique_ptr<MimeMessageSource> message;
+        std::shared_ptr<const RecipientBlock> block;
+    };
+
+    // 单个收件人的发送结果
+    struct RecipientOutcome
     {
+        int         index;
         std::string email;
-        std::string name;
+        bool        ok;
+        std::string error;
     };
 
-    bool IsWhitespace(char ch)
+    // 生成一组邮件的完整内容
+    // - 只有一个收件人：与逐封发送相同（To 为收件人地址，主题带序号）
+    // - 多个收件人：正文只传输一次，邮件头 To 为 "undisclosed-recipients:;"，收件人互不可见（同密送）
+    void BuildGroupMessage(const SmtpConfig& cfg,
+        std::string_view body,
+        const std::vector<AttachmentInfo>& attachments,
+        MailGroup& group)
     {
-        return std::isspace(static_cast<unsigned char>(ch)) != 0;
+        SimpleEmail mail;
+        mail.body.assign(body.data(), body.size());
+        mail.attachments = attachments; // 共享的附件内容只复制引用
+        if (group.members.size() == 1)
+        {
+            mail.to = std::string(group.members.front().second);
+            mail.subject = "群发测试邮件 #" + std::to_string(group.members.front().first);
+        }
+        else
+        {
+            mail.to = "undisclosed-recipients:;";
+            mail.subject = "群发测试邮件";
+        }
+
+        group.message = std::make_unique<MimeMessageSource>(cfg, mail);
     }
 
-    void Trim(std::string& s)
+    // 发送一组邮件，按每个收件人的 RCPT TO 结果给出结果
+    std::vector<RecipientOutcome> SendGroup(SmtpSession& session, MailGroup& group)
     {
-        auto it = s.begin();
-        while (it != s.end() && IsWhitespace(*it)) ++it;
-        s.erase(s.begin(), it);
+        std::vector<std::string> addresses;
+        addresses.reserve(group.members.size());
+        for (const auto& m : group.members)
+        {
+            addresses.emplace_back(m.second);
+        }
+
+        // 邮件内容按段发送，附件部分直接引用共享的编码结果
+        std::string sendError;
+        std::vector<SmtpRejectedRecipient> rejected;
+        bool ok = session.SendToMany(addresses, *group.message, rejected, sendError);
+
+        std::map<std::string, std::string> rejectedReplies;
+        for (const auto& rj : rejected)
+        {
+            rejectedReplies[rj.address] = rj.reply;
+        }
 
-        if (s.empty()) return;
-        auto rit = s.end() - 1;
-        while (rit >= s.begin() && IsWhitespace(*rit))
+        std::vector<RecipientOutcome> outcomes;
+        outcomes.reserve(group.members.size());
+        for (const auto& m : group.members)
         {
-            if (rit == s.begin())
+            std::string email(m.second);
+            auto it = rejectedReplies.find(email);
+            bool recipientOk = ok && it == rejectedReplies.end();
+            outcomes.push_back({ m.first, std::move(email), recipientOk,
+                recipientOk ? std::string() : (it != rejectedReplies.end() ? it->second : sendError) });
+        }
+        return outcomes;
+    }
+
+    // --- 按组的顺序号汇总结果：日志顺序与收件人顺序一致，计数与逐封发送相同 ---
+    class OrderedReporter
+    {
+    public:
+        void Complete(size_t seq, std::vector<RecipientOutcome>&& outcomes)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_[seq] = std::move(outcomes);
+
+            for (auto it = pending_.find(nextSeq_); it != pending_.end(); it = pending_.find(nextSeq_))
             {
-                s.clear();
-                return;
+                for (const auto& o : it->second)
+                {
+                    if (o.ok)
+                    {
+                        ++successCount_;
+                        EmailLogger::Info("群发：成功发送给 " + o.email +
+                            "（第 " + std::to_string(o.index) + " 封）");
+                    }
+                    else
+                    {
+                        ++failCount_;
+                        EmailLogger::Error("群发：发送给 " + o.email +
+                            " 失败，错误: " + o.error);
+                    }
+                }
+                pending_.erase(it);
+                ++nextSeq_;
             }
-            --rit;
         }
-        s.erase(rit + 1, s.end());
-    }
 
-    // 解析一行 "email,name" → Recipient
-    bool ParseRecipientLine(const std::string& line, Recipient& out)
+        int SuccessCount() const { return successCount_; }
+        int FailCount() const { return failCount_; }
+
+    private:
+        std::mutex                                       mutex_;
+        std::map<size_t, std::vector<RecipientOutcome>> pending_;
+        size_t                                           nextSeq_ = 0;
+        int                                              successCount_ = 0;
+        int                                              failCount_ = 0;
+    };
+
+    // --- 有界工作队列：生产者渲染邮件组，工作线程取出发送 ---
+    class GroupQueue
     {
-        // 忽略空行和注释行
-        if (line.empty() || line[0] == '#')
-            return false;
+    public:
+        GroupQueue(size_t capacity, const BulkRunCancellation& cancel)
+            : capacity_(capacity), cancel_(cancel)
+        {
+        }
 
-        auto pos = line.find(',');
-        if (pos == std::string::npos)
+        // 队列满时等待；已关闭或群发被取消时返回 false
+        // （取消时工作线程可能已全部退出，定期检查取消标志，避免生产者永久等待）
+        bool Push(MailGroup&& group)
         {
-            return false;
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!closed_ && queue_.size() >= capacity_)
+            {
+                if (cancel_.IsCancelled())
+                {
+                    return false;
+                }
+                notFull_.wait_for(lock, std::chrono::milliseconds(100));
+            }
+            if (closed_)
+            {
+                return false;
+            }
+            queue_.push_back(std::move(group));
+            notEmpty_.notify_one();
+            return true;
         }
 
-        std::string email = line.substr(0, pos);
-        std::string name = line.substr(pos + 1);
+        // 队列空且已关闭时返回 false
+        bool Pop(MailGroup& group)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notEmpty_.wait(lock, [&]() { return finished_ || closed_ || !queue_.empty(); });
+            if (closed_ || queue_.empty())
+            {
+                return false;
+            }
+            group = std::move(queue_.front());
+            queue_.pop_front();
+            notFull_.notify_one();
+            return true;
+        }
 
-        Trim(email);
-        Trim(name);
+        // 生产者已提交全部组：工作线程处理完剩余的组后退出
+        void Finish()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            finished_ = true;
+            notEmpty_.notify_all();
+        }
 
-        if (email.empty())
+        // 取消：丢弃尚未发送的组
+        void Close()
         {
-            return false;
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+            queue_.clear();
+            notEmpty_.notify_all();
+            notFull_.notify_all();
         }
 
-        out.email = email;
-        out.name = name;
-        return true;
-    }
+    private:
+        std::mutex              mutex_;
+        std::condition_variable notEmpty_;
+        std::condition_variable notFull_;
+        std::deque<MailGroup>   queue_;
+        size_t                  capacity_;
+        const BulkRunCancellation& cancel_;
+        bool                    finished_ = false;
+        bool                    closed_ = false;
+    };
 
-    // 从 recipients.txt 读取收件人列表
-    bool LoadRecipients(std::vector<Recipient>& recipients, std::string& errorMsg)
+    // 渲染完成的一块：收件人及其邮件组
+    struct RenderedBlock
     {
-        std::ifstream ifs("recipients.txt");
-        if (!ifs.is_open())
+        std::shared_ptr<const RecipientBlock> recipients;
+        std::vector<MailGroup>                groups;
+    };
+
+    // --- 渲染结果的按序交接：渲染线程乱序完成各块，发送阶段按块序号依次取出 ---
+    // 最多领先 window 块，渲染速度快于发送时内存占用有上限
+    class RenderedBlocks
+    {
+    public:
+        RenderedBlocks(size_t window, const BulkRunCancellation& cancel)
+            : window_(window), cancel_(cancel)
         {
-            errorMsg = "无法打开 recipients.txt，请确认文件在程序运行目录下。";
-            return false;
         }
 
-        std::string line;
-        int lineNumber = 0;
-        while (std::getline(ifs, line))
+        // 渲染线程：等到 block 进入窗口再开始渲染；已停止或群发被取消时返回 false
+        bool WaitTurn(size_t block)
         {
-            ++lineNumber;
-            Recipient r;
-            if (ParseRecipientLine(line, r))
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!stopped_ && block >= next_ + window_)
             {
-                recipients.push_back(r);
+                if (cancel_.IsCancelled())
+                {
+                    return false;
+                }
+                turn_.wait_for(lock, std::chrono::milliseconds(100));
             }
-            else
+            return !stopped_;
+        }
+
+        void Put(size_t block, RenderedBlock&& rendered)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ready_[block] = std::move(rendered);
+            ready_cv_.notify_all();
+        }
+
+        // 收件人已全部读出，共 count 块
+        void Finish(size_t count)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            count_ = count;
+            ready_cv_.notify_all();
+        }
+
+        // 发送阶段：取出下一块；全部取完或群发被取消时返回 false
+        bool Take(RenderedBlock& rendered)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            auto it = ready_.find(next_);
+            while (it == ready_.end())
             {
-                // 无效行可以选择忽略，也可以记日志
-                // 这里我们简单忽略空行/注释行，对真正格式错误的行记一下日志
-                if (!line.empty() && line[0] != '#')
+                if (cancel_.IsCancelled() || next_ == count_)
                 {
-                    EmailLogger::Error("解析 recipients.txt 第 " + std::to_string(lineNumber) +
-                        " 行失败，内容为: " + line);
+                    return false;
                 }
+                ready_cv_.wait_for(lock, std::chrono::milliseconds(100));
+                it = ready_.find(next_);
             }
+            rendered = std::move(it->second);
+            ready_.erase(it);
+            ++next_;
+            turn_.notify_all();
+            return true;
         }
 
-        if (recipients.empty())
+        // 发送阶段结束：尚未开始的渲染不再进行
+        void Stop()
         {
-            errorMsg = "recipients.txt 中没有有效的收件人。";
-            return false;
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+            turn_.notify_all();
         }
 
-        return true;
-    }
+    private:
+        std::mutex                                   mutex_;
+        std::condition_variable                      turn_;
+        std::condition_variable                      ready_cv_;
+        std::map<size_t, RenderedBlock>              ready_;
+        size_t                                       window_;
+        const BulkRunCancellation&                   cancel_;
+        size_t                                       next_ = 0;
+        size_t                                       count_ = static_cast<size_t>(-1);  // 读完之前未知
+        bool                                         stopped_ = false;
+    };
 
-    // 从 mail_template.txt 读取整个模板文本
-    bool LoadMailTemplate(std::string& tpl, std::string& errorMsg)
+    // 每个渲染块的收件人数（再向上取整为单个事务收件人上限的整数倍）
+    const size_t RENDER_BLOCK_RECIPIENTS = 256;
+
+    // 按块提供收件人：填充 block（最多 maxRows 行）；没有更多收件人或读取失败（errorMsg 非空）时返回 false
+    using RecipientBlockSource = std::function<bool(RecipientBlock& block, size_t maxRows, std::string& errorMsg)>;
+
+    // 尚未从 source 读出的收件人数；exact 为 false 表示估算值。取消时用它统计未发送的数量，不再读取剩余部分
+    using UnreadRecipientCount = std::function<size_t(bool& exact)>;
+
+    // 群发的主体：columns 为收件人各列的列名，source 按顺序给出收件人块
+    // cancel 由入口函数在做任何准备工作之前创建，准备期间的取消同样生效
+    bool SendBulkStream(const SmtpConfig& cfg,
+        const BulkRunCancellation& cancel,
+        const std::vector<std::string>& columns,
+        const RecipientBlockSource& source,
+        const UnreadRecipientCount& unread,
+        const std::string& templateText,
+        const std::vector<AttachmentInfo>& attachments,
+        BulkSendSummary& summary,
+        std::string& errorMsg)
     {
-        std::ifstream ifs("mail_template.txt");
-        if (!ifs.is_open())
+        summary = BulkSendSummary();
+
+        // 模板只解析一次，逐个收件人按槽位绑定变量
+        CompiledTemplate compiled;
+        if (!compiled.Compile(templateText, errorMsg))
         {
-            errorMsg = "无法打开 mail_template.txt，请确认文件在程序运行目录下。";
+            EmailLogger::Error("群发：模板解析失败: " + errorMsg);
             return false;
         }
+        const int nameSlot = compiled.SlotOf("name");
+        const int indexSlot = compiled.SlotOf("index");
+        const int timeSlot = compiled.SlotOf("time");
+
+        // 其他列按列名绑定（例如表头中的 company 对应 ${company}）
+        std::vector<int> columnSlots;
+        for (const auto& column : columns)
+        {
+            columnSlots.push_back(compiled.SlotOf(column));
+        }
+
+        const int workerCount = (cfg.workerThreads > 1) ? cfg.workerThreads : 1;
+        const std::string server = cfg.serverIp + ":" + std::to_string(cfg.port);
+
+        const size_t renderCount = (cfg.renderThreads > 0)
+            ? static_cast<size_t>(cfg.renderThreads)
+            : (std::max)(static_cast<size_t>(1), static_cast<size_t>(std::thread::hardware_concurrency()));
+
+        EmailLogger::Info("群发：开始发送邮件，工作线程 = " + std::to_string(workerCount) +
+            "，渲染线程 = " + std::to_string(renderCount));
+
+        GroupQueue           queue(static_cast<size_t>(workerCount) * 4, cancel);
+        OrderedReporter      reporter;
+        std::atomic<int>     connections(0);
+
+        // 1. 工作线程：每个线程拥有自己的 SMTP 会话，先占用服务器的连接名额再开始发送
+        std::vector<std::thread> workers;
+        workers.reserve(workerCount);
+        for (int w = 0; w < workerCount; ++w)
+        {
+            workers.emplace_back([&]() {
+                if (!ServerConnectionLimiter::Instance().Acquire(server, cfg.maxConnectionsPerServer, cancel))
+                {
+                    return;
+                }
+
+                SmtpSession session(cfg);
+                MailGroup group;
+                while (queue.Pop(group))
+                {
+                    if (cancel.IsCancelled())
+                    {
+                        // 已取出的组不再发送，但仍按顺序提交，避免阻塞后续结果的汇总
+                        reporter.Complete(group.seq, std::vector<RecipientOutcome>());
+                        continue;
+                    }
+                    reporter.Complete(group.seq, SendGroup(session, group));
+                }
+                session.Close();
+                connections += session.ConnectionCount();
+
+                ServerConnectionLimiter::Instance().Release(server);
+            });
+        }
+
+        // 2. 渲染阶段：按顺序从收件人来源读取一块（读到即开始，不等全部读完），多个渲染线程并行
+        //    渲染正文（每块写入同一个 arena）并生成完整邮件，块内正文相同的连续收件人合并为一组；
+        //    块大小是单个事务收件人上限的整数倍，正文全部相同时分组结果与逐个渲染相同。
+        //    渲染最多领先发送 render_threads × 2 块（RenderedBlocks 的窗口），每个渲染线程另外最多持有一块
+        //    已读出、等待进入窗口的块，内存占用与收件人总数无关
+        const size_t maxGroupSize = (cfg.maxRecipientsPerMessage > 1)
+            ? static_cast<size_t>(cfg.maxRecipientsPerMessage)
+            : 1;
+        const size_t blockSize = (RENDER_BLOCK_RECIPIENTS + maxGroupSize - 1) / maxGroupSize * maxGroupSize;
+
+        RenderedBlocks rendered(renderCount * 2, cancel);
+        std::mutex     sourceMutex;
+        bool           sourceDone = false;
+        std::string    sourceError;
+        size_t         blocksRead = 0;
+        size_t         rowsRead = 0;
+
+        std::vector<std::thread> renderers;
+        renderers.reserve(renderCount);
+        for (size_t t = 0; t < renderCount; ++t)
+        {
+            renderers.emplace_back([&]() {
+                TemplateValues      values(compiled);
+                std::string         arena;   // 一块内所有正文依次写入
+                std::vector<size_t> ends;    // 每个正文在 arena 中的结束位置
+
+                while (true)
+                {
+                    // 读取下一块：读取按顺序进行，块序号即读取顺序
+                    auto   recipients = std::make_shared<RecipientBlock>();
+                    size_t block = 0;
+                    size_t firstIndex = 0;
+                    {
+                        std::lock_guard<std::mutex> lock(sourceMutex);
+                        if (sourceDone || cancel.IsCancelled())
+                        {
+                            return;
+                        }
+                        std::string readError;
+                        if (!source(*recipients, blockSize, readError))
+                        {
+                            sourceDone = true;
+                            sourceError = readError;
+                            rendered.Finish(blocksRead);
+                            return;
+                        }
+                        block = blocksRead++;
+                        firstIndex = rowsRead;
+                        rowsRead += recipients->Size();
+                    }
+
+                    if (!rendered.WaitTurn(block))
+                    {
+                        return;
+                    }
+
+                    const size_t rows = recipients->Size();
+                    arena.clear();
+                    ends.clear();
+                    for (size_t i = 0; i < rows; ++i)
+                    {
+                        // 绑定模板变量（模板中没有的变量不计算）
+                        for (size_t c = 0; c < columnSlots.size(); ++c)
+                        {
+                            values.Set(columnSlots[c], recipients->Field(i, c));
+                        }
+                        const std::string indexText = std::to_string(firstIndex + i + 1);
+                        const std::string timeText = (timeSlot >= 0) ? GetCurrentTimeString() : std::string();
+                        values.Set(nameSlot, recipients->Name(i));  // 收件人名字（可能为空）
+                        values.Set(indexSlot, indexText);           // 第几封
+                        values.Set(timeSlot, timeText);             // 当前时间
+                        compiled.RenderTo(values, arena);
+                        ends.push_back(arena.size());
+                    }
+
+                    RenderedBlock    result;
+                    std::string_view groupBody;
+                    for (size_t i = 0; i < rows; ++i)
+                    {
+                        const size_t     from = (i == 0) ? 0 : ends[i - 1];
+                        std::string_view body(arena.data() + from, ends[i] - from);
+
+                        // 正文与当前组不同或当前组已满时，先完成当前组
+                        auto& groups = result.groups;
+                        if (groups.empty() || groups.back().members.size() >= maxGroupSize || body != groupBody)
+                        {
+                            if (!groups.empty())
+                            {
+                                BuildGroupMessage(cfg, groupBody, attachments, groups.back());
+                            }
+                            groups.emplace_back();
+                            groups.back().block = recipients;
+                            groupBody = body;
+                        }
+                        groups.back().members.emplace_back(static_cast<int>(firstIndex + i + 1), recipients->Email(i));
+                    }
+                    if (!result.groups.empty())
+                    {
+                        BuildGroupMessage(cfg, groupBody, attachments, result.groups.back());
+                    }
+
+                    result.recipients = std::move(recipients);
+                    rendered.Put(block, std::move(result));
+                }
+            });
+        }
+
+        // 按块的顺序记录无效行、给组编号并交给工作线程；队列满时等待（发送慢于渲染时渲染线程随之暂停）
+        size_t        nextSeq = 0;
+        bool          queueClosed = false;
+        RenderedBlock taken;
+        while (!queueClosed && !cancel.IsCancelled() && rendered.Take(taken))
+        {
+            for (const auto& invalid : taken.recipients->InvalidRows())
+            {
+                EmailLogger::Error("解析 recipients.txt 第 " + std::to_string(invalid.first) +
+                    " 行失败，内容为: " + invalid.second);
+            }
+            for (auto& g : taken.groups)
+            {
+                g.seq = nextSeq++;
+                if (!queue.Push(std::move(g)))
+                {
+                    queueClosed = true; // 已取消，未发送的收件人在总结中统计
+                    break;
+                }
+            }
+        }
+        rendered.Stop();
+        for (auto& t : renderers)
+        {
+            t.join();
+        }
 
+        // 3. 等待工作线程结束；取消时丢弃队列中尚未发送的组（正在发送的事务会完成）
+        if (cancel.IsCancelled())
+        {
+            queue.Close();
+        }
+        else
+        {
+            queue.Finish();
+        }
+        for (auto& t : workers)
+        {
+            t.join();
+        }
+
+        // 取消时未读取的收件人不再读取，由来源给出数量（文件来源为估算值）
+        // 已读出但未发送的收件人是确切的：读出数减去已有结果的数量
+        const bool   cancelled = !sourceDone && cancel.IsCancelled();
+        bool         unreadExact = true;
+        const size_t unreadRows = cancelled ? unread(unreadExact) : 0;
+
+        summary.success = reporter.SuccessCount();
+        summary.fail = reporter.FailCount();
+        summary.cancelled = static_cast<int>(rowsRead + unreadRows) - summary.success - summary.fail;
+        summary.connections = connections.load();
+
+        // 4. 总结
         std::ostringstream oss;
-        oss << ifs.rdbuf();
-        tpl = oss.str();
+        oss << "群发完成：成功 " << summary.success << " 封，失败 " << summary.fail
+            << " 封，总计 " << (rowsRead + unreadRows) << (unreadExact ? " 封。" : " 封（估算）。");
+        EmailLogger::Info(oss.str());
+        if (cancelled || summary.cancelled > 0)
+        {
+            const std::string about = unreadExact ? " " : "约 ";
+            oss << "群发已取消，未发送" << about << summary.cancelled << " 封。";
+            EmailLogger::Info("群发：已取消，未发送" + about + std::to_string(summary.cancelled) +
+                " 封（已读出未发送 " + std::to_string(rowsRead - summary.success - summary.fail) +
+                " 封，未读取" + about + std::to_string(unreadRows) + " 封）");
+        }
+        EmailLogger::Info("群发：共建立 SMTP 连接 " + std::to_string(summary.connections) + " 个");
 
-        if (tpl.empty())
+        if (!sourceError.empty())
         {
-            errorMsg = "mail_template.txt 内容为空。";
+            oss << "读取收件人列表失败: " << sourceError;
+            EmailLogger::Error("群发：读取收件人列表失败: " + sourceError);
+        }
+
+        if (summary.fail > 0 || cancelled || summary.cancelled > 0 || !sourceError.empty())
+        {
+            errorMsg = oss.str();
             return false;
         }
 
+        errorMsg.clear();
         return true;
     }
 } // namespace
 
-bool SendBulkMails(const SmtpConfig& cfg, std::string& errorMsg)
+void BulkCancelToken::Cancel()
+{
+    cancelled_ = true;
+    ServerConnectionLimiter::Instance().WakeAll();
+}
+
+bool BulkCancelToken::IsCancelled() const
+{
+    return cancelled_.load();
+}
+
+void CancelBulkMails()
+{
+    ++g_bulkCancelGeneration;
+    ServerConnectionLimiter::Instance().WakeAll();
+}
+
+bool SendBulkMailsTo(const SmtpConfig& cfg,
+    const std::vector<BulkRecipient>& recipients,
+    const std::string& templateText,
+    BulkSendSummary& summary,
+    std::string& errorMsg,
+    const BulkCancelToken* cancelToken)
+{
+    return SendBulkMailsTo(cfg, recipients, templateText, std::vector<AttachmentInfo>(), summary, errorMsg, cancelToken);
+}
+
+bool SendBulkMailsTo(const SmtpConfig& cfg,
+    const std::vector<BulkRecipient>& recipients,
+    const std::string& templateText,
+    const std::vector<AttachmentInfo>& attachments,
+    BulkSendSummary& summary,
+    std::string& errorMsg,
+    const BulkCancelToken* cancelToken)
 {
-    std::vector<Recipient> recipients;
-    std::string            err;
+    BulkRunCancellation cancel(cancelToken);
 
-    // 1. 读收件人列表
-    if (!LoadRecipients(recipients, err))
+    // 列表按块复制给渲染阶段，与从文件读取的收件人走同一流程
+    size_t next = 0;
+    auto source = [&](RecipientBlock& block, size_t maxRows, std::string& err) {
+        err.clear();
+        if (next >= recipients.size())
+        {
+            return false;
+        }
+        block.Reset(2, 0, 1);
+        for (size_t end = (std::min)(next + maxRows, recipients.size()); next < end; ++next)
+        {
+            block.BeginRow(next + 1);
+            block.AddField(recipients[next].email);
+            block.AddField(recipients[next].name);
+            block.EndRow();
+        }
+        return true;
+    };
+    auto unread = [&](bool& exact) {
+        exact = true;
+        return recipients.size() - next;
+    };
+    return SendBulkStream(cfg, cancel, { "email", "name" }, source, unread, templateText, attachments, summary, errorMsg);
+}
+
+bool SendBulkMails(const SmtpConfig& cfg, std::string& errorMsg, const BulkCancelToken* cancelToken)
+{
+    // 打开文件、编码附件期间收到的取消同样生效
+    BulkRunCancellation cancel(cancelToken);
+    std::string err;
+
+    // 1. 打开收件人列表（映射后按块读取，发送开始前不需要读完）
+    RecipientCsvReader reader;
+    if (!reader.Open("recipients.txt", err))
     {
-        errorMsg = err;
+        errorMsg = "无法打开 recipients.txt，请确认文件在程序运行目录下。";
         EmailLogger::Error("群发：加载收件人列表失败: " + err);
         return false;
     }
@@ -162,64 +766,42 @@ bool SendBulkMails(const SmtpConfig& cfg, std::string& errorMsg)
         return false;
     }
 
-    EmailLogger::Info("群发：开始发送邮件，总收件人数 = " + std::to_string(recipients.size()));
-
-    int successCount = 0;
-    int failCount = 0;
-    int index = 0;
+    // 3. 附件：每个文件只读取、编码一次，所有邮件共享
+    AttachmentCache& cache = AttachmentCache::Instance();
+    cache.SetMaxBytes(cfg.attachmentCacheMb > 0
+        ? static_cast<size_t>(cfg.attachmentCacheMb) * 1024 * 1024
+        : 0);
+    cache.SetMapWindowBytes(static_cast<size_t>(cfg.attachmentMapWindowMb) * 1024 * 1024);
 
-    SmtpClient client;
-
-    for (const auto& r : recipients)
+    std::vector<AttachmentInfo> attachments;
+    for (const auto& path : cfg.bulkAttachments)
     {
-        ++index;
-
-        // 3. 构造模板变量
-        std::map<std::string, std::string> vars;
-        vars["name"] = r.name;                       // 收件人名字（可能为空）
-        vars["index"] = std::to_string(index);        // 第几封
-        vars["time"] = GetCurrentTimeString();       // 当前时间
-
-        // 4. 生成正文
-        std::string body = RenderTemplate(templateText, vars);
-
-        // 5. 构造邮件
-        SimpleEmail mail;
-        mail.to = r.email;
-        mail.subject = "群发测试邮件 #" + std::to_string(index);
-        mail.body = body;
-
-        std::string raw = EmailMessageBuilder::Build(cfg, mail);
-
-        // 6. 发送
-        std::string sendError;
-        bool ok = client.SendMail(cfg, raw, sendError);
-        if (ok)
+        AttachmentInfo att;
+        if (!BuildAttachmentFromCache(path, att, err, cache))
         {
-            ++successCount;
-            EmailLogger::Info("群发：成功发送给 " + r.email +
-                "（第 " + std::to_string(index) + " 封）");
-        }
-        else
-        {
-            ++failCount;
-            EmailLogger::Error("群发：发送给 " + r.email +
-                " 失败，错误: " + sendError);
+            errorMsg = err;
+            EmailLogger::Error("群发：加载附件失败: " + err);
+            return false;
         }
+        attachments.push_back(att);
     }
 
-    // 7. 总结
-    std::ostringstream summary;
-    summary << "群发完成：成功 " << successCount << " 封，失败 " << failCount
-        << " 封，总计 " << recipients.size() << " 封。";
-    EmailLogger::Info(summary.str());
-
-    if (failCount > 0)
+    // 4. 边读边发送
+    BulkSendSummary summary;
+    auto source = [&](RecipientBlock& block, size_t maxRows, std::string& readError) {
+        return reader.ReadBlock(block, maxRows, readError);
+    };
+    auto unread = [&](bool& exact) {
+        exact = false;
+        EmailLogger::Info("群发：recipients.txt 还有 " + std::to_string(reader.BytesRemaining()) + " 字节未读取");
+        return reader.EstimateRemainingRows();
+    };
+    bool ok = SendBulkStream(cfg, cancel, reader.Columns(), source, unread, templateText, attachments, summary, errorMsg);
+    if (ok && summary.success == 0)
     {
-        errorMsg = summary.str();
+        errorMsg = "recipients.txt 中没有有效的收件人。";
+        EmailLogger::Error("群发：加载收件人列表失败: " + errorMsg);
         return false;
     }
-
-    errorMsg.clear();
-    return true;
+    return ok;
 }
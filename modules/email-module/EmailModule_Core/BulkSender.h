@@ -1,13 +1,76 @@
 ﻿#pragma once
+#include <atomic>
 #include <string>
+#include <vector>
 #include "Config.h"
+#include "EmailMessage.h"
+
+// 群发收件人（recipients.txt 中的一行 "email,name"）
+struct BulkRecipient
+{
+    std::string email;
+    std::string name;
+};
+
+// 群发结果汇总（按收件人计数）
+struct BulkSendSummary
+{
+    int success = 0;
+    int fail = 0;
+    int cancelled = 0;    // 因取消而未发送的收件人（从 recipients.txt 读取时，未读取的部分为估算值）
+    int connections = 0;  // 所有工作线程累计建立的 SMTP 连接数
+};
+
+// 一次群发的取消令牌（可从其他线程调用 Cancel）：调用方在开始群发之前创建并传入，
+// Cancel 只影响传入该令牌的群发；群发开始前已取消的令牌会使群发不发送任何收件人
+class BulkCancelToken
+{
+public:
+    void Cancel();
+    bool IsCancelled() const;
+
+private:
+    std::atomic<bool> cancelled_{ false };
+};
 
 // 从 recipients.txt 和 mail_template.txt 读取信息，按模板群发邮件。
+// recipients.txt 由 RecipientCsvReader 映射后按块读取，读到第一块即开始发送；
+// 带表头时每一列都可以作为模板变量（${列名}）。
+// cfg.bulkAttachments 中的文件作为每封邮件的附件，经 AttachmentCache 只编码一次。
 // cfg：SMTP 配置（调用方通常从 ConfigLoader::LoadSmtpConfig 得到）
 // errorMsg：失败时返回概要错误信息（同时写入日志）
+// cancelToken：可选的取消令牌（见 BulkCancelToken），为空时只能通过 CancelBulkMails 取消
 //
 // 返回值：
 //  - true  ：全部收件人发送成功
 //  - false ：至少有一封发送失败（具体信息在日志和 errorMsg 中）
-bool SendBulkMails(const SmtpConfig& cfg, std::string& errorMsg);
+bool SendBulkMails(const SmtpConfig& cfg, std::string& errorMsg,
+    const BulkCancelToken* cancelToken = nullptr);
+
+// 向给定收件人列表群发（模板变量 ${name} / ${index} / ${time}）。
+// - 收件人分块，cfg.renderThreads 个渲染线程并行渲染正文并生成完整邮件，
+//   发送阶段按块的顺序从有界队列取出（渲染最多领先若干块，内存占用有上限）
+// - cfg.workerThreads 个工作线程并发发送，每个线程拥有自己的 SMTP 会话，
+//   同一服务器的并发连接数不超过 cfg.maxConnectionsPerServer（进程内所有群发共享该上限）
+// - 日志按收件人顺序写入，成功/失败计数与逐封发送一致
+// 返回值：全部收件人发送成功时为 true
+bool SendBulkMailsTo(const SmtpConfig& cfg,
+    const std::vector<BulkRecipient>& recipients,
+    const std::string& templateText,
+    BulkSendSummary& summary,
+    std::string& errorMsg,
+    const BulkCancelToken* cancelToken = nullptr);
+
+// 同上，每封邮件都带上 attachments（通常由 BuildAttachmentFromCache 得到，
+// 各邮件共享同一份编码结果，不复制附件内容）
+bool SendBulkMailsTo(const SmtpConfig& cfg,
+    const std::vector<BulkRecipient>& recipients,
+    const std::string& templateText,
+    const std::vector<AttachmentInfo>& attachments,
+    BulkSendSummary& summary,
+    std::string& errorMsg,
+    const BulkCancelToken* cancelToken = nullptr);
 
+// 取消调用时正在进行的所有群发（可从其他线程调用）：正在发送的事务会完成，其余收件人不再发送。
+// 之后开始的群发不受影响；只取消某一次群发、或需要在群发开始前取消时使用 BulkCancelToken
+void CancelBulkMails();
@@ -109,6 +109,117 @@ bool ConfigLoader::LoadSmtpConfig(SmtpConfig& cfg, std::string& errorMsg)
                 cfg.maxRetry = 1; // 至少尝试一次
             }
         }
+        else if (key == "max_messages_per_connection")
+        {
+            try
+            {
+                cfg.maxMessagesPerConnection = std::stoi(value);
+            }
+            catch (...)
+            {
+                errorMsg = "配置文件中 max_messages_per_connection 值无效。";
+                return false;
+            }
+        }
+        else if (key == "max_recipients_per_message")
+        {
+            try
+            {
+                cfg.maxRecipientsPerMessage = std::stoi(value);
+            }
+            catch (...)
+            {
+                errorMsg = "配置文件中 max_recipients_per_message 值无效。";
+                return false;
+            }
+        }
+        else if (key == "worker_threads")
+        {
+            try
+            {
+                cfg.workerThreads = std::stoi(value);
+            }
+            catch (...)
+            {
+                errorMsg = "配置文件中 worker_threads 值无效。";
+                return false;
+            }
+
+            if (cfg.workerThreads < 1)
+            {
+                cfg.workerThreads = 1;
+            }
+        }
+        else if (key == "max_connections_per_server")
+        {
+            try
+            {
+                cfg.maxConnectionsPerServer = std::stoi(value);
+            }
+            catch (...)
+            {
+                errorMsg = "配置文件中 max_connections_per_server 值无效。";
+                return false;
+            }
+        }
+        else if (key == "render_threads")
+        {
+            try
+            {
+                cfg.renderThreads = std::stoi(value);
+            }
+            catch (...)
+            {
+                errorMsg = "配置文件中 render_threads 值无效。";
+                return false;
+            }
+        }
+        else if (key == "bulk_attachments")
+        {
+            // 多个路径以 ';' 分隔
+            cfg.bulkAttachments.clear();
+            std::size_t start = 0;
+            while (start <= value.size())
+            {
+                std::size_t end = value.find(';', start);
+                if (end == std::string::npos)
+                    end = value.size();
+                std::string path = value.substr(start, end - start);
+                Trim(path);
+                if (!path.empty())
+                    cfg.bulkAttachments.push_back(path);
+                start = end + 1;
+            }
+        }
+        else if (key == "attachment_cache_mb")
+        {
+            try
+            {
+                cfg.attachmentCacheMb = std::stoi(value);
+            }
+            catch (...)
+            {
+                errorMsg = "配置文件中 attachment_cache_mb 值无效。";
+                return false;
+            }
+        }
+        else if (key == "attachment_map_window_mb")
+        {
+            try
+            {
+                cfg.attachmentMapWindowMb = std::stoi(value);
+            }
+            catch (...)
+            {
+                errorMsg = "配置文件中 attachment_map_window_mb 值无效。";
+                return false;
+            }
+
+            if (cfg.attachmentMapWindowMb < 1)
+            {
+                cfg.attachmentMapWindowMb = 1;
+            }
+        }
 
     }
 
@@ -1,5 +1,6 @@
 ﻿#pragma once
 #include <string>
+#include <vector>
 
 // SMTP 配置信息
 struct SmtpConfig
@@ -17,6 +18,22 @@ struct SmtpConfig
     // 确保网络健壮性
     int         ioTimeoutMs = 5000; // 读写超时时间（毫秒），<=0 表示不特别设置
     int         maxRetry = 1;    // 最大发送重试次数（1 表示不重试）
+
+    // 群发连接复用
+    int         maxMessagesPerConnection = 100; // 单个 SMTP 连接最多发送的邮件数，<=0 表示不限制
+
+    // 群发时正文相同的邮件合并为一个事务，单个事务最多的收件人数（RCPT TO 个数），<=1 表示不合并
+    int         maxRecipientsPerMessage = 100;
+
+    // 并发群发
+    int         workerThreads = 1;            // 群发工作线程数（每个线程一个 SMTP 连接）
+    int         maxConnectionsPerServer = 4;  // 同一 SMTP 服务器的并发连接上限，<=0 表示不限制
+    int         renderThreads = 0;            // 群发渲染线程数（渲染正文并生成完整邮件），<=0 表示 CPU 核数
+
+    // 群发附件：每封邮件都带上这些文件，编码结果由 AttachmentCache 共享
+    std::vector<std::string> bulkAttachments;   // bulk_attachments=路径1;路径2
+    int         attachmentCacheMb = 256;        // 附件缓存内存上限（MB），<=0 表示不缓存
+    int         attachmentMapWindowMb = 64;     // 附件编码时单个映射窗口的大小（MB），更大的文件分窗口映射
 };
 
 class ConfigLoader
@@ -1,38 +1,72 @@
 ﻿#include "EmailMessage.h"
 #include "Utils.h"
+#include "Base64.h"
 
+#include <atomic>
 #include <sstream>
+#include <string_view>
 
 // 只在本文件内部使用的一些小工具
 namespace
 {
     // 生成一个简单的 MIME 边界字符串，用于 multipart/mixed
+    // 群发带附件时多个线程同时构造 multipart 邮件（发送线程或渲染线程），计数器必须是原子的
     std::string GenerateBoundary()
     {
-        static int counter = 0;
+        static std::atomic<unsigned> counter(0);
         std::ostringstream oss;
         oss << "----=CppEmailBoundary_" << ++counter;
         return oss.str();
     }
 
-    // 把 Base64 字符串按行拆分，每行最多 lineLen 个字符（默认 76）
-    std::string WrapBase64Lines(const std::string& base64, std::size_t lineLen = 76)
+    // Base64 每行 76 个字符，对应 57 个原始字节
+    const std::size_t BASE64_LINE_BYTES = 57;
+
+    // 默认分段大小
+    const std::size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+    // 附件文件大小，无法获取时返回 -1
+    long long FileSizeOf(const std::string& path)
     {
-        std::string out;
-        out.reserve(base64.size() + base64.size() / lineLen * 2);
+        std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+        if (!ifs.is_open())
+            return -1;
+        return static_cast<long long>(ifs.tellg());
+    }
+}
+
+bool EmailMessageBuilder::Build(const SmtpConfig& cfg, const SimpleEmail& mail, std::string& out, std::string& errorMsg)
+{
+    // 与流式发送共用同一份生成逻辑，这里一次取出全部内容
+    MimeMessageSource source(cfg, mail);
+
+    out.clear();
+    if (source.Size() > 0)
+        out.reserve(static_cast<std::size_t>(source.Size()));
 
-        std::size_t n = base64.size();
-        for (std::size_t i = 0; i < n; i += lineLen)
+    std::string_view chunk;
+    bool             isLast = false;
+    while (!isLast)
+    {
+        // 读取失败时不返回半封邮件：否则发送出去的是缺少附件内容的邮件
+        if (!source.Next(chunk, isLast, errorMsg))
         {
-            std::size_t len = (i + lineLen <= n) ? lineLen : (n - i);
-            out.append(base64, i, len);
-            out.append("\r\n");
+            out.clear();
+            return false;
         }
-        return out;
+        out.append(chunk.data(), chunk.size());
     }
+    return true;
 }
 
-std::string EmailMessageBuilder::Build(const SmtpConfig& cfg, const SimpleEmail& mail)
+// ---------------- MimeMessageSource ----------------
+
+MimeMessageSource::MimeMessageSource(const SmtpConfig& cfg, const SimpleEmail& mail)
+    : size_(0)
+    , chunkSize_(DEFAULT_CHUNK_SIZE)
+    , part_(0)
+    , offset_(0)
+    , fileRead_(0)
 {
     std::ostringstream oss;
 
@@ -52,7 +86,8 @@ std::string EmailMessageBuilder::Build(const SmtpConfig& cfg, const SimpleEmail&
         oss << "\r\n";
 
         oss << mail.body;
-        return oss.str();
+        AppendText(oss.str());
+        return;
     }
 
     // 2：有附件 → 构造 multipart/mixed
@@ -84,13 +119,173 @@ std::string EmailMessageBuilder::Build(const SmtpConfig& cfg, const SimpleEmail&
             << att.fileName << "\"\r\n";
         oss << "\r\n";
 
-        // Base64 内容按行分段，避免一行太长
-        oss << WrapBase64Lines(att.base64Content);
+        if (att.encodedLines)
+        {
+            // 共享的编码结果：只引用，不复制（空附件没有内容可引用）
+            if (!att.encodedLines->empty())
+            {
+                AppendText(oss.str());
+                oss.str(std::string());
+
+                Part sharedPart;
+                sharedPart.shared = att.encodedLines;
+                parts_.push_back(sharedPart);
+                if (size_ >= 0)
+                    size_ += static_cast<long long>(att.encodedLines->size());
+            }
+        }
+        else if (!att.base64Content.empty() || att.filePath.empty())
+        {
+            // Base64 内容按行分段，避免一行太长
+            std::string wrapped;
+            Base64::WrapLinesTo(att.base64Content.data(), att.base64Content.size(), wrapped);
+            oss << wrapped;
+        }
+        else
+        {
+            // 附件文件：发送时再读取，先记下编码后的大小
+            AppendText(oss.str());
+            oss.str(std::string());
+
+            long long fileSize = FileSizeOf(att.filePath);
+
+            Part filePart;
+            filePart.filePath = att.filePath;
+            filePart.fileSize = fileSize;
+            parts_.push_back(filePart);
+
+            if (fileSize < 0 || size_ < 0)
+            {
+                size_ = -1;
+            }
+            else
+            {
+                const long long lineBytes = static_cast<long long>(BASE64_LINE_BYTES);
+                long long lines = (fileSize + lineBytes - 1) / lineBytes;
+                size_ += (fileSize + 2) / 3 * 4 + lines * 2;
+            }
+        }
         oss << "\r\n";
     }
 
     // 结束边界
     oss << "--" << boundary << "--\r\n";
+    AppendText(oss.str());
+}
+
+// --- 追加文本段（与前一个文本段合并） ---
+void MimeMessageSource::AppendText(const std::string& text)
+{
+    if (text.empty())
+        return;
+
+    if (parts_.empty() || !parts_.back().filePath.empty() || parts_.back().shared)
+        parts_.push_back(Part());
+    parts_.back().text += text;
+
+    if (size_ >= 0)
+        size_ += static_cast<long long>(text.size());
+}
+
+void MimeMessageSource::SetPreferredChunkSize(size_t chunkSize)
+{
+    if (chunkSize > 0)
+        chunkSize_ = chunkSize;
+}
+
+bool MimeMessageSource::Rewind(std::string& errorMsg)
+{
+    (void)errorMsg;
+    part_ = 0;
+    offset_ = 0;
+    fileRead_ = 0;
+    if (file_.is_open())
+        file_.close();
+    file_.clear();
+    return true;
+}
+
+// --- 取下一段：文本段直接返回视图；附件按整行读取原始字节，编码到 encoded_ 后返回 ---
+bool MimeMessageSource::Next(std::string_view& chunk, bool& isLast, std::string& errorMsg)
+{
+    while (part_ < parts_.size())
+    {
+        const Part& part = parts_[part_];
+
+        if (part.filePath.empty())
+        {
+            const std::string& data = part.Data();
+            std::size_t n = data.size() - offset_;
+            if (n > chunkSize_)
+                n = chunkSize_;
+            chunk = std::string_view(data.data() + offset_, n);
+            offset_ += n;
+            if (offset_ == data.size())
+            {
+                ++part_;
+                offset_ = 0;
+            }
+            isLast = (part_ == parts_.size());
+            return true;
+        }
+
+        if (!file_.is_open())
+        {
+            file_.clear();
+            file_.open(part.filePath, std::ios::binary);
+            if (!file_.is_open())
+            {
+                errorMsg = "无法打开附件文件: " + part.filePath;
+                return false;
+            }
+            fileRead_ = 0;
+        }
+
+        // 每次读取整数行的原始字节，使编码结果的换行位置与一次性编码相同
+        std::size_t lines = chunkSize_ / (BASE64_LINE_BYTES / 3 * 4 + 2);
+        if (lines == 0)
+            lines = 1;
+        raw_.resize(lines * BASE64_LINE_BYTES);
+
+        file_.read(raw_.data(), static_cast<std::streamsize>(raw_.size()));
+        std::size_t got = static_cast<std::size_t>(file_.gcount());
+        if (file_.bad())
+        {
+            errorMsg = "读取附件文件时发生错误: " + part.filePath;
+            return false;
+        }
+
+        fileRead_ += static_cast<long long>(got);
+
+        if (got == 0)
+        {
+            // 读不到数据但没有到达文件末尾，或文件大小与构造时不同（发送期间被截断或改写）：
+            // 继续发送会得到不完整的邮件，返回错误由调用方中止事务
+            if (!file_.eof())
+            {
+                errorMsg = "读取附件文件时发生错误: " + part.filePath;
+                return false;
+            }
+            if (part.fileSize >= 0 && fileRead_ != part.fileSize)
+            {
+                errorMsg = "附件文件在发送期间被修改: " + part.filePath;
+                return false;
+            }
+            file_.close();
+            ++part_;
+            continue;
+        }
+
+        // 编码与换行一次完成 (每行 76 个字符并以 CRLF 结尾)
+        encoded_.clear();
+        Base64::EncodeLinesTo(raw_.data(), got, encoded_, BASE64_LINE_BYTES / 3 * 4);
+
+        chunk = encoded_;
+        isLast = false; // 附件之后总有结束边界
+        return true;
+    }
 
-    return oss.str();
+    chunk = std::string_view();
+    isLast = true;
+    return true;
 }
@@ -1,14 +1,22 @@
 ﻿#pragma once
+#include <fstream>
+#include <memory>
 #include <string>
 #include <vector>   
 #include "Config.h"
+#include "SmtpDataEncoder.h"
 
-// 附件信息：目前存的是“已经编码好的内容”，真正读文件在别的模块做
+// 附件信息：内容三选一（按以下顺序）
+// - encodedLines：已编码并按 76 字符换行的共享内容（来自 AttachmentCache，多封邮件引用同一份，不复制）
+// - base64Content：已经编码好的内容
+// - filePath：发送时才从磁盘分段读取并编码（base64Content 为空时使用）
 struct AttachmentInfo
 {
     std::string fileName;       // 附件文件名，例如 "report.txt"
     std::string contentType;    // MIME 类型，例如 "text/plain" 或 "application/octet-stream"
     std::string base64Content;  // 附件内容的 Base64 字符串
+    std::string filePath;       // 附件文件路径
+    std::shared_ptr<const std::string> encodedLines; // 共享的已换行 Base64 内容
 };
 
 // 简单邮件数据结构
@@ -24,5 +32,43 @@ struct SimpleEmail
 class EmailMessageBuilder
 {
 public:
-    static std::string Build(const SmtpConfig& cfg, const SimpleEmail& mail);
+    // 成功时 out 为完整邮件；附件文件无法读取时返回 false，errorMsg 给出原因
+    static bool Build(const SmtpConfig& cfg, const SimpleEmail& mail, std::string& out, std::string& errorMsg);
+};
+
+// 按需生成邮件内容的数据源：头部和文本部分预先生成，附件文件在 Next 时分段读取、
+// Base64 编码并按 76 字符换行，内存占用只有一个分段的大小，与附件大小无关
+class MimeMessageSource : public MessageSource
+{
+public:
+    MimeMessageSource(const SmtpConfig& cfg, const SimpleEmail& mail);
+
+    bool Next(std::string_view& chunk, bool& isLast, std::string& errorMsg) override;
+    bool Rewind(std::string& errorMsg) override;
+    long long Size() const override { return size_; }
+    void SetPreferredChunkSize(size_t chunkSize) override;
+
+private:
+    // 一段邮件内容：文本、共享的已编码附件（shared 非空），或需要编码的附件文件（filePath 非空）
+    struct Part
+    {
+        std::string                        text;
+        std::shared_ptr<const std::string> shared;
+        std::string                        filePath;
+        long long                          fileSize = -1;  // 构造时的附件文件大小，未知时为 -1
+
+        const std::string& Data() const { return shared ? *shared : text; }
+    };
+
+    void AppendText(const std::string& text);
+
+    std::vector<Part> parts_;
+    long long         size_;       // 编码后的总字节数，附件大小未知时为 -1
+    size_t            chunkSize_;
+    size_t            part_;       // 当前段
+    size_t            offset_;     // 当前文本段已返回的字节数
+    std::ifstream     file_;       // 当前附件文件
+    long long         fileRead_;   // 当前附件文件已读取的字节数
+    std::vector<char> raw_;        // 从文件读取的原始字节
+    std::string       encoded_;    // 编码后的一个分段
 };
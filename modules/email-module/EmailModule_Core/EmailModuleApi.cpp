@@ -42,11 +42,11 @@ namespace EmailModule
         mail.subject = subject;
         mail.body = body;
 
-        std::string raw = EmailMessageBuilder::Build(cfg, mail);
-
+        std::string raw;
         SmtpClient client;
         std::string sendErr;
-        bool ok = client.SendMail(cfg, raw, sendErr);
+        bool ok = EmailMessageBuilder::Build(cfg, mail, raw, sendErr) &&
+            client.SendMail(cfg, raw, sendErr);
 
         if (ok)
         {
@@ -83,6 +83,12 @@ namespace EmailModule
         return ok;
     }
 
+    void CancelBulkMails()
+    {
+        ::CancelBulkMails();
+        EmailLogger::Info("群发：收到取消请求（通过 API）。");
+    }
+
     bool ShowStatistics(std::string& errorMsg)
     {
         bool ok = ::ShowEmailStatistics(errorMsg);
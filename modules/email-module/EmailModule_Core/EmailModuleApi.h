@@ -22,6 +22,10 @@ namespace EmailModule
     // 内部会自动读取 email.conf 获取 SMTP 配置。
     bool SendBulkMails(std::string& errorMsg);
 
+    // 取消调用时正在进行的群发（从其他线程调用）：正在发送的邮件会完成，其余收件人不再发送，
+    // SendBulkMails 随后返回 false。之后开始的群发不受影响。
+    void CancelBulkMails();
+
     // 显示发送统计信息（在控制台打印），并通过 errorMsg 返回错误。
     bool ShowStatistics(std::string& errorMsg);
 
@@ -0,0 +1,344 @@
+﻿#include "LineConnection.h"
+
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#pragma comment(lib, "Ws2_32.lib")
+
+namespace
+{
+    // 初始接收缓冲区大小；单行超过时按倍数扩容（行长有上限，缓冲区不会无限增长）
+    const size_t INITIAL_BUFFER_SIZE = 4096;
+
+    // 单行的最大长度（不含行尾）。RFC 5321 4.5.3.1.5 规定响应行最多 512 字节（含 CRLF），
+    // POP3 的状态行同样如此；留出余量兼容不严格的服务器，超过时视为协议错误
+    const size_t MAX_LINE_LENGTH = 4096;
+
+    // 每次 recv 至少留出的空间
+    const size_t MIN_RECV_SPACE = 1024;
+
+    // 一次 WSASend 提交的最大片段数
+    const DWORD MAX_SEND_BUFFERS = 64;
+
+    SOCKET AsSocket(std::uintptr_t s)
+    {
+        return static_cast<SOCKET>(s);
+    }
+}
+
+int ParseSmtpReplyCode(std::string_view line)
+{
+    if (line.size() >= 3 &&
+        std::isdigit(static_cast<unsigned char>(line[0])) &&
+        std::isdigit(static_cast<unsigned char>(line[1])) &&
+        std::isdigit(static_cast<unsigned char>(line[2])))
+    {
+        return (line[0] - '0') * 100 +
+            (line[1] - '0') * 10 +
+            (line[2] - '0');
+    }
+    return 0;
+}
+
+LineConnection::LineConnection(std::string& errorMsg)
+    : wsaOk_(false)
+    , socket_(static_cast<std::uintptr_t>(INVALID_SOCKET))
+    , buffer_(INITIAL_BUFFER_SIZE)
+    , readPos_(0)
+    , writePos_(0)
+    , scanPos_(0)
+{
+    WSADATA wsaData{};
+    int r = ::WSAStartup(MAKEWORD(2, 2), &wsaData);
+    if (r != 0)
+    {
+        errorMsg = "WSAStartup 失败，错误码: " + std::to_string(r);
+        return;
+    }
+    wsaOk_ = true;
+}
+
+LineConnection::~LineConnection()
+{
+    Close();
+    if (wsaOk_)
+    {
+        ::WSACleanup();
+    }
+}
+
+void LineConnection::Close()
+{
+    if (AsSocket(socket_) != INVALID_SOCKET)
+    {
+        ::closesocket(AsSocket(socket_));
+        socket_ = static_cast<std::uintptr_t>(INVALID_SOCKET);
+    }
+    readPos_ = writePos_ = scanPos_ = 0;
+}
+
+// --- 连接服务器并设置收发超时 ---
+bool LineConnection::Connect(const std::string& host, int port, int timeoutMs, std::string& errorMsg)
+{
+    Close();
+
+    struct addrinfo hints {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+
+    std::string portStr = std::to_string(port);
+
+    struct addrinfo* result = nullptr;
+    int r = ::getaddrinfo(host.c_str(), portStr.c_str(), &hints, &result);
+    if (r != 0)
+    {
+        errorMsg = "getaddrinfo 失败，错误码: " + std::to_string(r);
+        return false;
+    }
+
+    SOCKET s = INVALID_SOCKET;
+    for (auto ptr = result; ptr != nullptr; ptr = ptr->ai_next)
+    {
+        s = ::socket(ptr->ai_family, ptr->ai_socktype, ptr->ai_protocol);
+        if (s == INVALID_SOCKET)
+        {
+            continue;
+        }
+
+        if (::connect(s, ptr->ai_addr, static_cast<int>(ptr->ai_addrlen)) == SOCKET_ERROR)
+        {
+            ::closesocket(s);
+            s = INVALID_SOCKET;
+            continue;
+        }
+
+        break; // 连接成功
+    }
+
+    ::freeaddrinfo(result);
+
+    if (s == INVALID_SOCKET)
+    {
+        errorMsg = "无法连接到服务器 " + host + ":" + portStr + "。";
+        return false;
+    }
+    socket_ = static_cast<std::uintptr_t>(s);
+
+    if (timeoutMs > 0)
+    {
+        int tv = timeoutMs;
+
+        if (::setsockopt(s, SOL_SOCKET, SO_RCVTIMEO,
+            reinterpret_cast<const char*>(&tv),
+            static_cast<int>(sizeof(tv))) == SOCKET_ERROR)
+        {
+            errorMsg = "设置 socket 读超时时间失败。";
+            return false;
+        }
+
+        if (::setsockopt(s, SOL_SOCKET, SO_SNDTIMEO,
+            reinterpret_cast<const char*>(&tv),
+            static_cast<int>(sizeof(tv))) == SOCKET_ERROR)
+        {
+            errorMsg = "设置 socket 写超时时间失败。";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// --- 发送所有数据 ---
+bool LineConnection::SendAll(const char* data, size_t size, std::string& errorMsg)
+{
+    size_t sentSum = 0;
+
+    while (sentSum < size)
+    {
+        int chunk = static_cast<int>(std::min<size_t>(size - sentSum, 1 << 30));
+        int n = ::send(AsSocket(socket_), data + sentSum, chunk, 0);
+        if (n == SOCKET_ERROR)
+        {
+            int ec = ::WSAGetLastError();
+            errorMsg = "发送数据失败，错误码: " + std::to_string(ec);
+            return false;
+        }
+        if (n == 0)
+        {
+            errorMsg = "发送数据失败：对端关闭连接。";
+            return false;
+        }
+        sentSum += static_cast<size_t>(n);
+    }
+
+    return true;
+}
+
+// --- 聚集写：每次最多提交 MAX_SEND_BUFFERS 个片段，部分发送时从中断处继续 ---
+bool LineConnection::SendVectored(const std::string_view* parts, size_t count, std::string& errorMsg)
+{
+    WSABUF bufs[MAX_SEND_BUFFERS];
+    size_t index = 0;  // 第一个未发完的片段
+    size_t offset = 0; // 该片段中已发送的字节数
+
+    while (index < count)
+    {
+        DWORD  n = 0;
+        size_t batchBytes = 0;
+        for (size_t i = index; i < count && n < MAX_SEND_BUFFERS; ++i)
+        {
+            size_t skip = (i == index) ? offset : 0;
+            if (parts[i].size() == skip)
+                continue;
+            bufs[n].buf = const_cast<char*>(parts[i].data() + skip);
+            bufs[n].len = static_cast<u_long>(parts[i].size() - skip);
+            batchBytes += bufs[n].len;
+            ++n;
+        }
+        if (n == 0)
+            break;
+
+        DWORD sent = 0;
+        if (::WSASend(AsSocket(socket_), bufs, n, &sent, 0, nullptr, nullptr) == SOCKET_ERROR)
+        {
+            int ec = ::WSAGetLastError();
+            errorMsg = "发送数据失败，错误码: " + std::to_string(ec);
+            return false;
+        }
+        if (sent == 0 && batchBytes > 0)
+        {
+            errorMsg = "发送数据失败：对端关闭连接。";
+            return false;
+        }
+
+        // 跳过已完整发送的片段
+        size_t remaining = sent;
+        while (index < count)
+        {
+            size_t left = parts[index].size() - offset;
+            if (remaining < left)
+            {
+                offset += remaining;
+                break;
+            }
+            remaining -= left;
+            ++index;
+            offset = 0;
+        }
+    }
+
+    return true;
+}
+
+size_t LineConnection::SendBufferSize() const
+{
+    int value = 0;
+    int len = static_cast<int>(sizeof(value));
+    if (::getsockopt(AsSocket(socket_), SOL_SOCKET, SO_SNDBUF,
+        reinterpret_cast<char*>(&value), &len) == SOCKET_ERROR || value < 0)
+    {
+        return 0;
+    }
+    return static_cast<size_t>(value);
+}
+
+bool LineConnection::Fill(std::string& errorMsg)
+{
+    if (buffer_.size() - writePos_ < MIN_RECV_SPACE)
+    {
+        // 已读部分不再被引用（行视图在下一次读取前失效），把未读数据移到开头
+        if (readPos_ > 0)
+        {
+            std::memmove(buffer_.data(), buffer_.data() + readPos_, writePos_ - readPos_);
+            writePos_ -= readPos_;
+            scanPos_ -= readPos_;
+            readPos_ = 0;
+        }
+        if (buffer_.size() - writePos_ < MIN_RECV_SPACE)
+        {
+            buffer_.resize(buffer_.size() * 2);
+        }
+    }
+
+    int n = ::recv(AsSocket(socket_), buffer_.data() + writePos_,
+        static_cast<int>(buffer_.size() - writePos_), 0);
+    if (n == SOCKET_ERROR)
+    {
+        int ec = ::WSAGetLastError();
+        errorMsg = "接收数据失败，错误码: " + std::to_string(ec);
+        return false;
+    }
+    if (n == 0)
+    {
+        errorMsg = "接收数据失败：服务器关闭连接。";
+        return false;
+    }
+
+    writePos_ += static_cast<size_t>(n);
+    return true;
+}
+
+// --- 读取一行：在缓冲区中查找 '\n'，找不到时继续接收 ---
+bool LineConnection::ReadLine(std::string_view& line, std::string& errorMsg)
+{
+    for (;;)
+    {
+        const char* begin = buffer_.data() + scanPos_;
+        const void* nl = std::memchr(begin, '\n', writePos_ - scanPos_);
+        if (nl != nullptr)
+        {
+            const char* start = buffer_.data() + readPos_;
+            size_t      length = static_cast<const char*>(nl) - start;
+            if (length > 0 && start[length - 1] == '\r')
+            {
+                --length;
+            }
+            line = std::string_view(start, length);
+
+            readPos_ = static_cast<size_t>(static_cast<const char*>(nl) - buffer_.data()) + 1;
+            scanPos_ = readPos_;
+            if (readPos_ == writePos_)
+            {
+                // 缓冲区已读空：下次接收从头开始，不需要移动数据
+                readPos_ = writePos_ = scanPos_ = 0;
+            }
+            return true;
+        }
+
+        scanPos_ = writePos_;
+        if (writePos_ - readPos_ > MAX_LINE_LENGTH)
+        {
+            errorMsg = "服务器响应行过长（超过 " + std::to_string(MAX_LINE_LENGTH) + " 字节），已放弃读取。";
+            return false;
+        }
+        if (!Fill(errorMsg))
+        {
+            return false;
+        }
+    }
+}
+
+bool LineConnection::ReadSmtpReply(int& codeOut, std::string& textOut, std::string& errorMsg)
+{
+    textOut.clear();
+    codeOut = 0;
+
+    std::string_view line;
+    while (ReadLine(line, errorMsg))
+    {
+        textOut.append(line.data(), line.size());
+        codeOut = ParseSmtpReplyCode(line);
+        if (codeOut != 0 && line.size() > 3 && line[3] == '-')
+        {
+            textOut += "\r\n";
+            continue; // 多行响应的中间行
+        }
+        return true;
+    }
+    return false;
+}
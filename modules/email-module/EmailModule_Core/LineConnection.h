@@ -0,0 +1,58 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// --- 解析 SMTP 响应行前三位数字为 code，不是数字时返回 0 ---
+int ParseSmtpReplyCode(std::string_view line);
+
+// 面向行的文本协议连接（SMTP、POP3 共用），阻塞式 WinSock
+// - 构造时调用 WSAStartup，析构时关闭 socket 并 WSACleanup
+// - 接收缓冲区跨读取保留：一次 recv 可能包含多行或下一条响应的开头，不会丢弃
+// - ReadLine 返回指向接收缓冲区的行视图（不复制），下一次读取前有效
+class LineConnection
+{
+public:
+    explicit LineConnection(std::string& errorMsg);
+    ~LineConnection();
+
+    LineConnection(const LineConnection&) = delete;
+    LineConnection& operator=(const LineConnection&) = delete;
+
+    bool IsOk() const { return wsaOk_; }
+
+    // 依次尝试解析出的每个地址；timeoutMs > 0 时设置收发超时
+    bool Connect(const std::string& host, int port, int timeoutMs, std::string& errorMsg);
+    void Close();
+
+    bool SendAll(const char* data, size_t size, std::string& errorMsg);
+    bool SendAll(const std::string& data, std::string& errorMsg)
+    {
+        return SendAll(data.data(), data.size(), errorMsg);
+    }
+
+    // 聚集写（WSASend）：一次系统调用发送多个不连续的片段，不先拼接成一个缓冲区
+    bool SendVectored(const std::string_view* parts, size_t count, std::string& errorMsg);
+
+    // socket 发送缓冲区大小（SO_SNDBUF），获取失败时返回 0
+    size_t SendBufferSize() const;
+
+    // 读取一行，line 不含行尾的 "\r\n"（也接受单独的 "\n"）；行长超过上限（见 LineConnection.cpp）时失败
+    bool ReadLine(std::string_view& line, std::string& errorMsg);
+
+    // SMTP：读取一条完整响应，多行响应 "250-..." 读到最后一行 "250 ..."，各行以 "\r\n" 连接
+    bool ReadSmtpReply(int& codeOut, std::string& textOut, std::string& errorMsg);
+
+private:
+    // 接收更多数据：先把未读数据移到缓冲区开头，仍然放不下时扩容
+    bool Fill(std::string& errorMsg);
+
+    bool              wsaOk_;
+    std::uintptr_t    socket_;   // SOCKET
+    std::vector<char> buffer_;
+    size_t            readPos_;  // 未读数据起点
+    size_t            writePos_; // 未读数据终点
+    size_t            scanPos_;  // 已确认不含 '\n' 的位置，避免重复扫描
+};
@@ -0,0 +1,158 @@
+﻿#include "MappedFile.h"
+#include "Base64.h"
+
+#include <windows.h>
+
+namespace
+{
+    // MapViewOfFile 的偏移必须是分配粒度（通常为 64 KB）的整数倍
+    unsigned long long AllocationGranularity()
+    {
+        static const unsigned long long granularity = []() {
+            SYSTEM_INFO info{};
+            ::GetSystemInfo(&info);
+            return static_cast<unsigned long long>(info.dwAllocationGranularity ? info.dwAllocationGranularity : 65536);
+        }();
+        return granularity;
+    }
+}
+
+MappedFile::MappedFile()
+    : file_(INVALID_HANDLE_VALUE)
+    , mapping_(nullptr)
+    , view_(nullptr)
+    , size_(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const std::string& path, std::string& errorMsg)
+{
+    Close();
+    path_ = path;
+
+    file_ = ::CreateFileA(path.c_str(), GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE)
+    {
+        errorMsg = "无法打开文件: " + path;
+        return false;
+    }
+
+    LARGE_INTEGER size{};
+    if (!::GetFileSizeEx(file_, &size))
+    {
+        errorMsg = "无法获取文件大小: " + path;
+        Close();
+        return false;
+    }
+    size_ = static_cast<unsigned long long>(size.QuadPart);
+
+    // 空文件不能创建映射，也没有内容需要映射
+    if (size_ > 0)
+    {
+        mapping_ = ::CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_ == nullptr)
+        {
+            errorMsg = "创建文件映射失败: " + path;
+            Close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void MappedFile::Close()
+{
+    Unmap();
+    if (mapping_ != nullptr)
+    {
+        ::CloseHandle(mapping_);
+        mapping_ = nullptr;
+    }
+    if (file_ != INVALID_HANDLE_VALUE)
+    {
+        ::CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+    }
+    size_ = 0;
+}
+
+void MappedFile::Unmap()
+{
+    if (view_ != nullptr)
+    {
+        ::UnmapViewOfFile(view_);
+        view_ = nullptr;
+    }
+}
+
+const char* MappedFile::Map(unsigned long long offset, size_t length, std::string& errorMsg)
+{
+    Unmap();
+    if (mapping_ == nullptr || length == 0 || offset + length > size_)
+    {
+        errorMsg = "映射范围超出文件大小: " + path_;
+        return nullptr;
+    }
+
+    const unsigned long long aligned = offset - offset % AllocationGranularity();
+    const size_t             delta = static_cast<size_t>(offset - aligned);
+
+    view_ = ::MapViewOfFile(mapping_, FILE_MAP_READ,
+        static_cast<DWORD>(aligned >> 32), static_cast<DWORD>(aligned & 0xFFFFFFFFull),
+        length + delta);
+    if (view_ == nullptr)
+    {
+        errorMsg = "映射文件失败: " + path_;
+        return nullptr;
+    }
+    return static_cast<const char*>(view_) + delta;
+}
+
+bool EncodeFileBase64(const std::string& path,
+    size_t lineLength,
+    size_t windowBytes,
+    std::string& out,
+    unsigned long long& fileSize,
+    std::string& errorMsg)
+{
+    MappedFile file;
+    if (!file.Open(path, errorMsg))
+        return false;
+    fileSize = file.Size();
+
+    // 窗口必须是整行（不换行时为 3 字节）的整数倍，逐窗口编码的结果才与一次性编码相同
+    const size_t unit = (lineLength > 0) ? ((lineLength < 4) ? 3 : lineLength / 4 * 3) : 3;
+    size_t window = windowBytes / unit * unit;
+    if (window == 0)
+        window = unit;
+
+    // 编码结果的长度可以预先算出，只分配一次
+    const unsigned long long encodedSize = (fileSize + 2) / 3 * 4;
+    const unsigned long long lines = (lineLength > 0) ? (fileSize + unit - 1) / unit : 0;
+    out.reserve(out.size() + static_cast<size_t>(encodedSize + lines * 2));
+
+    for (unsigned long long offset = 0; offset < fileSize; offset += window)
+    {
+        const unsigned long long remaining = fileSize - offset;
+        const size_t n = (remaining < window) ? static_cast<size_t>(remaining) : window;
+
+        const char* data = file.Map(offset, n, errorMsg);
+        if (data == nullptr)
+            return false;
+
+        if (lineLength > 0)
+            Base64::EncodeLinesTo(data, n, out, lineLength);
+        else
+            Base64::EncodeTo(data, n, out);
+    }
+
+    errorMsg.clear();
+    return true;
+}
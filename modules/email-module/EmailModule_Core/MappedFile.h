@@ -0,0 +1,48 @@
+﻿#pragma once
+#include <cstddef>
+#include <string>
+
+// 只读映射的文件（Windows 文件映射）
+// - 可以一次映射整个文件，也可以按窗口映射其中一段，大文件不需要占用等大的地址空间
+// - 映射出的数据直接来自系统文件缓存，不经过 ifstream 缓冲区和中间字符串
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& path, std::string& errorMsg);
+    void Close();
+
+    unsigned long long Size() const { return size_; }
+
+    // 映射 [offset, offset + length) 并返回指向 offset 处的指针，上一次映射的窗口随之失效
+    // （offset 不需要对齐，内部按系统分配粒度向下对齐）
+    const char* Map(unsigned long long offset, size_t length, std::string& errorMsg);
+
+private:
+    void Unmap();
+
+    void*              file_;     // HANDLE
+    void*              mapping_;  // HANDLE，空文件时为 nullptr
+    const void*        view_;     // 当前窗口的起始地址（已对齐）
+    unsigned long long size_;
+    std::string        path_;
+};
+
+// 整个文件作为映射窗口的默认上限：不超过时整体映射，超过时按窗口逐段映射编码
+const size_t DEFAULT_MAP_WINDOW_BYTES = 64 * 1024 * 1024;
+
+// 把文件的 Base64 编码追加到 out，编码器直接读取映射区域
+// - lineLength > 0 时每 lineLength 个字符加 CRLF（MIME 为 76），0 表示不换行
+// - windowBytes：单个映射窗口的最大字节数（向下取整为整行对应的字节数）
+// - fileSize 返回编码的字节数；out 预先按编码后的长度分配一次
+bool EncodeFileBase64(const std::string& path,
+    size_t lineLength,
+    size_t windowBytes,
+    std::string& out,
+    unsigned long long& fileSize,
+    std::string& errorMsg);
@@ -77,12 +77,12 @@ void RunMenu()
             std::cout << "请输入邮件正文（单行，简单版）: ";
             std::getline(std::cin, mail.body);
 
-            std::string raw = EmailMessageBuilder::Build(cfg, mail);
-
+            std::string   raw;
             SmtpClient    client;
             std::string   errorMsg;
             std::cout << "正在发送邮件，请稍候...\n";
-            bool ok = client.SendMail(cfg, raw, errorMsg);
+            bool ok = EmailMessageBuilder::Build(cfg, mail, raw, errorMsg) &&
+                client.SendMail(cfg, raw, errorMsg);
 
             if (ok)
             {
@@ -140,9 +140,10 @@ void RunMenu()
             std::string filePath;
             std::getline(std::cin, filePath);
 
+            // 只登记文件，发送时再分段读取和编码，大附件也不会整体读入内存
             AttachmentInfo att;
             std::string    buildErr;
-            if (!BuildAttachmentFromFile(filePath, att, buildErr))
+            if (!DescribeAttachmentFile(filePath, att, buildErr))
             {
                 std::cout << "构造附件失败：\n" << buildErr << "\n";
                 EmailLogger::Error("构造附件失败: " + buildErr);
@@ -152,12 +153,12 @@ void RunMenu()
                 // 把附件塞到邮件里
                 mail.attachments.push_back(att);
 
-                std::string raw = EmailMessageBuilder::Build(cfg, mail);
+                MimeMessageSource source(cfg, mail);
 
                 SmtpClient  client;
                 std::string sendErr;
                 std::cout << "正在发送带附件的邮件，请稍候...\n";
-                bool ok = client.SendMail(cfg, raw, sendErr);
+                bool ok = client.SendMail(cfg, mail.to, source, sendErr);
                 if (ok)
                 {
                     std::cout << "带附件的邮件发送成功！\n";
@@ -0,0 +1,497 @@
+﻿#include "RecipientCsv.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RECIPIENT_CSV_SSE2 1
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+namespace
+{
+    // 还没有读出收件人时，估算剩余行数所取样的字节数
+    const size_t ESTIMATE_SAMPLE_BYTES = 64 * 1024;
+
+    bool IsBlank(char ch)
+    {
+        return ch == ' ' || ch == '\t' || ch == '\r';
+    }
+
+    std::string_view TrimBlank(const char* begin, const char* end)
+    {
+        while (begin < end && IsBlank(*begin)) ++begin;
+        while (end > begin && IsBlank(end[-1])) --end;
+        return std::string_view(begin, static_cast<size_t>(end - begin));
+    }
+
+    bool EqualsIgnoreCase(std::string_view a, const char* b)
+    {
+        const size_t n = std::strlen(b);
+        if (a.size() != n)
+            return false;
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (std::tolower(static_cast<unsigned char>(a[i])) != b[i])
+                return false;
+        }
+        return true;
+    }
+
+#ifdef RECIPIENT_CSV_SSE2
+    unsigned CountTrailingZeros(unsigned mask)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+    }
+#endif
+
+    // 未加引号字段的结尾：第一个 ',' 或 '\n'，找不到时返回 end
+    // 每次比较 16 字节，字段短时通常第一次比较就能找到
+    const char* FindFieldEnd(const char* p, const char* end)
+    {
+#ifdef RECIPIENT_CSV_SSE2
+        const __m128i comma = _mm_set1_epi8(',');
+        const __m128i newline = _mm_set1_epi8('\n');
+        while (end - p >= 16)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+                _mm_or_si128(_mm_cmpeq_epi8(v, comma), _mm_cmpeq_epi8(v, newline))));
+            if (mask != 0)
+                return p + CountTrailingZeros(mask);
+            p += 16;
+        }
+#endif
+        while (p < end && *p != ',' && *p != '\n') ++p;
+        return p;
+    }
+
+    // 引号字段的内容："" 还原为 "
+    void AppendUnquoted(std::string& out, std::string_view content)
+    {
+        for (size_t i = 0; i < content.size(); ++i)
+        {
+            out.push_back(content[i]);
+            if (content[i] == '"' && i + 1 < content.size() && content[i + 1] == '"')
+                ++i;
+        }
+    }
+
+    const char* FindChar(const char* p, const char* end, char ch)
+    {
+        const void* hit = std::memchr(p, ch, static_cast<size_t>(end - p));
+        return hit ? static_cast<const char*>(hit) : end;
+    }
+}
+
+// --- RecipientBlock ---
+
+void RecipientBlock::Reset(size_t columnCount, int emailColumn, int nameColumn)
+{
+    data_.clear();
+    fields_.clear();
+    lines_.clear();
+    invalid_.clear();
+    columnCount_ = columnCount;
+    emailColumn_ = emailColumn;
+    nameColumn_ = nameColumn;
+}
+
+void RecipientBlock::BeginRow(size_t lineNumber)
+{
+    rowStart_ = fields_.size();
+    rowData_ = data_.size();
+    lines_.push_back(lineNumber);
+}
+
+void RecipientBlock::AddField(std::string_view value)
+{
+    fields_.emplace_back(data_.size(), value.size());
+    data_.append(value.data(), value.size());
+}
+
+void RecipientBlock::AddQuotedField(std::string_view content)
+{
+    const size_t start = data_.size();
+    AppendUnquoted(data_, content);
+    fields_.emplace_back(start, data_.size() - start);
+}
+
+void RecipientBlock::EndRow()
+{
+    while (fields_.size() - rowStart_ < columnCount_)
+    {
+        fields_.emplace_back(data_.size(), 0);
+    }
+}
+
+void RecipientBlock::CancelRow()
+{
+    fields_.resize(rowStart_);
+    data_.resize(rowData_);
+    lines_.pop_back();
+}
+
+void RecipientBlock::AddInvalidRow(size_t lineNumber, std::string_view text)
+{
+    invalid_.emplace_back(lineNumber, std::string(text));
+}
+
+// --- RecipientCsvReader ---
+
+RecipientCsvReader::RecipientCsvReader(size_t windowBytes)
+    : windowBytes_(windowBytes > 0 ? windowBytes : DEFAULT_MAP_WINDOW_BYTES)
+{
+}
+
+bool RecipientCsvReader::Open(const std::string& path, std::string& errorMsg)
+{
+    if (!file_.Open(path, errorMsg))
+        return false;
+
+    offset_ = 0;
+    begin_ = end_ = pos_ = nullptr;
+    atEof_ = (file_.Size() == 0);
+    mapBytes_ = windowBytes_;
+    lineNumber_ = 1;
+    rowsRead_ = 0;
+    columns_ = { "email", "name" };
+    hasHeader_ = false;
+    emailColumn_ = 0;
+    nameColumn_ = 1;
+
+    if (!atEof_ && !Refill(false, errorMsg))
+        return false;
+
+    // UTF-8 BOM
+    while (end_ - pos_ < 3 && !atEof_)
+    {
+        if (!Refill(true, errorMsg))
+            return false;
+    }
+    if (end_ - pos_ >= 3 && std::memcmp(pos_, "\xEF\xBB\xBF", 3) == 0)
+        pos_ += 3;
+
+    // 第一条记录中有 email 字段时作为表头
+    Record record;
+    while (true)
+    {
+        const Status status = ParseRecord(record);
+        if (status == Status::Incomplete)
+        {
+            if (!Refill(pos_ == begin_, errorMsg))
+                return false;
+            continue;
+        }
+        if (status == Status::Skipped)
+        {
+            Advance(record);
+            continue;
+        }
+        if (status == Status::End)
+            break;
+
+        std::vector<std::string> names;
+        int emailColumn = -1;
+        int nameColumn = -1;
+        if (!record.quoteError)
+        {
+            for (const auto& f : record.fields)
+            {
+                std::string name;
+                if (f.quoted)
+                    AppendUnquoted(name, f.value);
+                else
+                    name.assign(f.value.data(), f.value.size());
+
+                if (emailColumn < 0 && EqualsIgnoreCase(name, "email"))
+                    emailColumn = static_cast<int>(names.size());
+                else if (nameColumn < 0 && EqualsIgnoreCase(name, "name"))
+                    nameColumn = static_cast<int>(names.size());
+                names.push_back(std::move(name));
+            }
+        }
+        if (emailColumn >= 0)
+        {
+            columns_ = std::move(names);
+            hasHeader_ = true;
+            emailColumn_ = emailColumn;
+            nameColumn_ = nameColumn;
+            Advance(record);
+        }
+        break;
+    }
+
+    errorMsg.clear();
+    return true;
+}
+
+bool RecipientCsvReader::ReadBlock(RecipientBlock& block, size_t maxRows, std::string& errorMsg)
+{
+    block.Reset(columns_.size(), emailColumn_, nameColumn_);
+    errorMsg.clear();
+
+    Record record;
+    while (block.Size() < maxRows)
+    {
+        const Status status = ParseRecord(record);
+        if (status == Status::End)
+            break;
+        if (status == Status::Incomplete)
+        {
+            // 记录跨越窗口：从记录起点重新映射；记录本身比窗口大时扩大窗口
+            if (!Refill(pos_ == begin_, errorMsg))
+            {
+                if (!errorMsg.empty())
+                    return false;
+                break;
+            }
+            continue;
+        }
+        if (status == Status::Skipped)
+        {
+            Advance(record);
+            continue;
+        }
+
+        const std::string_view raw = TrimBlank(record.begin, record.contentEnd);
+        std::string_view       error;
+        if (record.quoteError)
+            error = raw;
+        else if (hasHeader_ && record.fields.size() > columns_.size())
+            error = raw;
+        else if (!hasHeader_ && record.fields.size() < 2)
+            error = raw;
+
+        if (error.empty())
+        {
+            block.BeginRow(lineNumber_);
+            if (hasHeader_)
+            {
+                for (const auto& f : record.fields)
+                {
+                    if (f.quoted)
+                        block.AddQuotedField(f.value);
+                    else
+                        block.AddField(f.value);
+                }
+            }
+            else
+            {
+                // 旧格式：email,name，名字为第一个 ',' 之后的全部内容
+                const auto& email = record.fields[0];
+                if (email.quoted)
+                    block.AddQuotedField(email.value);
+                else
+                    block.AddField(email.value);
+
+                const auto& name = record.fields[1];
+                if (record.fields.size() > 2)
+                    block.AddField(TrimBlank(name.rawBegin, record.contentEnd));
+                else if (name.quoted)
+                    block.AddQuotedField(name.value);
+                else
+                    block.AddField(name.value);
+            }
+            block.EndRow();
+
+            if (block.Email(block.Size() - 1).empty())
+            {
+                block.CancelRow();
+                block.AddInvalidRow(lineNumber_, raw);
+            }
+            else
+            {
+                ++rowsRead_;
+            }
+        }
+        else
+        {
+            block.AddInvalidRow(lineNumber_, error);
+        }
+        Advance(record);
+    }
+
+    return block.Size() > 0 || !block.InvalidRows().empty();
+}
+
+unsigned long long RecipientCsvReader::BytesRemaining() const
+{
+    const unsigned long long consumed = offset_ + static_cast<unsigned long long>(pos_ - begin_);
+    return (file_.Size() > consumed) ? file_.Size() - consumed : 0;
+}
+
+size_t RecipientCsvReader::EstimateRemainingRows() const
+{
+    const unsigned long long remaining = BytesRemaining();
+    const unsigned long long consumed = file_.Size() - remaining;
+    if (rowsRead_ > 0 && consumed > 0)
+        return static_cast<size_t>(static_cast<double>(remaining) * rowsRead_ / consumed + 0.5);
+
+    // 还没有读出收件人：数一数已映射窗口开头 ESTIMATE_SAMPLE_BYTES 字节内的换行
+    const size_t sampleBytes = (std::min)(static_cast<size_t>(end_ - pos_), ESTIMATE_SAMPLE_BYTES);
+    if (sampleBytes == 0)
+        return 0;
+    const size_t lines = static_cast<size_t>(std::count(pos_, pos_ + sampleBytes, '\n'));
+    if (lines == 0)
+        return 1; // 整段都在一行之内
+    return static_cast<size_t>(static_cast<double>(remaining) * lines / sampleBytes + 0.5);
+}
+
+bool RecipientCsvReader::Refill(bool grow, std::string& errorMsg)
+{
+    errorMsg.clear();
+    if (atEof_)
+        return false;
+
+    const unsigned long long offset = offset_ + static_cast<unsigned long long>(pos_ - begin_);
+    const unsigned long long remaining = file_.Size() - offset;
+    mapBytes_ = grow ? mapBytes_ * 2 : windowBytes_;
+    const size_t length = (remaining < mapBytes_) ? static_cast<size_t>(remaining) : mapBytes_;
+
+    const char* data = file_.Map(offset, length, errorMsg);
+    if (data == nullptr)
+        return false;
+
+    offset_ = offset;
+    begin_ = pos_ = data;
+    end_ = data + length;
+    atEof_ = (offset + length == file_.Size());
+    return true;
+}
+
+RecipientCsvReader::Status RecipientCsvReader::ParseRecord(Record& record) const
+{
+    record.fields.clear();
+    record.quoteError = false;
+    record.newlines = 0;
+    record.begin = pos_;
+
+    const char* p = pos_;
+    if (p == end_)
+        return atEof_ ? Status::End : Status::Incomplete;
+
+    // 空行（包括只有空白的行）和注释行
+    const char* lineEnd = nullptr;
+    if (*p == '#')
+    {
+        lineEnd = FindChar(p, end_, '\n');
+    }
+    else
+    {
+        const char* q = p;
+        while (q < end_ && IsBlank(*q)) ++q;
+        if (q == end_ || *q == '\n')
+            lineEnd = q;
+    }
+    if (lineEnd != nullptr)
+    {
+        if (lineEnd == end_ && !atEof_)
+            return Status::Incomplete;
+        record.contentEnd = lineEnd;
+        record.next = (lineEnd == end_) ? end_ : lineEnd + 1;
+        record.newlines = (lineEnd == end_) ? 0 : 1;
+        return Status::Skipped;
+    }
+
+    while (true)
+    {
+        Field field;
+        field.rawBegin = p;
+
+        const char* q = p;
+        while (q < end_ && (*q == ' ' || *q == '\t')) ++q;
+
+        if (q < end_ && *q == '"')
+        {
+            // 引号字段：找到不是 "" 的 "
+            const char* content = q + 1;
+            const char* close = content;
+            while (true)
+            {
+                close = FindChar(close, end_, '"');
+                if (close == end_ || close + 1 == end_)
+                {
+                    if (!atEof_)
+                        return Status::Incomplete;
+                    break;
+                }
+                if (close[1] != '"')
+                    break;
+                close += 2;
+            }
+
+            if (close == end_)
+            {
+                // 文件结束仍未闭合：整条记录无效
+                record.quoteError = true;
+                record.contentEnd = end_;
+                record.next = end_;
+                record.newlines += static_cast<size_t>(std::count(content, end_, '\n'));
+                return Status::Record;
+            }
+
+            field.quoted = true;
+            field.value = std::string_view(content, static_cast<size_t>(close - content));
+            record.newlines += static_cast<size_t>(std::count(content, close, '\n'));
+
+            p = close + 1;
+            while (p < end_ && IsBlank(*p)) ++p;
+            if (p == end_ && !atEof_)
+                return Status::Incomplete;
+            if (p < end_ && *p != ',' && *p != '\n')
+            {
+                // 闭合引号之后还有其他字符：跳到行尾，整条记录无效
+                record.quoteError = true;
+                p = FindChar(p, end_, '\n');
+                if (p == end_ && !atEof_)
+                    return Status::Incomplete;
+            }
+        }
+        else
+        {
+            const char* fieldEnd = FindFieldEnd(p, end_);
+            if (fieldEnd == end_ && !atEof_)
+                return Status::Incomplete;
+            field.value = TrimBlank(p, fieldEnd);
+            p = fieldEnd;
+        }
+
+        record.fields.push_back(field);
+
+        if (p < end_ && *p == ',')
+        {
+            ++p;
+            continue;
+        }
+
+        // '\n' 或文件末尾
+        record.contentEnd = p;
+        if (p < end_)
+        {
+            record.next = p + 1;
+            ++record.newlines;
+        }
+        else
+        {
+            record.next = end_;
+        }
+        return Status::Record;
+    }
+}
+
+void RecipientCsvReader::Advance(const Record& record)
+{
+    pos_ = record.next;
+    lineNumber_ += record.newlines;
+}
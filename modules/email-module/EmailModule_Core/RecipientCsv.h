@@ -0,0 +1,140 @@
+﻿#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "MappedFile.h"
+
+// 一块收件人：所有字段依次保存在同一个缓冲区中，按 (行, 列) 取视图
+// 视图在下一次 Reset 之前有效；每行的字段数都等于列数
+class RecipientBlock
+{
+public:
+    // 清空内容并设置列数，emailColumn / nameColumn 为邮箱列和名字列的下标（没有名字列时为 -1）
+    void Reset(size_t columnCount, int emailColumn, int nameColumn);
+
+    size_t Size() const { return lines_.size(); }
+    size_t ColumnCount() const { return columnCount_; }
+
+    std::string_view Field(size_t row, size_t column) const
+    {
+        const auto& f = fields_[row * columnCount_ + column];
+        return std::string_view(data_.data() + f.first, f.second);
+    }
+    std::string_view Email(size_t row) const { return Field(row, static_cast<size_t>(emailColumn_)); }
+    std::string_view Name(size_t row) const
+    {
+        return (nameColumn_ >= 0) ? Field(row, static_cast<size_t>(nameColumn_)) : std::string_view();
+    }
+
+    // 该行在文件中的行号（从 1 开始；不是从文件读取时为序号）
+    size_t LineNumber(size_t row) const { return lines_[row]; }
+
+    // 格式错误而被跳过的行：(行号, 原文)
+    const std::vector<std::pair<size_t, std::string>>& InvalidRows() const { return invalid_; }
+
+    // 构造：BeginRow 之后依次 AddField，字段数不足时 EndRow 补空字段；CancelRow 撤销最后一行
+    void BeginRow(size_t lineNumber);
+    void AddField(std::string_view value);
+    void AddQuotedField(std::string_view content);  // 引号内的原文，"" 还原为 "
+    void EndRow();
+    void CancelRow();
+    void AddInvalidRow(size_t lineNumber, std::string_view text);
+
+private:
+    std::string                                 data_;
+    std::vector<std::pair<size_t, size_t>>      fields_;   // (偏移, 长度)
+    std::vector<size_t>                         lines_;
+    std::vector<std::pair<size_t, std::string>> invalid_;
+    size_t                                      columnCount_ = 0;
+    size_t                                      rowStart_ = 0;  // 当前行第一个字段在 fields_ 中的下标
+    size_t                                      rowData_ = 0;   // 当前行在 data_ 中的起点
+    int                                         emailColumn_ = 0;
+    int                                         nameColumn_ = -1;
+};
+
+// 收件人 CSV 的流式读取（RFC 4180）
+// - 文件按窗口只读映射，逐块解析，内存占用与文件大小无关
+// - 字段以 ',' 分隔，双引号字段内可以包含 ','、换行和 ""（表示一个 "）；未加引号的字段去掉首尾空白
+// - 空行和以 '#' 开头的行忽略
+// - 第一条记录中有名为 email 的字段（不区分大小写）时作为表头，各列按表头命名；
+//   否则按旧格式 "email,name" 读取，名字为第一个 ',' 之后的全部内容（与原来的逐行解析相同）
+// - 邮箱为空、引号不配对或字段数多于表头的行跳过，记录在块的 InvalidRows 中
+class RecipientCsvReader
+{
+public:
+    explicit RecipientCsvReader(size_t windowBytes = DEFAULT_MAP_WINDOW_BYTES);
+
+    // 打开文件并读取表头
+    bool Open(const std::string& path, std::string& errorMsg);
+
+    // 列名（无表头时为 "email"、"name"）
+    const std::vector<std::string>& Columns() const { return columns_; }
+    bool HasHeader() const { return hasHeader_; }
+
+    // 读取下一块（最多 maxRows 个有效收件人）
+    // 返回 false：文件已读完（errorMsg 为空）或映射失败（errorMsg 非空）
+    // 返回 true 时块中可能没有有效收件人（只有被跳过的行）
+    bool ReadBlock(RecipientBlock& block, size_t maxRows, std::string& errorMsg);
+
+    // 已读出的有效收件人数
+    size_t RowsRead() const { return rowsRead_; }
+
+    // 文件中尚未读取的字节数
+    unsigned long long BytesRemaining() const;
+
+    // 估算尚未读出的有效收件人数：按已读部分每个收件人的平均字节数折算剩余字节，不解析剩余部分
+    // （取消群发时统计未发送的数量）；还没有读出收件人时按当前窗口开头一段的行数估算
+    size_t EstimateRemainingRows() const;
+
+private:
+    enum class Status
+    {
+        Record,      // 一条记录
+        Skipped,     // 空行或注释行
+        Incomplete,  // 窗口内找不到记录结尾，需要重新映射
+        End          // 文件结束
+    };
+
+    struct Field
+    {
+        const char*      rawBegin = nullptr;  // 字段在原文中的起点（',' 之后）
+        std::string_view value;               // 引号字段为引号内的原文（"" 尚未还原）
+        bool             quoted = false;
+    };
+
+    struct Record
+    {
+        std::vector<Field> fields;
+        const char*        begin = nullptr;
+        const char*        contentEnd = nullptr;  // 不含结尾的 '\n'
+        const char*        next = nullptr;        // 下一条记录的起点
+        size_t             newlines = 0;          // 记录包含的换行数
+        bool               quoteError = false;
+    };
+
+    // 从 pos_ 解析一条记录，字段视图指向当前窗口
+    Status ParseRecord(Record& record) const;
+    void Advance(const Record& record);
+
+    // 从当前记录起点重新映射一个窗口；grow 时窗口扩大一倍（单条记录大于窗口）
+    // 没有更多数据（errorMsg 为空）或映射失败时返回 false
+    bool Refill(bool grow, std::string& errorMsg);
+
+    MappedFile               file_;
+    size_t                   windowBytes_;
+    size_t                   mapBytes_ = 0;       // 当前窗口大小（单条记录超过窗口时扩大）
+    unsigned long long       offset_ = 0;         // 当前窗口的文件偏移
+    const char*              begin_ = nullptr;    // 当前窗口 [begin_, end_)
+    const char*              end_ = nullptr;
+    const char*              pos_ = nullptr;      // 下一条记录的起点
+    bool                     atEof_ = false;      // 当前窗口是否到达文件末尾
+    size_t                   lineNumber_ = 1;     // pos_ 所在的行号
+    std::vector<std::string> columns_;
+    bool                     hasHeader_ = false;
+    int                      emailColumn_ = 0;
+    int                      nameColumn_ = 1;
+    size_t                   rowsRead_ = 0;
+};
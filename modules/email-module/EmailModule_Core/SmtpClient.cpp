@@ -1,438 +1,618 @@
 ﻿#include "SmtpClient.h"
+#include "LineConnection.h"
+#include "SmtpDataEncoder.h"
 #include "Utils.h"
 #include "Config.h"
 
-#include <winsock2.h>
-#include <ws2tcpip.h>
-
+#include <algorithm>
+#include <map>
 #include <sstream>
 #include <string>
-
-#pragma comment(lib, "Ws2_32.lib")
+#include <vector>
 
 namespace
 {
-    // --- RAII 封装 WSAStartup/WSACleanup ---
-    class WsaSession
+    // 421：服务器即将关闭传输通道（RFC 5321 3.8），需要重新连接
+    const int SMTP_SERVICE_CLOSING = 421;
+
+    // BDAT 块大小的范围（实际取 socket 发送缓冲区大小）
+    const size_t MIN_BDAT_CHUNK = 16 * 1024;
+    const size_t MAX_BDAT_CHUNK = 1024 * 1024;
+
+    // 服务器支持 PIPELINING 时，最多连续发送多少个 BDAT 块而不等待响应
+    const size_t MAX_PIPELINED_CHUNKS = 32;
+
+    // --- 从原始邮件中解析 To 地址 ---
+    // 假定有一行形如：To: demo@test.com
+    static std::string ExtractToAddress(const std::string& raw)
     {
-    public:
-        explicit WsaSession(std::string& errorMsg)
-            : ok_(false)
-        {
-            WSADATA wsaData{};
-            int r = ::WSAStartup(MAKEWORD(2, 2), &wsaData);
-            if (r != 0)
-            {
-                errorMsg = "WSAStartup 失败，错误码: " + std::to_string(r);
-                return;
-            }
-            ok_ = true;
-        }
+        const std::string key = "\nTo:";
+        auto pos = raw.find("To:");
+        if (pos == std::string::npos)
+            return {};
 
-        ~WsaSession()
+        pos += 3; // 跳过 "To:"
+        // 跳过空格
+        while (pos < raw.size() &&
+            (raw[pos] == ' ' || raw[pos] == '\t'))
         {
-            if (ok_)
-            {
-                ::WSACleanup();
-            }
+            ++pos;
         }
 
-        bool IsOk() const { return ok_; }
-
-    private:
-        bool ok_;
-    };
+        auto end = raw.find('\n', pos);
+        std::string line =
+            (end == std::string::npos)
+            ? raw.substr(pos)
+            : raw.substr(pos, end - pos);
 
-    // --- RAII 封装 SOCKET ---
-    class TcpSocket
-    {
-    public:
-        TcpSocket()
-            : s_(INVALID_SOCKET)
+        // 如果有 <...>，取中间这一段
+        auto lt = line.find('<');
+        auto gt = line.find('>');
+        std::string addr;
+        if (lt != std::string::npos &&
+            gt != std::string::npos &&
+            gt > lt + 1)
         {
+            addr = line.substr(lt + 1, gt - lt - 1);
         }
-
-        ~TcpSocket()
+        else
         {
-            if (s_ != INVALID_SOCKET)
-            {
-                ::closesocket(s_);
-                s_ = INVALID_SOCKET;
-            }
+            addr = line;
         }
 
-        bool Connect(const std::string& host, int port, std::string& errorMsg)
+        // 简单 trim
+        while (!addr.empty() &&
+            (addr.front() == ' ' ||
+                addr.front() == '\t'))
         {
-            struct addrinfo hints {};
-            hints.ai_family = AF_UNSPEC;
-            hints.ai_socktype = SOCK_STREAM;
-            hints.ai_protocol = IPPROTO_TCP;
+            addr.erase(addr.begin());
+        }
+        while (!addr.empty() &&
+            (addr.back() == ' ' ||
+                addr.back() == '\t' ||
+                addr.back() == '\r'))
+        {
+            addr.pop_back();
+        }
 
-            std::string portStr = std::to_string(port);
+        return addr;
+    }
 
-            struct addrinfo* result = nullptr;
-            int r = ::getaddrinfo(host.c_str(), portStr.c_str(), &hints, &result);
-            if (r != 0)
-            {
-                errorMsg = "getaddrinfo 失败，错误码: " + std::to_string(r);
-                return false;
-            }
+} // namespace
 
-            for (auto ptr = result; ptr != nullptr; ptr = ptr->ai_next)
-            {
-                s_ = ::socket(ptr->ai_family, ptr->ai_socktype, ptr->ai_protocol);
-                if (s_ == INVALID_SOCKET)
-                {
-                    continue;
-                }
-
-                if (::connect(s_, ptr->ai_addr, static_cast<int>(ptr->ai_addrlen)) == SOCKET_ERROR)
-                {
-                    ::closesocket(s_);
-                    s_ = INVALID_SOCKET;
-                    continue;
-                }
-
-                break; // 连接成功
-            }
+// --- 一个已完成握手的 SMTP 连接 ---
+struct SmtpSession::Connection
+{
+    explicit Connection(std::string& errorMsg)
+        : line(errorMsg)
+    {
+    }
 
-            ::freeaddrinfo(result);
+    LineConnection line;
+    int         messageCount = 0;  // 本连接上已成功发送的邮件数
+    bool        needReset = false; // 上一个事务被拒绝，下一封之前需要 RSET
 
-            if (s_ == INVALID_SOCKET)
+    // EHLO 响应中声明的扩展：关键字（大写）→ 参数，例如 "SIZE" → "10240000"
+    std::map<std::string, std::string> extensions;
+
+    bool Supports(const std::string& keyword) const
+    {
+        return extensions.find(keyword) != extensions.end();
+    }
+
+    // --- EHLO 声明的 SIZE 上限（RFC 1870），未声明或为 0 时返回 0（无限制） ---
+    long long MaxMessageSize() const
+    {
+        auto it = extensions.find("SIZE");
+        if (it == extensions.end())
+            return 0;
+        try
+        {
+            return std::stoll(it->second);
+        }
+        catch (...)
+        {
+            return 0;
+        }
+    }
+
+    // --- 解析多行 EHLO 响应：第一行是服务器域名，之后每行一个扩展 ---
+    void ParseExtensions(const std::string& ehloReply)
+    {
+        extensions.clear();
+
+        std::istringstream iss(ehloReply);
+        std::string line;
+        bool first = true;
+        while (std::getline(iss, line))
+        {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (first || line.size() <= 4)
             {
-                errorMsg = "无法连接到 SMTP 服务器。";
-                return false;
+                first = false;
+                continue;
             }
 
-            return true;
+            std::string text = line.substr(4); // 跳过 "250-" / "250 "
+            auto space = text.find(' ');
+            std::string keyword = text.substr(0, space);
+            std::transform(keyword.begin(), keyword.end(), keyword.begin(),
+                [](unsigned char ch) { return static_cast<char>(std::toupper(ch)); });
+            extensions[keyword] = (space == std::string::npos) ? std::string() : text.substr(space + 1);
         }
+    }
+
+    // --- 读取一条完整响应（多行响应 "250-..." 读到最后一行 "250 ..."） ---
+    bool ReadReply(int& codeOut, std::string& textOut, std::string& errorMsg)
+    {
+        return line.ReadSmtpReply(codeOut, textOut, errorMsg);
+    }
+
+    // --- 读取响应并检查类别（2xx / 3xx 等）；errorPrefix 为空时使用 "SMTP 错误(code): " ---
+    Result Expect(int expectClass, const char* errorPrefix, std::string& errorMsg)
+    {
+        int         code = 0;
+        std::string resp;
+        if (!ReadReply(code, resp, errorMsg))
+            return Result::ConnectionLost;
 
-        SOCKET Get() const { return s_; }
+        if (code / 100 == expectClass)
+            return Result::Ok;
 
-    private:
-        SOCKET s_;
-    };
+        errorMsg = (errorPrefix != nullptr)
+            ? errorPrefix + resp
+            : "SMTP 错误(" + std::to_string(code) + "): " + resp;
+        return (code == SMTP_SERVICE_CLOSING) ? Result::ConnectionLost : Result::Rejected;
+    }
 
-    // --- 发送所有数据 ---
-    bool SendAll(SOCKET s, const std::string& data, std::string& errorMsg)
+    // --- 发送命令并期望某个响应类别 ---
+    Result Command(const std::string& cmd, int expectClass, std::string& errorMsg)
     {
-        const char* buf = data.c_str();
-        int         toSend = static_cast<int>(data.size());
-        int         sentSum = 0;
+        if (!line.SendAll(cmd + "\r\n", errorMsg))
+            return Result::ConnectionLost;
+
+        return Expect(expectClass, nullptr, errorMsg);
+    }
 
-        while (sentSum < toSend)
+    // --- DATA 之后流式发送正文：每读取一段就编码（CRLF 规范化、点填充）并用聚集写发出 ---
+    // 结束行与最后一段一起发出，避免单独的小包被 Nagle 算法延迟
+    Result SendData(MessageSource& source, std::string& errorMsg)
+    {
+        if (!source.Rewind(errorMsg))
+            return Result::Aborted; // 正文无法读取，DATA 已开始，只能放弃此连接
+
+        SmtpDataEncoder               encoder;
+        std::vector<std::string_view> parts;
+        std::string_view              chunk;
+        bool                          isLast = false;
+        while (!isLast)
         {
-            int n = ::send(s, buf + sentSum, toSend - sentSum, 0);
-            if (n == SOCKET_ERROR)
-            {
-                int ec = ::WSAGetLastError();
-                errorMsg = "发送数据失败，错误码: " + std::to_string(ec);
-                return false;
-            }
-            if (n == 0)
-            {
-                errorMsg = "发送数据失败：对端关闭连接。";
-                return false;
-            }
-            sentSum += n;
+            // 不能发送结束行：否则服务器会接受一封不完整的邮件
+            if (!source.Next(chunk, isLast, errorMsg))
+                return Result::Aborted;
+
+            parts.clear();
+            encoder.Encode(chunk, parts);
+            if (isLast)
+                encoder.Finish(parts);
+
+            if (!line.SendVectored(parts.data(), parts.size(), errorMsg))
+                return Result::ConnectionLost;
         }
 
-        return true;
+        return Expect(2, "发送邮件失败: ", errorMsg);
     }
 
-    // --- 读取一行响应（直到 \r\n）并解析前三位数字为 code ---
-    bool ReadResponse(SOCKET s, int& codeOut, std::string& textOut, std::string& errorMsg)
+    // --- BDAT 分块发送正文（RFC 3030）：每块 "BDAT <字节数>[ LAST]" 后紧跟数据，不做点填充 ---
+    // 块大小取 socket 发送缓冲区大小；服务器支持 PIPELINING 时连续发送，
+    // 最多 MAX_PIPELINED_CHUNKS 块未确认。某一块被拒绝后不再发送，读完已发送块的响应后 RSET
+    Result SendBdat(MessageSource& source, std::string& errorMsg)
     {
-        textOut.clear();
-        codeOut = 0;
+        if (!source.Rewind(errorMsg))
+        {
+            needReset = true;
+            return Result::Rejected; // 还没有发送任何 BDAT，事务可以复位
+        }
+        source.SetPreferredChunkSize(
+            (std::min)((std::max)(line.SendBufferSize(), MIN_BDAT_CHUNK), MAX_BDAT_CHUNK));
 
-        char buf[512];
+        const size_t window = Supports("PIPELINING") ? MAX_PIPELINED_CHUNKS : 1;
 
-        while (true)
+        SmtpDataEncoder               encoder(SmtpDataEncoder::Mode::Bdat);
+        std::vector<std::string_view> parts;
+        std::string                   header;
+        std::string_view              chunk;
+        bool                          isLast = false;
+        size_t                        outstanding = 0;
+        std::string                   firstError;
+
+        auto readChunkReply = [&]() -> bool
         {
-            int n = ::recv(s, buf, sizeof(buf) - 1, 0);
-            if (n == SOCKET_ERROR)
-            {
-                int ec = ::WSAGetLastError();
-                errorMsg = "接收数据失败，错误码: " + std::to_string(ec);
+            int         code = 0;
+            std::string resp;
+            if (!ReadReply(code, resp, errorMsg))
                 return false;
-            }
-            if (n == 0)
+            --outstanding;
+            if (code == SMTP_SERVICE_CLOSING)
             {
-                errorMsg = "接收数据失败：服务器关闭连接。";
+                errorMsg = "SMTP 错误(" + std::to_string(code) + "): " + resp;
                 return false;
             }
+            if (code / 100 != 2 && firstError.empty())
+                firstError = "发送邮件失败: " + resp;
+            return true;
+        };
 
-            buf[n] = '\0';
-            textOut += buf;
-
-            auto pos = textOut.find("\r\n");
-            if (pos != std::string::npos)
+        while (!isLast && firstError.empty())
+        {
+            if (!source.Next(chunk, isLast, errorMsg))
+                return Result::Aborted; // 已发送部分 BDAT，无法在本连接上结束事务
+
+            parts.clear();
+            parts.emplace_back(); // 占位：BDAT 命令
+            encoder.Encode(chunk, parts);
+            if (isLast)
+                encoder.Finish(parts);
+
+            size_t size = 0;
+            for (size_t i = 1; i < parts.size(); ++i)
+                size += parts[i].size();
+            header = "BDAT " + std::to_string(size) + (isLast ? " LAST\r\n" : "\r\n");
+            parts[0] = header;
+
+            if (!line.SendVectored(parts.data(), parts.size(), errorMsg))
+                return Result::ConnectionLost;
+            ++outstanding;
+
+            while (outstanding >= window || (isLast && outstanding > 0))
             {
-                std::string line = textOut.substr(0, pos);
-                if (line.size() >= 3 &&
-                    std::isdigit(static_cast<unsigned char>(line[0])) &&
-                    std::isdigit(static_cast<unsigned char>(line[1])) &&
-                    std::isdigit(static_cast<unsigned char>(line[2])))
-                {
-                    codeOut = (line[0] - '0') * 100 +
-                        (line[1] - '0') * 10 +
-                        (line[2] - '0');
-                }
-                else
-                {
-                    codeOut = 0;
-                }
-
-                return true;
+                if (!readChunkReply())
+                    return Result::ConnectionLost;
             }
         }
-    }
-
-    // --- 发送命令并期望某个响应类别（2xx / 3xx 等） ---
-    bool SendCommandExpect(SOCKET s,
-        const std::string& cmd,
-        int expectClass,
-        std::string& errorMsg)
-    {
-        std::string toSend = cmd + "\r\n";
-        if (!SendAll(s, toSend, errorMsg))
-            return false;
-
-        int         code = 0;
-        std::string resp;
-        if (!ReadResponse(s, code, resp, errorMsg))
-            return false;
 
-        if (code / 100 != expectClass)
+        while (outstanding > 0)
         {
-            errorMsg = "SMTP 错误(" + std::to_string(code) + "): " + resp;
-            return false;
+            if (!readChunkReply())
+                return Result::ConnectionLost;
         }
 
-        return true;
+        if (!firstError.empty())
+        {
+            needReset = true;
+            errorMsg = firstError;
+            return Result::Rejected;
+        }
+        return Result::Ok;
     }
 
     // --- AUTH LOGIN 认证 ---
-    bool AuthenticateLogin(SOCKET s, const SmtpConfig& cfg, std::string& errorMsg)
+    Result AuthenticateLogin(const SmtpConfig& cfg, std::string& errorMsg)
     {
         // AUTH LOGIN
-        if (!SendCommandExpect(s, "AUTH LOGIN", 3, errorMsg))
-        {
-            return false;
-        }
+        Result r = Command("AUTH LOGIN", 3, errorMsg);
+        if (r != Result::Ok)
+            return r;
 
         // 用户名
-        std::string user64 = Base64Encode(cfg.username);
-        if (!SendCommandExpect(s, user64, 3, errorMsg))
-        {
-            return false;
-        }
+        r = Command(Base64Encode(cfg.username), 3, errorMsg);
+        if (r != Result::Ok)
+            return r;
 
         // 密码
-        std::string pass64 = Base64Encode(cfg.password);
-        if (!SendCommandExpect(s, pass64, 2, errorMsg))
-        {
-            return false;
-        }
-
-        return true;
+        return Command(Base64Encode(cfg.password), 2, errorMsg);
     }
+};
 
-    // --- 设置 socket 收发超时 ---
-    bool SetSocketTimeouts(SOCKET s, int timeoutMs, std::string& errorMsg)
-    {
-        if (timeoutMs <= 0)
-            return true;
+SmtpSession::SmtpSession(const SmtpConfig& cfg)
+    : cfg_(cfg)
+    , connectionCount_(0)
+{
+}
 
-        int tv = timeoutMs;
+SmtpSession::~SmtpSession()
+{
+    Close();
+}
 
-        if (::setsockopt(s, SOL_SOCKET, SO_RCVTIMEO,
-            reinterpret_cast<const char*>(&tv),
-            static_cast<int>(sizeof(tv))) == SOCKET_ERROR)
-        {
-            errorMsg = "设置 socket 读超时时间失败。";
+// --- 建立连接并完成握手：欢迎语 → EHLO → 可选 AUTH LOGIN ---
+bool SmtpSession::Open(std::string& errorMsg)
+{
+    std::unique_ptr<Connection> conn(new Connection(errorMsg));
+    if (!conn->line.IsOk())
+        return false;
+
+    // 连接并设置读写超时
+    if (!conn->line.Connect(cfg_.serverIp, cfg_.port, cfg_.ioTimeoutMs, errorMsg))
+        return false;
+
+    // 服务器欢迎语
+    if (conn->Expect(2, "SMTP 服务器返回错误: ", errorMsg) != Result::Ok)
+        return false;
+
+    // EHLO，记录服务器声明的扩展
+    {
+        if (!conn->line.SendAll("EHLO localhost\r\n", errorMsg))
             return false;
-        }
 
-        if (::setsockopt(s, SOL_SOCKET, SO_SNDTIMEO,
-            reinterpret_cast<const char*>(&tv),
-            static_cast<int>(sizeof(tv))) == SOCKET_ERROR)
+        int         code = 0;
+        std::string resp;
+        if (!conn->ReadReply(code, resp, errorMsg))
+            return false;
+        if (code / 100 != 2)
         {
-            errorMsg = "设置 socket 写超时时间失败。";
+            errorMsg = "SMTP 错误(" + std::to_string(code) + "): " + resp;
             return false;
         }
 
-        return true;
+        conn->ParseExtensions(resp);
     }
 
-    // --- 从原始邮件中解析 To 地址 ---
-    // 假定有一行形如：To: demo@test.com
-    static std::string ExtractToAddress(const std::string& raw)
-    {
-        const std::string key = "\nTo:";
-        auto pos = raw.find("To:");
-        if (pos == std::string::npos)
-            return {};
+    // 如果启用认证，则先 AUTH LOGIN
+    if (cfg_.useAuth && conn->AuthenticateLogin(cfg_, errorMsg) != Result::Ok)
+        return false;
 
-        pos += 3; // 跳过 "To:"
-        // 跳过空格
-        while (pos < raw.size() &&
-            (raw[pos] == ' ' || raw[pos] == '\t'))
-        {
-            ++pos;
-        }
+    conn_ = std::move(conn);
+    ++connectionCount_;
+    return true;
+}
 
-        auto end = raw.find('\n', pos);
-        std::string line =
-            (end == std::string::npos)
-            ? raw.substr(pos)
-            : raw.substr(pos, end - pos);
+// --- QUIT（失败不算致命错误）并关闭连接 ---
+void SmtpSession::Close()
+{
+    if (!conn_)
+        return;
 
-        // 如果有 <...>，取中间这一段
-        auto lt = line.find('<');
-        auto gt = line.find('>');
-        std::string addr;
-        if (lt != std::string::npos &&
-            gt != std::string::npos &&
-            gt > lt + 1)
-        {
-            addr = line.substr(lt + 1, gt - lt - 1);
-        }
-        else
-        {
-            addr = line;
-        }
+    std::string quitErr;
+    conn_->Command("QUIT", 2, quitErr);
+    conn_.reset();
+}
 
-        // 简单 trim
-        while (!addr.empty() &&
-            (addr.front() == ' ' ||
-                addr.front() == '\t'))
+// --- 一个完整的邮件事务：[RSET] → MAIL FROM → RCPT TO × N → DATA → 正文 ---
+// 正文从 source 逐段读取，编码后直接引用数据源的内存发送；
+// 服务器声明 CHUNKING 时用 BDAT 分块代替 DATA，声明 SIZE 时超过上限的邮件不发送任何命令。
+// 服务器声明 PIPELINING（RFC 2920）时，信封命令一次写出，再按顺序读取各自的响应；
+// 否则逐条发送，MAIL FROM 失败或全部收件人被拒绝时不再发送后续命令。
+// 部分收件人被拒绝时，邮件仍发给其余收件人，被拒绝的地址和原因写入 rejected。
+// 重试由 SendToMany 控制。
+SmtpSession::Result SmtpSession::Transaction(const std::vector<std::string>& recipients,
+    MessageSource& source,
+    std::vector<SmtpRejectedRecipient>& rejected,
+    std::string& errorMsg)
+{
+    rejected.clear();
+
+    // 达到单连接上限后换新连接
+    if (conn_ && cfg_.maxMessagesPerConnection > 0 &&
+        conn_->messageCount >= cfg_.maxMessagesPerConnection)
+    {
+        Close();
+    }
+
+    if (!conn_ && !Open(errorMsg))
+        return Result::ConnectionLost;
+
+    Connection& conn = *conn_;
+    const bool pipelining = conn.Supports("PIPELINING");
+    const bool chunking = conn.Supports("CHUNKING");
+
+    // SIZE（RFC 1870）：服务器声明了上限时，按实际发出的字节数（CRLF 规范化、点填充之后）判断，
+    // 超过上限的邮件不发送任何命令，也不重试（重试只会得到同样的结果）。
+    // 编码只会增加字节且至多增加一倍：原始大小已超过上限、或加倍后仍在上限内时不需要逐段计算
+    long long messageSize = source.Size();
+    const long long maxSize = conn.MaxMessageSize();
+    if (maxSize > 0)
+    {
+        if (messageSize < 0 || (messageSize <= maxSize && messageSize * 2 + 2 > maxSize))
         {
-            addr.erase(addr.begin());
+            const SmtpDataEncoder::Mode mode = chunking ? SmtpDataEncoder::Mode::Bdat : SmtpDataEncoder::Mode::Data;
+            if (!SmtpDataEncoder::EncodedSize(source, mode, messageSize, errorMsg))
+                return Result::Aborted;
         }
-        while (!addr.empty() &&
-            (addr.back() == ' ' ||
-                addr.back() == '\t' ||
-                addr.back() == '\r'))
+        if (messageSize > maxSize)
         {
-            addr.pop_back();
+            errorMsg = "邮件大小 " + std::to_string(messageSize) +
+                " 字节超过服务器限制 " + std::to_string(maxSize) + " 字节。";
+            return Result::Aborted;
         }
+    }
 
-        return addr;
+    // 上一个事务中途被拒绝：服务器可能仍保留 MAIL FROM / RCPT TO 状态
+    // （DATA 正常结束后服务器已自动复位，此时不需要额外的 RSET）
+    std::vector<std::string> commands;
+    if (conn.needReset)
+    {
+        commands.push_back("RSET");
+    }
+    const size_t mailIndex = commands.size();
+    std::string mailFrom = "MAIL FROM:<" + cfg_.fromAddress + ">";
+    if (conn.Supports("SIZE") && messageSize >= 0)
+    {
+        mailFrom += " SIZE=" + std::to_string(messageSize);
+    }
+    commands.push_back(mailFrom);
+    for (const auto& rcpt : recipients)
+    {
+        commands.push_back("RCPT TO:<" + rcpt + ">");
+    }
+    // CHUNKING：正文用 BDAT 发送，信封之后没有 DATA 命令（dataIndex 越界，循环不会处理到）
+    const size_t dataIndex = commands.size();
+    if (!chunking)
+    {
+        commands.push_back("DATA");
     }
 
-    // --- 只发送一次的核心逻辑；重试由外层控制 ---
-    bool SendMailOnce(const SmtpConfig& cfg,
-        const std::string& rawMessage,
-        std::string& errorMsg)
+    if (pipelining)
     {
-        WsaSession wsa(errorMsg);
-        if (!wsa.IsOk())
-            return false;
+        std::string batch;
+        for (const auto& cmd : commands)
+        {
+            batch += cmd;
+            batch += "\r\n";
+        }
+        if (!conn.line.SendAll(batch, errorMsg))
+            return Result::ConnectionLost;
+    }
 
-        TcpSocket socket;
-        if (!socket.Connect(cfg.serverIp, cfg.port, errorMsg))
-            return false;
+    bool        mailOk = false;
+    bool        dataOk = chunking;
+    size_t      accepted = 0;
+    std::string firstError;
 
-        // 设置读写超时
-        if (!SetSocketTimeouts(socket.Get(), cfg.ioTimeoutMs, errorMsg))
-            return false;
+    for (size_t i = 0; i < commands.size(); ++i)
+    {
+        if (!pipelining)
+        {
+            // 逐条发送时，前面的命令已失败就不再继续
+            if ((i > mailIndex && !mailOk) || (i == dataIndex && accepted == 0))
+                break;
+            if (!conn.line.SendAll(commands[i] + "\r\n", errorMsg))
+                return Result::ConnectionLost;
+        }
 
         int         code = 0;
         std::string resp;
+        if (!conn.ReadReply(code, resp, errorMsg))
+            return Result::ConnectionLost;
 
-        // 服务器欢迎语
-        if (!ReadResponse(socket.Get(), code, resp, errorMsg))
-            return false;
-        if (code / 100 != 2)
+        const std::string reply = "SMTP 错误(" + std::to_string(code) + "): " + resp;
+        if (code == SMTP_SERVICE_CLOSING)
         {
-            errorMsg = "SMTP 服务器返回错误: " + resp;
-            return false;
+            errorMsg = reply;
+            return Result::ConnectionLost;
         }
 
-        // EHLO
-        if (!SendCommandExpect(socket.Get(), "EHLO localhost", 2, errorMsg))
-            return false;
-
-        // 如果启用认证，则先 AUTH LOGIN
-        if (cfg.useAuth)
+        if (i < mailIndex)
         {
-            if (!AuthenticateLogin(socket.Get(), cfg, errorMsg))
+            if (code / 100 != 2)
             {
-                return false;
+                errorMsg = reply;
+                return Result::ConnectionLost; // 无法复位的连接不再使用
             }
+            conn.needReset = false;
         }
-
-        // MAIL FROM
-        {
-            std::ostringstream cmd;
-            cmd << "MAIL FROM:<" << cfg.fromAddress << ">";
-            if (!SendCommandExpect(socket.Get(), cmd.str(), 2, errorMsg))
-                return false;
-        }
-
-        // RCPT TO
-        std::string toAddr = ExtractToAddress(rawMessage);
-        if (toAddr.empty())
+        else if (i == mailIndex)
         {
-            errorMsg = "无法从邮件内容中解析收件人地址（To）。";
-            return false;
+            mailOk = (code / 100 == 2);
+            if (!mailOk)
+                firstError = reply;
         }
+        else if (i < dataIndex)
         {
-            std::ostringstream cmd;
-            cmd << "RCPT TO:<" << toAddr << ">";
-            if (!SendCommandExpect(socket.Get(), cmd.str(), 2, errorMsg))
-                return false;
+            const std::string& rcpt = recipients[i - mailIndex - 1];
+            if (code / 100 == 2)
+            {
+                ++accepted;
+            }
+            else
+            {
+                rejected.push_back({ rcpt, reply });
+                if (firstError.empty())
+                    firstError = "收件人 " + rcpt + " 被拒绝，" + reply;
+            }
         }
-
-        // DATA
-        if (!SendCommandExpect(socket.Get(), "DATA", 3, errorMsg))
-            return false;
-
-        // 发送正文，末尾确保有 "\r\n.\r\n"
-        std::string dataToSend = rawMessage;
-        if (dataToSend.size() < 5 ||
-            dataToSend.substr(dataToSend.size() - 5) != "\r\n.\r\n")
+        else
         {
-            dataToSend += "\r\n.\r\n";
+            dataOk = (code / 100 == 3);
+            if (!dataOk && firstError.empty())
+                firstError = reply;
         }
+    }
 
-        if (!SendAll(socket.Get(), dataToSend, errorMsg))
-            return false;
-
-        if (!ReadResponse(socket.Get(), code, resp, errorMsg))
-            return false;
-        if (code / 100 != 2)
+    if (!mailOk || accepted == 0 || !dataOk)
+    {
+        // 流水线中 DATA 仍被接受（服务器未校验收件人）：发送空正文结束本次 DATA
+        if (dataOk && !chunking)
         {
-            errorMsg = "发送邮件失败: " + resp;
-            return false;
+            if (!conn.line.SendAll(".\r\n", errorMsg))
+                return Result::ConnectionLost;
+            int         code = 0;
+            std::string resp;
+            if (!conn.ReadReply(code, resp, errorMsg))
+                return Result::ConnectionLost;
         }
+        conn.needReset = true;
+        errorMsg = firstError;
+        return Result::Rejected;
+    }
 
-        // QUIT（失败不算致命错误）
-        std::string quitErr;
-        SendCommandExpect(socket.Get(), "QUIT", 2, quitErr);
+    Result r = chunking
+        ? conn.SendBdat(source, errorMsg)
+        : conn.SendData(source, errorMsg);
+    if (r == Result::Ok)
+    {
+        ++conn.messageCount;
+    }
+    else if (r == Result::Aborted)
+    {
+        // 正文已部分发出：断开连接，服务器丢弃未结束的正文
+        conn_.reset();
+    }
+    return r;
+}
 
-        return true;
+// --- 发送一封邮件：收件人取自邮件头中的 To ---
+bool SmtpSession::Send(const std::string& rawMessage, std::string& errorMsg)
+{
+    std::string toAddr = ExtractToAddress(rawMessage);
+    if (toAddr.empty())
+    {
+        errorMsg = "无法从邮件内容中解析收件人地址（To）。";
+        return false;
     }
-} // namespace
 
-// --- 对外接口：带重试次数 ---
-bool SmtpClient::SendMail(const SmtpConfig& cfg,
+    std::vector<SmtpRejectedRecipient> rejected;
+    return SendToMany(std::vector<std::string>{ toAddr }, rawMessage, rejected, errorMsg);
+}
+
+// --- 一个事务发给多个收件人：带重试次数，连接失效时重连 ---
+bool SmtpSession::SendToMany(const std::vector<std::string>& recipients,
     const std::string& rawMessage,
+    std::vector<SmtpRejectedRecipient>& rejected,
     std::string& errorMsg)
 {
-    int maxAttempt = (cfg.maxRetry < 1) ? 1 : cfg.maxRetry;
+    StringMessageSource source(rawMessage);
+    return SendToMany(recipients, source, rejected, errorMsg);
+}
+
+bool SmtpSession::SendToMany(const std::vector<std::string>& recipients,
+    MessageSource& source,
+    std::vector<SmtpRejectedRecipient>& rejected,
+    std::string& errorMsg)
+{
+    int maxAttempt = (cfg_.maxRetry < 1) ? 1 : cfg_.maxRetry;
+    bool staleRetried = false;
 
     std::string lastError;
     for (int attempt = 1; attempt <= maxAttempt; ++attempt)
     {
-        if (SendMailOnce(cfg, rawMessage, errorMsg))
+        // 复用的连接可能已被服务器因空闲超时关闭
+        bool reused = conn_ && conn_->messageCount > 0;
+
+        Result r = Transaction(recipients, source, rejected, errorMsg);
+        if (r == Result::Ok)
         {
             return true;
         }
 
         lastError = errorMsg;
+
+        if (r == Result::Aborted)
+        {
+            // 数据源出错或邮件超过服务器上限，重试也不会成功
+            return false;
+        }
+
+        if (r == Result::ConnectionLost)
+        {
+            conn_.reset();
+            if (reused && !staleRetried)
+            {
+                staleRetried = true;
+                --attempt; // 在新连接上重发，不计入重试次数
+            }
+        }
     }
 
     if (maxAttempt > 1)
@@ -447,3 +627,22 @@ bool SmtpClient::SendMail(const SmtpConfig& cfg,
 
     return false;
 }
+
+// --- 对外接口：单封邮件使用一次性会话 ---
+bool SmtpClient::SendMail(const SmtpConfig& cfg,
+    const std::string& rawMessage,
+    std::string& errorMsg)
+{
+    SmtpSession session(cfg);
+    return session.Send(rawMessage, errorMsg);
+}
+
+bool SmtpClient::SendMail(const SmtpConfig& cfg,
+    const std::string& to,
+    MessageSource& source,
+    std::string& errorMsg)
+{
+    SmtpSession session(cfg);
+    std::vector<SmtpRejectedRecipient> rejected;
+    return session.SendToMany(std::vector<std::string>{ to }, source, rejected, errorMsg);
+}
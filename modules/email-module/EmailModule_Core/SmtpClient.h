@@ -1,12 +1,86 @@
 ﻿#pragma once
+#include <memory>
 #include <string>
+#include <vector>
 #include "Config.h"
 
+class MessageSource;
+
 // 通过 WinSock 使用 SMTP 协议发送邮件
 class SmtpClient
 {
 public:
     // rawEmail 由 EmailMessageBuilder 构造
     bool SendMail(const SmtpConfig& cfg, const std::string& rawEmail, std::string& errorMsg);
+
+    // 正文从数据源流式读取（例如 MimeMessageSource，附件边读边编码），收件人由调用方给出
+    bool SendMail(const SmtpConfig& cfg, const std::string& to, MessageSource& source, std::string& errorMsg);
+};
+
+// 多收件人事务中被拒绝的收件人及其 RCPT TO 响应
+struct SmtpRejectedRecipient
+{
+    std::string address;
+    std::string reply;
 };
 
+// 持久 SMTP 会话：在同一个连接上依次发送多封邮件（群发使用）
+// - 第一次 Send 时建立连接（连接、欢迎语、EHLO、可选 AUTH LOGIN），之后的邮件直接从 MAIL FROM 开始
+// - 服务器声明 PIPELINING 时，MAIL FROM、全部 RCPT TO 和 DATA 一次写出，按顺序匹配响应
+// - 正文边读边编码（CRLF 规范化、行首点填充）并用聚集写发送，不复制整封邮件
+// - 服务器声明 CHUNKING 时用 BDAT 分块发送（不需要点填充）；声明 SIZE 时编码后超过上限的邮件在发送前判定失败，不重试
+// - 事务中途被拒绝时先 RSET 再发送下一封
+// - 服务器返回 421 或连接断开时自动重连；复用的连接失效后的重发不计入重试次数
+// - 单个连接发送 cfg.maxMessagesPerConnection 封后主动 QUIT，下一封使用新连接
+class SmtpSession
+{
+public:
+    explicit SmtpSession(const SmtpConfig& cfg);
+    ~SmtpSession();
+
+    SmtpSession(const SmtpSession&) = delete;
+    SmtpSession& operator=(const SmtpSession&) = delete;
+
+    // 发送一封邮件（收件人取自邮件头中的 To），失败时最多尝试 cfg.maxRetry 次
+    bool Send(const std::string& rawEmail, std::string& errorMsg);
+
+    // 同一封邮件在一个事务中发给多个收件人（信封收件人与邮件头无关，可用于密送式群发）
+    // 至少一个收件人被接受即返回 true；被拒绝的收件人及原因写入 rejected
+    bool SendToMany(const std::vector<std::string>& recipients,
+        const std::string& rawEmail,
+        std::vector<SmtpRejectedRecipient>& rejected,
+        std::string& errorMsg);
+
+    // 同上，正文从分段数据源流式读取（重试时调用 source.Rewind）
+    bool SendToMany(const std::vector<std::string>& recipients,
+        MessageSource& source,
+        std::vector<SmtpRejectedRecipient>& rejected,
+        std::string& errorMsg);
+
+    // 发送 QUIT 并关闭连接（析构时自动调用）
+    void Close();
+
+    // 本会话累计建立的连接数
+    int ConnectionCount() const { return connectionCount_; }
+
+private:
+    struct Connection;
+
+    enum class Result
+    {
+        Ok,             // 成功
+        Rejected,       // 服务器拒绝，连接仍可用
+        ConnectionLost, // 连接已断开或服务器返回 421
+        Aborted         // 本封邮件无法发送，不重试：正文读取失败（已断开连接），或邮件超过服务器的 SIZE 上限
+    };
+
+    bool   Open(std::string& errorMsg);
+    Result Transaction(const std::vector<std::string>& recipients,
+        MessageSource& source,
+        std::vector<SmtpRejectedRecipient>& rejected,
+        std::string& errorMsg);
+
+    SmtpConfig                  cfg_;
+    std::unique_ptr<Connection> conn_;
+    int                         connectionCount_;
+};
@@ -0,0 +1,175 @@
+﻿#include "SmtpDataEncoder.h"
+
+namespace
+{
+    const std::string_view CRLF("\r\n", 2);
+    const std::string_view LF("\n", 1);
+    const std::string_view DOT(".", 1);
+    const std::string_view END_OF_DATA(".\r\n", 3);
+}
+
+// --- StringMessageSource ---
+
+StringMessageSource::StringMessageSource(const std::string& text, size_t chunkSize)
+    : text_(text)
+    , chunkSize_(chunkSize == 0 ? 1 : chunkSize)
+    , pos_(0)
+{
+}
+
+bool StringMessageSource::Next(std::string_view& chunk, bool& isLast, std::string& errorMsg)
+{
+    (void)errorMsg;
+    size_t n = text_.size() - pos_;
+    if (n > chunkSize_)
+        n = chunkSize_;
+    chunk = std::string_view(text_.data() + pos_, n);
+    pos_ += n;
+    isLast = (pos_ == text_.size());
+    return true;
+}
+
+void StringMessageSource::SetPreferredChunkSize(size_t chunkSize)
+{
+    if (chunkSize > 0)
+        chunkSize_ = chunkSize;
+}
+
+bool StringMessageSource::Rewind(std::string& errorMsg)
+{
+    (void)errorMsg;
+    pos_ = 0;
+    return true;
+}
+
+// --- SmtpDataEncoder ---
+
+SmtpDataEncoder::SmtpDataEncoder(Mode mode)
+    : mode_(mode)
+    , atLineStart_(true)
+    , pendingCr_(false)
+{
+}
+
+void SmtpDataEncoder::Encode(std::string_view chunk, std::vector<std::string_view>& out)
+{
+    size_t start = 0; // 尚未输出的原样片段起点
+
+    for (size_t i = 0; i < chunk.size(); ++i)
+    {
+        const char ch = chunk[i];
+
+        if (pendingCr_)
+        {
+            pendingCr_ = false;
+            if (ch == '\n')
+            {
+                atLineStart_ = true;
+                continue;
+            }
+            // 裸 CR：补一个 LF（CR 已在之前的片段中）
+            if (i > start)
+                out.push_back(chunk.substr(start, i - start));
+            out.push_back(LF);
+            start = i;
+            atLineStart_ = true;
+        }
+
+        if (ch == '\r')
+        {
+            pendingCr_ = true;
+            atLineStart_ = false;
+        }
+        else if (ch == '\n')
+        {
+            // 裸 LF：替换为 CRLF
+            if (i > start)
+                out.push_back(chunk.substr(start, i - start));
+            out.push_back(CRLF);
+            start = i + 1;
+            atLineStart_ = true;
+        }
+        else if (ch == '.' && atLineStart_ && mode_ == Mode::Data)
+        {
+            // 点填充：原来的 "." 留在下一个片段中
+            if (i > start)
+                out.push_back(chunk.substr(start, i - start));
+            out.push_back(DOT);
+            start = i;
+            atLineStart_ = false;
+        }
+        else
+        {
+            atLineStart_ = false;
+        }
+    }
+
+    if (start < chunk.size())
+        out.push_back(chunk.substr(start));
+}
+
+void SmtpDataEncoder::Finish(std::vector<std::string_view>& out)
+{
+    if (pendingCr_)
+    {
+        out.push_back(LF);
+    }
+    else if (!atLineStart_)
+    {
+        out.push_back(CRLF);
+    }
+    if (mode_ == Mode::Data)
+    {
+        out.push_back(END_OF_DATA);
+    }
+
+    atLineStart_ = true;
+    pendingCr_ = false;
+}
+
+std::string SmtpDataEncoder::EncodeAll(const std::string& rawEmail)
+{
+    SmtpDataEncoder               encoder;
+    std::vector<std::string_view> parts;
+    encoder.Encode(rawEmail, parts);
+    encoder.Finish(parts);
+
+    size_t total = 0;
+    for (const auto& part : parts)
+        total += part.size();
+
+    std::string result;
+    result.reserve(total);
+    for (const auto& part : parts)
+        result.append(part.data(), part.size());
+    return result;
+}
+
+bool SmtpDataEncoder::EncodedSize(MessageSource& source, Mode mode, long long& size, std::string& errorMsg)
+{
+    if (!source.Rewind(errorMsg))
+        return false;
+
+    SmtpDataEncoder               encoder(mode);
+    std::vector<std::string_view> parts;
+    std::string_view              chunk;
+    bool                          isLast = false;
+    long long                     total = 0;
+    while (!isLast)
+    {
+        if (!source.Next(chunk, isLast, errorMsg))
+            return false;
+
+        parts.clear();
+        encoder.Encode(chunk, parts);
+        if (isLast)
+            encoder.Finish(parts);
+        for (const auto& part : parts)
+            total += static_cast<long long>(part.size());
+    }
+
+    if (mode == Mode::Data)
+        total -= static_cast<long long>(END_OF_DATA.size());
+    size = total;
+    return true;
+}
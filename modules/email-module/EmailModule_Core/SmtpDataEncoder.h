@@ -0,0 +1,72 @@
+﻿#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 邮件正文的分段数据源：DATA 阶段按段读取，不需要整封邮件的副本
+class MessageSource
+{
+public:
+    virtual ~MessageSource() = default;
+
+    // 读取下一段，isLast 表示这是最后一段（空邮件时 chunk 为空）；chunk 在下一次调用 Next / Rewind 前有效
+    virtual bool Next(std::string_view& chunk, bool& isLast, std::string& errorMsg) = 0;
+
+    // 回到开头（重试时重新发送）
+    virtual bool Rewind(std::string& errorMsg) = 0;
+
+    // 邮件总字节数，未知时返回 -1（用于 SIZE 检查）
+    virtual long long Size() const { return -1; }
+
+    // 建议的分段大小（BDAT 按 socket 发送缓冲区大小分块），数据源可以忽略
+    virtual void SetPreferredChunkSize(size_t chunkSize) { (void)chunkSize; }
+};
+
+// 以已有字符串为数据源，按固定大小分段返回视图（不复制）
+class StringMessageSource : public MessageSource
+{
+public:
+    explicit StringMessageSource(const std::string& text, size_t chunkSize = 64 * 1024);
+
+    bool Next(std::string_view& chunk, bool& isLast, std::string& errorMsg) override;
+    bool Rewind(std::string& errorMsg) override;
+    long long Size() const override { return static_cast<long long>(text_.size()); }
+    void SetPreferredChunkSize(size_t chunkSize) override;
+
+private:
+    const std::string& text_;
+    size_t             chunkSize_;
+    size_t             pos_;
+};
+
+// SMTP 正文编码：逐段处理，状态跨段保留
+// - 裸 LF、裸 CR 统一为 CRLF
+// - Mode::Data（RFC 5321 4.5.2）：行首的 "." 前再加一个 "."（点填充），Finish 补齐末尾换行并追加结束行 "."
+// - Mode::Bdat（RFC 3030）：数据按字节数传输，不做点填充，Finish 只补齐末尾换行
+// 输出为片段列表：未改动的部分直接引用输入段，插入的字节引用静态常量，不复制正文
+class SmtpDataEncoder
+{
+public:
+    enum class Mode
+    {
+        Data,
+        Bdat
+    };
+
+    explicit SmtpDataEncoder(Mode mode = Mode::Data);
+
+    void Encode(std::string_view chunk, std::vector<std::string_view>& out);
+    void Finish(std::vector<std::string_view>& out);
+
+    // 把整封邮件编码为一个字符串（需要保留发送缓冲区的异步客户端使用）
+    static std::string EncodeAll(const std::string& rawEmail);
+
+    // 从头读取 source，计算编码后的字节数（不含 DATA 结束行，用于 SIZE 检查）；读取失败时返回 false
+    static bool EncodedSize(MessageSource& source, Mode mode, long long& size, std::string& errorMsg);
+
+private:
+    Mode mode_;
+    bool atLineStart_;
+    bool pendingCr_;   // 上一个字节是 CR，尚未确定后面是否跟着 LF
+};
@@ -102,10 +102,11 @@ bool SystemMonitor::SendAlertEmail(const SmtpConfig& cfg, const std::string& to,
     mail.subject = subject;
     mail.body = content;
 
-    std::string raw = EmailMessageBuilder::Build(cfg, mail);
+    std::string raw;
     SmtpClient client;
 
-    if (!client.SendMail(cfg, raw, errorMsg))
+    if (!EmailMessageBuilder::Build(cfg, mail, raw, errorMsg) ||
+        !client.SendMail(cfg, raw, errorMsg))
     {
         EmailLogger::Error("报警邮件发送失败: " + errorMsg);
         return false;
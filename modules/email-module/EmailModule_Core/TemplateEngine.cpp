@@ -1,5 +1,7 @@
 ﻿#include "TemplateEngine.h"
 
+#include <cstring>
+
 std::string RenderTemplate(
     const std::string& tpl,
     const std::map<std::string, std::string>& vars
@@ -47,3 +49,300 @@ std::string RenderTemplate(
 
     return result;
 }
+
+// ---------------- CompiledTemplate ----------------
+
+namespace
+{
+    // 去掉首尾空格
+    std::string TrimSpaces(const std::string& s)
+    {
+        std::size_t b = s.find_first_not_of(' ');
+        if (b == std::string::npos)
+            return std::string();
+        std::size_t e = s.find_last_not_of(' ');
+        return s.substr(b, e - b + 1);
+    }
+
+    // key 为 "<keyword> <参数>" 时取出参数
+    bool MatchKeyword(const std::string& key, const char* keyword, std::string& arg)
+    {
+        const std::size_t len = std::strlen(keyword);
+        if (key.size() <= len || key.compare(0, len, keyword) != 0 || key[len] != ' ')
+            return false;
+        arg = TrimSpaces(key.substr(len + 1));
+        return !arg.empty();
+    }
+
+    // 只统计长度
+    struct SizeSink
+    {
+        std::size_t size = 0;
+        void operator()(const char*, std::size_t n) { size += n; }
+    };
+
+    // 写入已分配好的缓冲区
+    struct WriteSink
+    {
+        char* pos;
+        void operator()(const char* data, std::size_t n)
+        {
+            if (n > 0)
+            {
+                std::memcpy(pos, data, n);
+                pos += n;
+            }
+        }
+    };
+}
+
+bool CompiledTemplate::Compile(const std::string& text, std::string& errorMsg)
+{
+    text_ = text;
+    ops_.clear();
+    slotNames_.clear();
+
+    std::vector<std::size_t> blocks;    // 尚未遇到 ${end} 的 If / Each
+    int                      eachDepth = 0;
+    std::size_t              literalStart = 0;
+
+    auto flushLiteral = [&](std::size_t end) {
+        if (end > literalStart)
+            ops_.push_back({ OpKind::Literal, -1, literalStart, end - literalStart, 0 });
+    };
+
+    const std::size_t n = text_.size();
+    std::size_t i = 0;
+    while (i < n)
+    {
+        // 与 RenderTemplate 相同：${ 之后第一个 '}' 结束占位符，没有 '}' 时余下部分都是普通文本
+        std::size_t open = text_.find("${", i);
+        if (open == std::string::npos)
+            break;
+        std::size_t closePos = text_.find('}', open + 2);
+        if (closePos == std::string::npos)
+            break;
+
+        flushLiteral(open);
+        literalStart = closePos + 1;
+        i = closePos + 1;
+
+        const std::string key = text_.substr(open + 2, closePos - (open + 2));
+        const std::size_t index = ops_.size();
+        std::string       arg;
+
+        if (MatchKeyword(key, "if", arg))
+        {
+            ops_.push_back({ OpKind::If, AddSlot(arg), open, closePos - open + 1, 0 });
+            blocks.push_back(index);
+        }
+        else if (MatchKeyword(key, "each", arg))
+        {
+            ops_.push_back({ OpKind::Each, AddSlot(arg), open, closePos - open + 1, 0 });
+            blocks.push_back(index);
+            ++eachDepth;
+        }
+        else if (key == "else")
+        {
+            if (blocks.empty() || ops_[blocks.back()].kind != OpKind::If || ops_[blocks.back()].jump != 0)
+            {
+                errorMsg = "模板中的 ${else} 没有对应的 ${if}（位置 " + std::to_string(open) + "）";
+                return false;
+            }
+            ops_[blocks.back()].jump = index; // 条件为假时从 ${else} 之后继续
+            ops_.push_back({ OpKind::Else, -1, open, closePos - open + 1, 0 });
+        }
+        else if (key == "end")
+        {
+            if (blocks.empty())
+            {
+                errorMsg = "模板中的 ${end} 没有对应的 ${if} 或 ${each}（位置 " + std::to_string(open) + "）";
+                return false;
+            }
+            Op& block = ops_[blocks.back()];
+            blocks.pop_back();
+            if (block.kind == OpKind::Each)
+            {
+                block.jump = index;
+                --eachDepth;
+            }
+            else if (block.jump == 0)
+            {
+                block.jump = index;
+            }
+            else
+            {
+                ops_[block.jump].jump = index; // ${else}：条件为真的分支结束后跳到 ${end}
+            }
+            ops_.push_back({ OpKind::End, -1, open, closePos - open + 1, 0 });
+        }
+        else if (key == "item" && eachDepth > 0)
+        {
+            ops_.push_back({ OpKind::Item, -1, open, closePos - open + 1, 0 });
+        }
+        else
+        {
+            ops_.push_back({ OpKind::Variable, AddSlot(key), open, closePos - open + 1, 0 });
+        }
+    }
+    flushLiteral(n);
+
+    if (!blocks.empty())
+    {
+        errorMsg = "模板中的 ${if} / ${each}（位置 " + std::to_string(ops_[blocks.back()].offset) + "）缺少 ${end}";
+        return false;
+    }
+
+    errorMsg.clear();
+    return true;
+}
+
+int CompiledTemplate::AddSlot(const std::string& name)
+{
+    int slot = SlotOf(name);
+    if (slot >= 0)
+        return slot;
+    slotNames_.push_back(name);
+    return static_cast<int>(slotNames_.size() - 1);
+}
+
+int CompiledTemplate::SlotOf(const std::string& name) const
+{
+    for (std::size_t i = 0; i < slotNames_.size(); ++i)
+    {
+        if (slotNames_[i] == name)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+template <typename Sink>
+void CompiledTemplate::Run(const TemplateValues& values, std::size_t begin, std::size_t end,
+    std::string_view item, Sink& sink) const
+{
+    std::size_t pc = begin;
+    while (pc < end)
+    {
+        const Op& op = ops_[pc];
+        switch (op.kind)
+        {
+        case OpKind::Literal:
+            sink(text_.data() + op.offset, op.length);
+            ++pc;
+            break;
+
+        case OpKind::Variable:
+            if (values.IsBound(op.slot))
+            {
+                std::string_view v = values.Get(op.slot);
+                sink(v.data(), v.size());
+            }
+            else
+            {
+                sink(text_.data() + op.offset, op.length); // 未绑定：保留 ${key}
+            }
+            ++pc;
+            break;
+
+        case OpKind::Item:
+            sink(item.data(), item.size());
+            ++pc;
+            break;
+
+        case OpKind::If:
+            if (values.IsBound(op.slot) && !values.Get(op.slot).empty())
+                ++pc;
+            else
+                pc = op.jump + 1;   // ${else} 之后，没有 ${else} 时为 ${end} 之后
+            break;
+
+        case OpKind::Else:
+            pc = op.jump + 1;       // 条件为真的分支到此结束
+            break;
+
+        case OpKind::Each:
+        {
+            std::string_view list = values.IsBound(op.slot) ? values.Get(op.slot) : std::string_view();
+            std::size_t start = 0;
+            while (start < list.size())
+            {
+                std::size_t sep = list.find(';', start);
+                if (sep == std::string_view::npos)
+                    sep = list.size();
+                if (sep > start)
+                    Run(values, pc + 1, op.jump, list.substr(start, sep - start), sink);
+                start = sep + 1;
+            }
+            pc = op.jump + 1;
+            break;
+        }
+
+        case OpKind::End:
+            ++pc;
+            break;
+        }
+    }
+}
+
+std::size_t CompiledTemplate::RenderedSize(const TemplateValues& values) const
+{
+    SizeSink sink;
+    Run(values, 0, ops_.size(), std::string_view(), sink);
+    return sink.size;
+}
+
+void CompiledTemplate::RenderTo(const TemplateValues& values, std::string& out) const
+{
+    const std::size_t size = RenderedSize(values);
+    if (size == 0)
+        return;
+
+    const std::size_t start = out.size();
+    out.resize(start + size);
+    WriteSink sink{ &out[start] };
+    Run(values, 0, ops_.size(), std::string_view(), sink);
+}
+
+std::string CompiledTemplate::Render(const TemplateValues& values) const
+{
+    std::string out;
+    RenderTo(values, out);
+    return out;
+}
+
+bool CompiledTemplate::RenderTo(const TemplateValues& values, char* buffer, std::size_t capacity,
+    std::size_t& written) const
+{
+    written = RenderedSize(values);
+    if (written > capacity)
+        return false;
+
+    WriteSink sink{ buffer };
+    Run(values, 0, ops_.size(), std::string_view(), sink);
+    return true;
+}
+
+// ---------------- TemplateValues ----------------
+
+TemplateValues::TemplateValues(const CompiledTemplate& tpl)
+    : values_(tpl.SlotCount())
+    , bound_(tpl.SlotCount(), 0)
+{
+}
+
+void TemplateValues::Set(int slot, std::string_view value)
+{
+    if (slot < 0 || static_cast<std::size_t>(slot) >= values_.size())
+        return;
+    values_[slot] = value;
+    bound_[slot] = 1;
+}
+
+void TemplateValues::Clear()
+{
+    for (std::size_t i = 0; i < values_.size(); ++i)
+    {
+        values_[i] = std::string_view();
+        bound_[i] = 0;
+    }
+}
@@ -1,8 +1,90 @@
 ﻿#pragma once
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <map>
+#include <vector>
 
+// 单次渲染：逐字符扫描模板，${key} 替换为 vars 中的值，不存在的 key 保留原样
 std::string RenderTemplate(
     const std::string& tpl,
     const std::map<std::string, std::string>& vars
 );
+
+class TemplateValues;
+
+// 预编译模板：模板文本只解析一次，得到由字面量片段和变量槽位组成的程序，
+// 之后每个收件人只需按槽位下标绑定变量值再渲染（群发时使用）
+// 语法：
+//   ${key}                               变量，未绑定时保留原样（与 RenderTemplate 相同）
+//   ${if key} ... ${else} ... ${end}     key 的值非空时输出前一段，否则输出 ${else} 之后的部分（${else} 可省略）
+//   ${each key} ... ${end}               key 的值按 ';' 拆分（忽略空项），每一项输出一次块内容，块内 ${item} 为当前项
+class CompiledTemplate
+{
+public:
+    // 解析模板；块不配对（缺少 ${end}、多余的 ${else} / ${end}）时返回 false
+    bool Compile(const std::string& text, std::string& errorMsg);
+
+    // 变量名对应的槽位下标，模板中没有该变量时返回 -1
+    int SlotOf(const std::string& name) const;
+    size_t SlotCount() const { return slotNames_.size(); }
+
+    // 渲染结果的字节数（先算出长度，渲染时只分配一次）
+    size_t RenderedSize(const TemplateValues& values) const;
+
+    // 渲染并追加到 out
+    void RenderTo(const TemplateValues& values, std::string& out) const;
+    std::string Render(const TemplateValues& values) const;
+
+    // 渲染到调用方提供的缓冲区；容量不足时不写入并返回 false，written 为需要的字节数
+    bool RenderTo(const TemplateValues& values, char* buffer, size_t capacity, size_t& written) const;
+
+private:
+    enum class OpKind : std::uint8_t
+    {
+        Literal,   // 模板文本 [offset, offset + length)
+        Variable,  // 槽位 slot；未绑定时输出原文 [offset, offset + length)
+        Item,      // ${each} 块内的当前项
+        If,        // 条件为假时跳到 jump（${else} 之后或 ${end}）
+        Else,      // 条件为真的分支执行到这里后跳到 jump（${end}）
+        Each,      // 循环体为 (当前, jump)，jump 指向 ${end}
+        End
+    };
+
+    struct Op
+    {
+        OpKind kind;
+        int    slot;
+        size_t offset;
+        size_t length;
+        size_t jump;
+    };
+
+    template <typename Sink>
+    void Run(const TemplateValues& values, size_t begin, size_t end, std::string_view item, Sink& sink) const;
+
+    int AddSlot(const std::string& name);
+
+    std::string              text_;
+    std::vector<Op>          ops_;
+    std::vector<std::string> slotNames_;
+};
+
+// 一次渲染的变量值，按 CompiledTemplate 的槽位下标保存视图（不复制，值在渲染结束前必须有效）
+class TemplateValues
+{
+public:
+    explicit TemplateValues(const CompiledTemplate& tpl);
+
+    // slot 为 -1（模板中没有该变量）时忽略
+    void Set(int slot, std::string_view value);
+    void Clear();
+
+    bool IsBound(size_t slot) const { return bound_[slot] != 0; }
+    std::string_view Get(size_t slot) const { return values_[slot]; }
+
+private:
+    std::vector<std::string_view> values_;
+    std::vector<char>             bound_;
+};
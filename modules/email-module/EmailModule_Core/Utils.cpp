@@ -1,4 +1,5 @@
 ﻿#include "Utils.h"
+#include "Base64.h"
 
 #include <chrono>
 #include <ctime>
@@ -19,57 +20,7 @@ std::string GetCurrentTimeString()
 }
 std::string Base64Encode(const std::string& data)
 {
-    static const char table[] =
-        "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-        "abcdefghijklmnopqrstuvwxyz"
-        "0123456789+/";
-
-    std::string out;
-    out.reserve(((data.size() + 2) / 3) * 4);
-
-    const unsigned char* bytes =
-        reinterpret_cast<const unsigned char*>(data.data());
-    std::size_t i = 0;
-    std::size_t n = data.size();
-
-    while (i + 2 < n)
-    {
-        unsigned int v = (bytes[i] << 16) |
-            (bytes[i + 1] << 8) |
-            (bytes[i + 2]);
-        out.push_back(table[(v >> 18) & 0x3F]);
-        out.push_back(table[(v >> 12) & 0x3F]);
-        out.push_back(table[(v >> 6) & 0x3F]);
-        out.push_back(table[v & 0x3F]);
-        i += 3;
-    }
-
-    if (i < n)
-    {
-        unsigned int v = bytes[i] << 16;
-        bool twoBytes = false;
-        if (i + 1 < n)
-        {
-            v |= (bytes[i + 1] << 8);
-            twoBytes = true;
-        }
-
-        out.push_back(table[(v >> 18) & 0x3F]);
-        out.push_back(table[(v >> 12) & 0x3F]);
-
-        if (twoBytes)
-        {
-            out.push_back(table[(v >> 6) & 0x3F]);
-            out.push_back('=');
-        }
-        else
-        {
-            out.push_back('=');
-            out.push_back('=');
-        }
-    }
-
-    return out;
+    return Base64::Encode(data);
 }
 
 std::string EncodeHeaderUtf8B(const std::string& text)
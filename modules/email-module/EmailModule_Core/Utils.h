@@ -1,10 +1,11 @@
 ﻿#pragma once
+#include <cstddef>
 #include <string>
 
 // 返回当前本地时间字符串，例如 "2025-11-23 11:45:00"
 std::string GetCurrentTimeString();
 
-// 将字节串做 Base64 编码（用于邮件头编码）
+// 将字节串做 Base64 编码（用于邮件头编码），实现见 modules/common 的 Base64
 std::string Base64Encode(const std::string& data);
 
 // 把 UTF-8 文本按 RFC 2047 的 style 编成 "=?utf-8?B?...?="，用于 Subject 等头部字段
@@ -5,6 +5,7 @@
 // 以及 description()
 // 设计：优先使用 requestJson 内的数据；否则从 DLL 同目录或当前工作目录读取标准文件（email.conf, recipients.txt, mail_template.txt）；最后使用内置默认。
 #include "EmailModuleApi.h"
+#include "ProfiledMutex.h"
 #include <iostream>
 #include <string>
 #include <vector>
@@ -15,8 +16,8 @@
 #include <direct.h>
 
 
-// simple mutex for thread-safety
-static std::mutex g_invoke_mutex;
+// simple mutex for thread-safety (profiled: wait/hold times show up in LOCK_STATS)
+static ProfiledMutex g_invoke_mutex("EmailModuleAuto::g_invoke_mutex");
 
 // ===================== 内置默认配置（可以按需修改） =====================
 static const char* default_email_conf =
@@ -256,7 +257,7 @@ __declspec(dllexport) int run()
     }
     TempCwdGuard guard(tmpPath, true);
 
-    std::lock_guard<std::mutex> lk(g_invoke_mutex);
+    std::lock_guard<ProfiledMutex> lk(g_invoke_mutex);
 
     std::string line;
     std::cout << "EMAIL_MODULE_STDIO_READY\n" << std::flush;
@@ -321,6 +322,10 @@ __declspec(dllexport) int run()
                 std::cout << "ERR|" << errStr << std::endl;
             }
         }
+        // --- 锁竞争报告 ---
+        else if (cmd == "LOCK_STATS") {
+            std::cout << LockProfiler::Report() << "OK|LOCK_STATS\n" << std::flush;
+        }
         else {
             std::cout << "ERR|UnknownCmd\n" << std::flush;
         }
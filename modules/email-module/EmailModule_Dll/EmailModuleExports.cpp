@@ -1,4 +1,5 @@
 ﻿#include "EmailModuleApi.h"
+#include "ProfiledMutex.h"
 
 #include <string>
 #include <cstring>
@@ -66,6 +67,13 @@ bool Email_SendBulk(char* errorBuf, int errorBufSize)
     return ok;
 }
 
+// 2.1) 导出：取消正在进行的群发
+extern "C" __declspec(dllexport)
+void Email_CancelBulk()
+{
+    EmailModule::CancelBulkMails();
+}
+
 // 3) 导出：显示统计（直接在控制台打印）
 //    返回 false 表示统计过程中出错（例如 email.log 不存在）
 extern "C" __declspec(dllexport)
@@ -101,3 +109,17 @@ bool Email_SearchLog(const char* keyword,
     }
     return ok;
 }
+
+// 5) 导出：锁竞争报告（文本，每个命名锁一行）
+//    返回包含结尾 '\0' 所需的缓冲区大小；buffer 为空或过小时只返回所需大小，不写入
+extern "C" __declspec(dllexport)
+int Email_GetLockProfile(char* buffer, int bufferSize)
+{
+    std::string report = LockProfiler::Report();
+    int required = static_cast<int>(report.size()) + 1;
+    if (buffer && bufferSize >= required)
+    {
+        std::memcpy(buffer, report.c_str(), static_cast<size_t>(required));
+    }
+    return required;
+}
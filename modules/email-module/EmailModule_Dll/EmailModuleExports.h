@@ -19,6 +19,9 @@ extern "C" {
     // 按项目约定读取 recipients.txt 与 mail_template.txt 并群发
     bool Email_SendBulk(char* errorBuf, int errorBufSize);
 
+    // 取消正在进行的群发（从其他线程调用），正在执行的 Email_SendBulk 随后返回 false
+    void Email_CancelBulk();
+
     // 在控制台打印/输出统计（成功/失败数量等）
     // 返回 false 表示统计过程中出错（如没有日志）
     bool Email_ShowStats(char* errorBuf, int errorBufSize);
@@ -31,6 +34,9 @@ extern "C" {
         char* errorBuf,
         int errorBufSize);
 
+    // 锁竞争报告（等待/持有时间与竞争次数），返回包含结尾 '\0' 所需的缓冲区大小
+    int Email_GetLockProfile(char* buffer, int bufferSize);
+
 #ifdef __cplusplus
 }
 #endif
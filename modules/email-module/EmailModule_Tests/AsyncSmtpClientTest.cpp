@@ -0,0 +1,298 @@
+﻿// AsyncSmtpClient 回环测试
+// 在本进程内启动一个模拟 SMTP 服务器，正文结束后的响应按脚本依次给出，
+// 用一个连接连续发送多封邮件，检查暂时性失败（4xx）按 cfg.maxRetry 重试、永久性失败（5xx）不重试，
+// 以及失败之后同一连接继续发送后续邮件。
+//
+// 用法：EmailModule_Tests（全部通过时返回 0）
+// 需要与 EmailModule_Core 中除 EmailModule_Core.cpp 以外的源文件一起编译。
+#include "AsyncSmtpClient.h"
+#include "Config.h"
+#include "EmailMessage.h"
+
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#include <atomic>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#pragma comment(lib, "Ws2_32.lib")
+
+namespace
+{
+    // --- 模拟 SMTP 服务器：每个连接一个线程，正文结束后的响应取自脚本（脚本用完后回复 250）---
+    class ScriptedSmtpServer
+    {
+    public:
+        explicit ScriptedSmtpServer(const std::vector<std::string>& bodyReplies)
+            : listen_(INVALID_SOCKET)
+            , port_(0)
+            , stopping_(false)
+            , connections_(0)
+            , bodies_(0)
+            , bodyReplies_(bodyReplies.begin(), bodyReplies.end())
+        {
+        }
+
+        ~ScriptedSmtpServer()
+        {
+            Stop();
+        }
+
+        bool Start()
+        {
+            listen_ = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            if (listen_ == INVALID_SOCKET)
+                return false;
+
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = 0; // 由系统分配端口
+            ::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+            int addrLen = static_cast<int>(sizeof(addr));
+            if (::bind(listen_, reinterpret_cast<sockaddr*>(&addr), addrLen) == SOCKET_ERROR ||
+                ::listen(listen_, SOMAXCONN) == SOCKET_ERROR ||
+                ::getsockname(listen_, reinterpret_cast<sockaddr*>(&addr), reinterpret_cast<socklen_t*>(&addrLen)) == SOCKET_ERROR)
+            {
+                return false;
+            }
+            port_ = ntohs(addr.sin_port);
+
+            acceptThread_ = std::thread([this]() { AcceptLoop(); });
+            return true;
+        }
+
+        void Stop()
+        {
+            if (stopping_.exchange(true))
+                return;
+            ::shutdown(listen_, SD_BOTH);
+            ::closesocket(listen_);
+            if (acceptThread_.joinable())
+                acceptThread_.join();
+            for (auto& t : sessions_)
+            {
+                if (t.joinable())
+                    t.join();
+            }
+        }
+
+        int Port() const { return port_; }
+        int Connections() const { return connections_.load(); }
+        int Bodies() const { return bodies_.load(); }
+
+    private:
+        void AcceptLoop()
+        {
+            while (!stopping_.load())
+            {
+                SOCKET s = ::accept(listen_, nullptr, nullptr);
+                if (s == INVALID_SOCKET)
+                    break;
+                ++connections_;
+                sessions_.emplace_back([this, s]() { Serve(s); });
+            }
+        }
+
+        std::string NextBodyReply()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (bodyReplies_.empty())
+                return "250 queued";
+            std::string reply = bodyReplies_.front();
+            bodyReplies_.pop_front();
+            return reply;
+        }
+
+        void Serve(SOCKET s)
+        {
+            std::string buffer;
+            bool        inData = false;
+            char        buf[4096];
+
+            std::string greeting = "220 test ESMTP\r\n";
+            ::send(s, greeting.c_str(), static_cast<int>(greeting.size()), 0);
+            while (true)
+            {
+                int n = ::recv(s, buf, sizeof(buf), 0);
+                if (n <= 0)
+                    break;
+                buffer.append(buf, n);
+
+                std::string out;
+                size_t      pos = 0;
+                bool        quit = false;
+                while (!quit)
+                {
+                    if (inData)
+                    {
+                        size_t end = buffer.find("\r\n.\r\n", pos);
+                        if (end == std::string::npos)
+                            break;
+                        pos = end + 5;
+                        inData = false;
+                        ++bodies_;
+                        out += NextBodyReply() + "\r\n";
+                        continue;
+                    }
+
+                    size_t eol = buffer.find("\r\n", pos);
+                    if (eol == std::string::npos)
+                        break;
+                    std::string cmd = buffer.substr(pos, eol - pos);
+                    pos = eol + 2;
+
+                    std::string verb = cmd.substr(0, 4);
+                    if (verb == "DATA")
+                    {
+                        out += "354 go ahead\r\n";
+                        inData = true;
+                        // 正文以 "\r\n.\r\n" 结束，从 DATA 行的换行开始查找
+                        pos -= 2;
+                    }
+                    else if (verb == "QUIT")
+                    {
+                        out += "221 bye\r\n";
+                        quit = true;
+                    }
+                    else
+                    {
+                        out += "250 OK\r\n";
+                    }
+                }
+                buffer.erase(0, pos);
+                if (!out.empty())
+                    ::send(s, out.c_str(), static_cast<int>(out.size()), 0);
+                if (quit)
+                    break;
+            }
+            ::closesocket(s);
+        }
+
+        SOCKET                   listen_;
+        int                      port_;
+        std::atomic<bool>        stopping_;
+        std::atomic<int>         connections_;
+        std::atomic<int>         bodies_;
+        std::mutex               mutex_;
+        std::deque<std::string>  bodyReplies_;
+        std::thread              acceptThread_;
+        std::vector<std::thread> sessions_;
+    };
+
+    int g_failures = 0;
+
+    void Check(bool condition, const std::string& what)
+    {
+        std::cout << (condition ? "  [通过] " : "  [失败] ") << what << "\n";
+        if (!condition)
+            ++g_failures;
+    }
+
+    // 用一个连接依次发送 count 封邮件，返回每封邮件的结果（按提交顺序）
+    std::vector<AsyncSendResult> SendOverOneConnection(ScriptedSmtpServer& server, int maxRetry, int count)
+    {
+        SmtpConfig cfg;
+        cfg.serverIp = "127.0.0.1";
+        cfg.port = server.Port();
+        cfg.fromAddress = "test@loopback.test";
+        cfg.maxRetry = maxRetry;
+        cfg.ioTimeoutMs = 5000;
+
+        std::vector<AsyncSendResult> results(count);
+        AsyncSmtpClient client(cfg, 1);
+        for (int i = 0; i < count; ++i)
+        {
+            SimpleEmail mail;
+            mail.to = "user" + std::to_string(i) + "@loopback.test";
+            mail.subject = "回环测试 #" + std::to_string(i);
+            mail.body = "异步客户端回环测试。";
+            std::string raw;
+            std::string buildErr;
+            Check(EmailMessageBuilder::Build(cfg, mail, raw, buildErr), "构造邮件 #" + std::to_string(i) + " " + buildErr);
+            client.Submit({ mail.to }, raw,
+                [&results, i](const AsyncSendResult& result) { results[i] = result; });
+        }
+
+        std::string err;
+        Check(client.Run(err), "事件循环正常结束 " + err);
+        return results;
+    }
+
+    // 正文结束后的 451 是暂时性失败：同一连接上重发，后续邮件不受影响
+    void TestTransientBodyFailureIsRetried()
+    {
+        std::cout << "正文后 451 按 max_retry 重试\n";
+        ScriptedSmtpServer server({ "250 queued", "451 local error, try again later" });
+        if (!server.Start())
+        {
+            Check(false, "模拟 SMTP 服务器启动");
+            return;
+        }
+        auto results = SendOverOneConnection(server, 3, 3);
+        server.Stop();
+
+        Check(results[0].ok && results[1].ok && results[2].ok, "三封邮件全部发送成功");
+        Check(server.Bodies() == 4, "第二封邮件的正文发送了两次，共 4 次");
+        Check(server.Connections() == 1, "所有邮件共用一个连接");
+    }
+
+    // 重试次数用完仍是 4xx：以失败结束，错误信息带尝试次数
+    void TestTransientBodyFailureExhaustsRetries()
+    {
+        std::cout << "正文后 452 超过重试次数\n";
+        ScriptedSmtpServer server({ "452 insufficient storage", "452 insufficient storage" });
+        if (!server.Start())
+        {
+            Check(false, "模拟 SMTP 服务器启动");
+            return;
+        }
+        auto results = SendOverOneConnection(server, 2, 2);
+        server.Stop();
+
+        Check(!results[0].ok && results[0].errorMsg.find("2 次") != std::string::npos,
+            "第一封邮件尝试 2 次后失败: " + results[0].errorMsg);
+        Check(results[1].ok, "后续邮件在同一连接上发送成功");
+        Check(server.Bodies() == 3 && server.Connections() == 1, "共发送 3 次正文，使用一个连接");
+    }
+
+    // 5xx 是永久性失败：不重试
+    void TestPermanentBodyFailureIsNotRetried()
+    {
+        std::cout << "正文后 554 不重试\n";
+        ScriptedSmtpServer server({ "554 message rejected" });
+        if (!server.Start())
+        {
+            Check(false, "模拟 SMTP 服务器启动");
+            return;
+        }
+        auto results = SendOverOneConnection(server, 3, 2);
+        server.Stop();
+
+        Check(!results[0].ok, "第一封邮件失败: " + results[0].errorMsg);
+        Check(results[1].ok, "后续邮件发送成功");
+        Check(server.Bodies() == 2, "被拒绝的正文没有重发");
+    }
+}
+
+int main()
+{
+    WSADATA wsaData{};
+    if (::WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+    {
+        std::cerr << "WSAStartup 失败" << std::endl;
+        return 1;
+    }
+
+    TestTransientBodyFailureIsRetried();
+    TestTransientBodyFailureExhaustsRetries();
+    TestPermanentBodyFailureIsNotRetried();
+
+    ::WSACleanup();
+    std::cout << (g_failures == 0 ? "全部通过" : "存在失败的检查：" + std::to_string(g_failures)) << std::endl;
+    return g_failures == 0 ? 0 : 1;
+}
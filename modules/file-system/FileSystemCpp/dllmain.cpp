@@ -9,51 +9,11 @@
 #include <iomanip>
 #include <sstream>
 #include <algorithm>
+#include "Base64.h" // modules/common：SIMD Base64 编解码
 
 namespace fs = std::filesystem;
 using namespace std;
 
-// ==========================================
-//  工具类：Base64 加密/解密
-// ==========================================
-class Base64 {
-    static const string base64_chars;
-public:
-    static string Encode(const string& in) {
-        string out;
-        int val = 0, valb = -6;
-        for (unsigned char c : in) {
-            val = (val << 8) + c;
-            valb += 8;
-            while (valb >= 0) {
-                out.push_back(base64_chars[(val >> valb) & 0x3F]);
-                valb -= 6;
-            }
-        }
-        if (valb > -6) out.push_back(base64_chars[((val << 8) >> (valb + 8)) & 0x3F]);
-        while (out.size() % 4) out.push_back('=');
-        return out;
-    }
-
-    static string Decode(const string& in) {
-        string out;
-        vector<int> T(256, -1);
-        for (int i = 0; i < 64; i++) T[base64_chars[i]] = i;
-        int val = 0, valb = -8;
-        for (unsigned char c : in) {
-            if (T[c] == -1) break;
-            val = (val << 6) + T[c];
-            valb += 6;
-            if (valb >= 0) {
-                out.push_back(char((val >> valb) & 0xFF));
-                valb -= 8;
-            }
-        }
-        return out;
-    }
-};
-const string Base64::base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-
 // ==========================================
 //  核心类：文件系统管理器
 // ==========================================
@@ -214,7 +174,13 @@ public:
         string content((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
         in.close();
         if (content.rfind("[ENCRYPTED]", 0) != 0) return "Error: Not encrypted.";
-        string decoded = Base64::Decode(content.substr(11));
+        // 严格解码：内容被改动过时不覆盖原文件（只容忍编辑器在末尾加上的换行）
+        size_t end = content.find_last_not_of("\r\n");
+        size_t length = (end == string::npos || end < 11) ? 0 : end + 1 - 11;
+        string decoded;
+        if (!Base64::DecodeTo(content.data() + 11, length, decoded, Base64::DecodeMode::Strict)) {
+            return "Error: Corrupted encrypted content.";
+        }
         ofstream out(p, ios::trunc | ios::binary);
         out << decoded;
         out.close();
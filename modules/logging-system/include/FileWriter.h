@@ -3,37 +3,82 @@
 
 #include "ILogger.h" 
 #include "LogEntry.h"
+#include "LogQueue.h"
+#include "SharedLogFile.h"
 #include <string>
-#include <fstream>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <chrono>
+#include <deque>
 
-//  2.4ļС (100KB Աڲ)
+// 步骤 4.9：写锁类型来自 modules/common，这里只前置声明，使用 CoreLogger 头文件时无需 common 的包含路径
+class ProfiledMutex;
+
+// 步骤 2.4：定义文件最大大小常量 (100KB 以便于测试)
 const unsigned long MAX_LOG_FILE_SIZE_BYTES = 10 * 1024; // 10KB
 
 class CORELOGGER_API FileWriter {
 public:
-    //  3.4: 캯 logPath 
+    // 步骤 3.4: 构造函数接受 logPath 参数
     FileWriter(const std::string& filename, const std::string& logPath);
     ~FileWriter();
 
-    // д־Ŀļ
+    // 步骤 4.5：获取指定文件的共享 FileWriter (按规范化路径在进程内复用，引用计数释放)
+    static std::shared_ptr<FileWriter> Acquire(const std::string& filename, const std::string& logPath);
+
+    // 写入日志条目到文件
+    // 步骤 4.1：INFO/WARN/ERROR 进入异步队列，FATAL 同步写入并刷新
     void Write(const LogEntry& entry);
+    void Write(LogEntry&& entry);
+
+    // 步骤 4.1：等待队列中已有条目全部写入磁盘
+    void Flush();
+
+    // 步骤 4.10：整批写入：只获取一次写锁，整批格式化到同一缓冲区后一次追加 (跨滚动阈值时在条目边界拆分)
+    void WriteBatch(std::deque<LogEntry>&& entries);
 
-    //  3.3鵵/߼
+    // 步骤 4.1：队列丢弃/阻塞/溢出计数
+    LogQueueCounters GetQueueCounters() const;
+
+    // 步骤 3.3：归档/清理逻辑
     void RunCleanup();
 
 private:
     std::string filename_;
-    std::string logPath_; //  3.4: ־洢·
-    std::ofstream fileStream_;
-    std::mutex writeMutex_;
-    bool isFirstWrite_; //  3.3: ״дʱִ
+    std::string logPath_; // 步骤 3.4: 日志存储路径
+    std::unique_ptr<SharedLogFile> file_; // 步骤 4.3：多进程安全的追加写文件
+    std::string writeBuffer_;             // 步骤 4.3：整批格式化后一次写入
+    std::unique_ptr<ProfiledMutex> writeMutex_; // 步骤 4.9：记录等待/持有时间
+    bool isFirstWrite_; // 步骤 3.3: 仅在首次写入时执行清理
+
+    // 步骤 4.1：异步队列与后台写线程 (锁顺序：writeMutex_ -> 队列内部锁)
+    LogQueue queue_;
+    std::thread worker_;
+    std::once_flag workerOnce_; // 第一次异步写入时才启动后台线程
+    std::mutex spillMutex_;
+    std::unique_ptr<SharedLogFile> overflowFile_; // 溢出文件 application.overflow.log
+    LogQueueCounters lastReported_;
+    std::chrono::steady_clock::time_point lastReportTime_;
 
-    // ʽ LogEntry Ϊɶַ
+    // 格式化 LogEntry 为可读字符串
     std::string FormatLogEntry(const LogEntry& entry);
 
-    //  2.4鲢ִ־ļ
+    // 步骤 2.4：检查并执行日志文件滚动
+    // 步骤 4.3：每批写入后检查一次，由 SharedLogFile 协调多进程滚动
     void CheckAndRoll();
-    //  2.4ǰļΪʱıļ
-    void RollFile();
+
+    // 步骤 4.1：后台线程主循环
+    void WorkerLoop();
+    // 启动后台线程 (只执行一次)。不在构造函数中启动：静态 Logger 可能在 DllMain 中构造，
+    // 持有加载器锁时创建线程并等待会导致死锁
+    void StartWorker();
+    // 步骤 4.1：在持有 writeMutex_ 时写入一批条目
+    // 步骤 4.3：整批格式化到 writeBuffer_，一次追加写入
+    void WriteBatchLocked(std::deque<LogEntry>& batch);
+    void AppendBufferLocked();
+    // 步骤 4.1：同步写入溢出文件 (SPILL 策略或 ERROR 阻塞超时)
+    void WriteOverflow(const LogEntry& entry);
+    // 步骤 4.1：计数有变化时把丢弃/阻塞统计写入日志
+    void WriteQueueReportLocked(bool force);
 };
\ No newline at end of file
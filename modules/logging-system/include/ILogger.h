@@ -1,39 +1,55 @@
 // ILogger.h
 #pragma once
 
-//  DLL /
+// 定义 DLL 导出/导入宏
 #ifdef CORELOGGER_EXPORTS
 #define CORELOGGER_API __declspec(dllexport)
 #else
 #define CORELOGGER_API __declspec(dllimport)
 #endif
 
-//  1.1 ILogger ӿ
+// 步骤 1.1：定义 ILogger 接口
 class CORELOGGER_API ILogger {
 public:
-    //  1.2ʵ־¼ֻ¼ַ
+    // 步骤 1.2：实现最基础的日志记录方法（只记录字符串）
     virtual void Log(const char* message) = 0;
 
-    //  2.1ʵִĵ־¼
+    // 步骤 2.1：实现带上下文的日志记录方法（用于类名）
     virtual void Log(const char* message, const char* sourceClass) = 0;
 
-    //  3.1 FATAL ־¼ (쳣)
+    // 步骤 3.1：新增 FATAL 级别日志记录方法 (用于异常捕获)
     virtual void Fatal(const char* message, const char* sourceClass) = 0;
 
-    // ֤̳ȷͷ
+    // 虚析构函数，保证继承类正确释放
     virtual ~ILogger() = default;
+
+    // 步骤 4.10：批量记录 INFO 级别日志 (默认逐条调用 Log；Logger 重写为整批一次写入)
+    // 新增的虚函数声明在析构函数之后，已有虚函数的虚表槽位不变，按旧头文件编译的调用方仍可使用
+    virtual void LogBatch(const char* const* messages, int count, const char* sourceClass) {
+        for (int i = 0; i < count; ++i) {
+            Log(messages[i], sourceClass);
+        }
+    }
 };
 
-//  Logger ʵĹ
+// 步骤 4.2：自监控计数快照 (定义见 LoggerStats.h)
+struct LoggerStatsSnapshot;
+
+// 导出创建 Logger 实例的工厂函数
 
 
 extern "C" {
     CORELOGGER_API ILogger* CreateLogger();
     CORELOGGER_API void DestroyLogger(ILogger* logger);
-    CORELOGGER_API int RunLoggerConsole();      // ̨ģʽ
-    CORELOGGER_API const char* GetLoggerInfo(); // Ϣ
-
-    // Ҫ
-    CORELOGGER_API int run();                   // ģ main 
-    CORELOGGER_API const char* description();   // Ϣ
+    CORELOGGER_API int RunLoggerConsole();      // 控制台模式入口
+    CORELOGGER_API const char* GetLoggerInfo(); // 描述信息
+    CORELOGGER_API void GetLoggerStatsSnapshot(LoggerStatsSnapshot* snapshot); // 步骤 4.2：自监控计数
+    CORELOGGER_API int GetLoggerStats(char* buffer, int bufferSize);           // 步骤 4.2：自监控计数 (JSON)
+    CORELOGGER_API void PushLogContext(const char* key, const char* value);    // 步骤 4.6：压入诊断上下文
+    CORELOGGER_API void PopLogContext();                                       // 步骤 4.6：弹出诊断上下文
+    CORELOGGER_API int GetLockProfileReport(char* buffer, int bufferSize);     // 步骤 4.9：锁竞争报告
+
+    // 添加要求的两个导出函数
+    CORELOGGER_API int run();                   // 模拟 main 函数
+    CORELOGGER_API const char* description();   // 返回描述信息
 }
\ No newline at end of file
@@ -0,0 +1,66 @@
+﻿// LogBatch.h
+#pragma once
+
+#include "ILogger.h"
+#include "LogEntry.h"
+#include "LogFormat.h"
+#include <deque>
+#include <string>
+
+// 步骤 4.10：批量日志构建器
+// - 构造时读取一次最低日志级别，之后每条只与缓存值比较；被过滤的条目不格式化、不入批
+// - 每条记录自己的时间戳、线程 ID 与诊断上下文 (与单条 Log 的输出完全一致)，交给 Logger::LogBatch 后整批只获取一次写锁、一次写入
+// 用法：
+//   LogEntryBatch batch;
+//   for (...) batch.InfoF("BulkSender", "发送第 {} 封", i);
+//   logger.LogBatch(batch);
+class CORELOGGER_API LogEntryBatch {
+public:
+    LogEntryBatch();
+
+    void Add(LogLevel level, std::string&& message, const char* sourceClass);
+    void Add(LogLevel level, const char* message, const char* sourceClass);
+
+    void Info(const char* message, const char* sourceClass) { Add(LogLevel::INFO, message, sourceClass); }
+    void Warn(const char* message, const char* sourceClass) { Add(LogLevel::WARNING, message, sourceClass); }
+    void Error(const char* message, const char* sourceClass) { Add(LogLevel::ERROR_LEVEL, message, sourceClass); }
+
+    // 类型化格式字符串 (见 LogFormat.h)，级别被过滤时不做格式化
+    template <typename... Args>
+    void InfoF(const char* sourceClass, const char* fmt, const Args&... args) {
+        AddF(LogLevel::INFO, sourceClass, fmt, args...);
+    }
+
+    template <typename... Args>
+    void WarnF(const char* sourceClass, const char* fmt, const Args&... args) {
+        AddF(LogLevel::WARNING, sourceClass, fmt, args...);
+    }
+
+    template <typename... Args>
+    void ErrorF(const char* sourceClass, const char* fmt, const Args&... args) {
+        AddF(LogLevel::ERROR_LEVEL, sourceClass, fmt, args...);
+    }
+
+    template <typename... Args>
+    void AddF(LogLevel level, const char* sourceClass, const char* fmt, const Args&... args) {
+        if (!Accepts(level)) {
+            return;
+        }
+        Add(level, LogFormat::Format(fmt, args...), sourceClass);
+    }
+
+    // 本批是否记录该级别 (使用构造时缓存的最低级别)；不记录时计入过滤计数
+    bool Accepts(LogLevel level);
+
+    size_t Size() const { return entries_.size(); }
+    bool Empty() const { return entries_.empty(); }
+    void Clear();
+
+private:
+    friend class Logger;
+
+    std::deque<LogEntry> entries_;
+    LogLevel minLevel_;
+    unsigned long long accepted_[4];   // 按级别累计，提交时一次性计入 LoggerStats
+    unsigned long long filtered_[4];
+};
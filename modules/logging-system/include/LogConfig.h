@@ -5,36 +5,73 @@
 #include "LogEntry.h"
 #include <atomic>
 #include <mutex>
-#include <string> //  3.4:  string
+#include <string> // 步骤 3.4: 引入 string
+#include <cstddef>
 
-//  2.2 / 3.4 LogConfig 
+// 步骤 4.1：异步队列满时的溢出策略 (按级别配置)
+enum class OverflowPolicy {
+    BLOCK,       // 阻塞等待，超时后 INFO/WARN 丢弃，ERROR 写入溢出文件
+    DROP_NEWEST, // 丢弃新到达的条目
+    DROP_OLDEST, // 丢弃队列中最旧的可丢弃条目 (仅 INFO/WARN)
+    SPILL        // 同步写入溢出文件 (application.overflow.log)
+};
+
+// 步骤 2.2 / 3.4：定义 LogConfig 类
 class CORELOGGER_API LogConfig {
 private:
-    //  3.4: Ĭ·Ϊ ./logsĬ MinLevel Ϊ INFOĬϱ 7 
-    LogConfig() : minLevel_(LogLevel::INFO), retentionDays_(7), logFilePath_("./logs") {}
+    // 步骤 3.4: 默认路径为 ./logs，默认 MinLevel 为 INFO，默认保留 7 天
+    // 步骤 4.1: 默认队列容量 8192 条，阻塞超时 200ms，每 60 秒汇报一次丢弃统计
+    LogConfig() : minLevel_(LogLevel::INFO), retentionDays_(7), logFilePath_("./logs"),
+        queueCapacity_(8192), blockTimeoutMs_(200), queueReportIntervalSeconds_(60) {
+        for (auto& policy : overflowPolicies_) {
+            policy.store(OverflowPolicy::BLOCK);
+        }
+    }
     ~LogConfig() = default;
     LogConfig(const LogConfig&) = delete;
     LogConfig& operator=(const LogConfig&) = delete;
 
     std::atomic<LogLevel> minLevel_;
-    std::atomic<int> retentionDays_; //  3.3: ־
-    std::string logFilePath_;        //  3.4: ־ļ洢·
+    std::atomic<int> retentionDays_; // 步骤 3.3: 日志保留天数
+    std::string logFilePath_;        // 步骤 3.4: 日志文件存储路径
+
+    // 步骤 4.1: 异步队列配置 (INFO/WARN/ERROR/FATAL 各自的溢出策略)
+    std::atomic<OverflowPolicy> overflowPolicies_[4];
+    std::atomic<size_t> queueCapacity_;
+    std::atomic<int> blockTimeoutMs_;
+    std::atomic<int> queueReportIntervalSeconds_;
 
-    static std::once_flag initFlag_;
-    static LogConfig* instance_;
+    // 步骤 4.9：原子指针 + 带竞争分析的锁，初始化后的调用只需一次原子读取
+    static std::atomic<LogConfig*> instance_;
 
 public:
     static LogConfig& GetInstance();
 
-    //  2.2ͼ¼
+    // 步骤 2.2：最低记录级别
     void SetMinLogLevel(LogLevel level);
     LogLevel GetMinLogLevel() const;
 
-    //  3.3־
+    // 步骤 3.3：日志保留天数
     void SetRetentionDays(int days);
     int GetRetentionDays() const;
 
-    //  3.4־ļ洢·
+    // 步骤 3.4：日志文件存储路径
     void SetLogFilePath(const std::string& path);
     std::string GetLogFilePath() const;
+
+    // 步骤 4.1：队列溢出策略 (ERROR/FATAL 不允许丢弃，DROP_* 会被改为 BLOCK)
+    void SetOverflowPolicy(LogLevel level, OverflowPolicy policy);
+    OverflowPolicy GetOverflowPolicy(LogLevel level) const;
+
+    // 步骤 4.1：队列容量 (仅对之后创建的 Logger 生效)
+    void SetQueueCapacity(size_t capacity);
+    size_t GetQueueCapacity() const;
+
+    // 步骤 4.1：BLOCK 策略的最长等待时间 (毫秒)
+    void SetBlockTimeoutMs(int timeoutMs);
+    int GetBlockTimeoutMs() const;
+
+    // 步骤 4.1：丢弃/阻塞统计写入日志的间隔 (秒)，0 表示仅在关闭时写入
+    void SetQueueReportIntervalSeconds(int seconds);
+    int GetQueueReportIntervalSeconds() const;
 };
\ No newline at end of file
@@ -0,0 +1,36 @@
+﻿// LogContext.h
+#pragma once
+
+#include "ILogger.h"
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 步骤 4.6：诊断上下文 (MDC) 的不可变快照
+// 每次压入作用域时生成一次并预先渲染，日志条目只持有其引用计数指针，不复制字符串
+struct LogContextSnapshot {
+    std::vector<std::pair<std::string, std::string>> fields; // 外层在前，同名键保留内层值
+    std::string rendered;                                    // "key=value key2=value2"
+};
+
+// 步骤 4.6：线程局部的键/值上下文栈
+// 无上下文时 Current() 返回空指针，Logger::Log 不产生额外开销
+namespace LogContext {
+    // 当前线程的上下文快照 (可能为空)
+    CORELOGGER_API std::shared_ptr<const LogContextSnapshot> Current();
+
+    // 压入/弹出一个键值对；优先使用 LogContextScope 保证成对调用
+    CORELOGGER_API void Push(const std::string& key, const std::string& value);
+    CORELOGGER_API void Pop();
+}
+
+// 步骤 4.6：RAII 作用域，构造时压入键值对，析构时恢复外层上下文
+// 用法：LogContextScope scope("requestId", id);
+class CORELOGGER_API LogContextScope {
+public:
+    LogContextScope(const std::string& key, const std::string& value);
+    ~LogContextScope();
+    LogContextScope(const LogContextScope&) = delete;
+    LogContextScope& operator=(const LogContextScope&) = delete;
+};
@@ -0,0 +1,131 @@
+﻿// LogFormat.h
+#pragma once
+
+#include <charconv>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// 步骤 4.7：类型化格式字符串
+// - 占位符为 "{}"，"{{" / "}}" 输出字面量花括号
+// - 整数/浮点数使用 std::to_chars 直接写入目标字符串 (不依赖 locale，无临时字符串)
+// - 通过 LOG_INFOF/LOG_WARNF/LOG_ERRORF 宏调用时，在编译期检查占位符数量与参数数量
+namespace LogFormat {
+
+    // 统计格式字符串中的占位符数量 (constexpr，用于 static_assert)
+    constexpr size_t CountPlaceholders(const char* fmt) {
+        size_t count = 0;
+        for (size_t i = 0; fmt[i] != '\0'; ++i) {
+            if (fmt[i] == '{') {
+                if (fmt[i + 1] == '{') {
+                    ++i;
+                }
+                else if (fmt[i + 1] == '}') {
+                    ++count;
+                    ++i;
+                }
+            }
+        }
+        return count;
+    }
+
+    // 仅用于 decltype，在不求值的上下文中得到参数个数
+    template <typename... Args>
+    std::integral_constant<size_t, sizeof...(Args)> CountArgs(const Args&...);
+
+    // 各类型参数的追加方式
+    inline void AppendArg(std::string& out, std::string_view value) {
+        out.append(value.data(), value.size());
+    }
+
+    inline void AppendArg(std::string& out, const std::string& value) {
+        out.append(value);
+    }
+
+    inline void AppendArg(std::string& out, const char* value) {
+        out.append(value ? value : "(null)");
+    }
+
+    inline void AppendArg(std::string& out, char value) {
+        out.push_back(value);
+    }
+
+    inline void AppendArg(std::string& out, bool value) {
+        out.append(value ? "true" : "false");
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_arithmetic<T>::value &&
+        !std::is_same<T, bool>::value && !std::is_same<T, char>::value>::type
+        AppendArg(std::string& out, T value) {
+        char buffer[64];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, result.ptr);
+    }
+
+    // 复制 fmt 中下一个占位符之前的文本 (处理转义)，返回占位符之后的位置；没有占位符时返回 nullptr
+    inline const char* CopyUntilPlaceholder(std::string& out, const char* fmt) {
+        const char* p = fmt;
+        while (*p != '\0') {
+            if ((p[0] == '{' && p[1] == '{') || (p[0] == '}' && p[1] == '}')) {
+                out.append(fmt, p + 1);
+                p += 2;
+                fmt = p;
+            }
+            else if (p[0] == '{' && p[1] == '}') {
+                out.append(fmt, p);
+                return p + 2;
+            }
+            else {
+                ++p;
+            }
+        }
+        out.append(fmt, p);
+        return nullptr;
+    }
+
+    inline void FormatTo(std::string& out, const char* fmt) {
+        // 参数已用完：剩余的占位符按原样输出
+        while (fmt) {
+            const char* next = CopyUntilPlaceholder(out, fmt);
+            if (next) {
+                out.append("{}");
+            }
+            fmt = next;
+        }
+    }
+
+    template <typename First, typename... Rest>
+    void FormatTo(std::string& out, const char* fmt, const First& first, const Rest&... rest) {
+        const char* next = CopyUntilPlaceholder(out, fmt);
+        if (!next) {
+            return; // 占位符已用完，多余的参数被忽略
+        }
+        AppendArg(out, first);
+        FormatTo(out, next, rest...);
+    }
+
+    template <typename... Args>
+    std::string Format(const char* fmt, const Args&... args) {
+        std::string out;
+        out.reserve(std::strlen(fmt) + sizeof...(Args) * 16);
+        FormatTo(out, fmt, args...);
+        return out;
+    }
+}
+
+// 步骤 4.7：编译期检查占位符数量的日志宏 (fmt 必须是字符串字面量，至少一个参数)
+// 用法：LOG_INFOF(logger, "BulkSender", "发送第 {} 封，耗时 {} ms", index, elapsed);
+#define LOG_FORMAT_CHECK(fmt, ...) \
+    static_assert(LogFormat::CountPlaceholders(fmt) == decltype(LogFormat::CountArgs(__VA_ARGS__))::value, \
+        "Log format string placeholder count does not match argument count")
+
+#define LOG_INFOF(logger, sourceClass, fmt, ...) \
+    do { LOG_FORMAT_CHECK(fmt, __VA_ARGS__); (logger).InfoF(sourceClass, fmt, __VA_ARGS__); } while (0)
+
+#define LOG_WARNF(logger, sourceClass, fmt, ...) \
+    do { LOG_FORMAT_CHECK(fmt, __VA_ARGS__); (logger).WarnF(sourceClass, fmt, __VA_ARGS__); } while (0)
+
+#define LOG_ERRORF(logger, sourceClass, fmt, ...) \
+    do { LOG_FORMAT_CHECK(fmt, __VA_ARGS__); (logger).ErrorF(sourceClass, fmt, __VA_ARGS__); } while (0)
@@ -0,0 +1,63 @@
+﻿// LogQueue.h
+#pragma once
+
+#include "ILogger.h"
+#include "LogEntry.h"
+#include "LogConfig.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+// 步骤 4.1：入队结果
+enum class EnqueueResult {
+    QUEUED,  // 已进入队列，由后台线程写入
+    DROPPED, // 已丢弃并计数 (仅 INFO/WARN)
+    SPILL    // 调用方需同步写入溢出文件
+};
+
+// 步骤 4.1：按级别统计的丢弃/阻塞/溢出计数 (下标为 LogLevel 数值)
+struct LogQueueCounters {
+    unsigned long long dropped[4] = {};
+    unsigned long long blocked[4] = {};
+    unsigned long long spilled[4] = {};
+};
+
+// 步骤 4.1：有界日志队列，队列满时按 LogConfig 中各级别的 OverflowPolicy 处理
+class CORELOGGER_API LogQueue {
+public:
+    explicit LogQueue(size_t capacity);
+    LogQueue(const LogQueue&) = delete;
+    LogQueue& operator=(const LogQueue&) = delete;
+
+    // 生产者调用：按策略入队
+    EnqueueResult Push(LogEntry&& entry);
+
+    // 消费者调用：等待直到有条目、超时或关闭；返回 false 表示已关闭且队列为空
+    bool WaitForEntries(std::chrono::milliseconds timeout);
+
+    // 消费者调用：取出当前全部条目 (追加到 out 末尾)
+    void PopAll(std::deque<LogEntry>& out);
+
+    // 关闭队列，唤醒所有等待者；之后的 Push 返回 SPILL
+    void Close();
+
+    size_t Size() const;
+    LogQueueCounters GetCounters() const;
+
+private:
+    // DROP_OLDEST：移除最旧的 INFO/WARN 条目，成功返回 true
+    bool EvictOldestDroppable();
+
+    const size_t capacity_;
+    mutable std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::deque<LogEntry> entries_;
+    bool closed_;
+
+    std::atomic<unsigned long long> dropped_[4];
+    std::atomic<unsigned long long> blocked_[4];
+    std::atomic<unsigned long long> spilled_[4];
+};
@@ -0,0 +1,63 @@
+﻿// LogTailReader.h
+#pragma once
+
+#include "ILogger.h"
+#include <string>
+#include <vector>
+#include <map>
+
+// 步骤 4.4：读取位置 (游标)。段号为滚动代数，偏移为段内已消费的字节数
+// 消费者保存游标后重启，可从同一位置继续读取，不会重复或遗漏
+struct LogCursor {
+    long long segmentId = -1;     // -1 表示从当前活动文件开头开始
+    unsigned long long offset = 0;
+};
+
+// 一行日志的视图 (不含换行符)，指向读取器内部缓冲区
+struct LogLineView {
+    const char* data;
+    size_t length;
+};
+
+// 步骤 4.4：跟随读取 (tail -F) 活动日志文件，并依据滚动清单跨滚动无缝续读
+// - 只返回完整的行；行视图指向可复用的内部缓冲区，在下一次 ReadBatch 之前有效
+// - 打开文件时允许共享删除，不会阻止写入进程滚动 (重命名)
+class CORELOGGER_API LogTailReader {
+public:
+    LogTailReader(const std::string& logPath, const std::string& filename, const LogCursor& start = LogCursor());
+    ~LogTailReader();
+    LogTailReader(const LogTailReader&) = delete;
+    LogTailReader& operator=(const LogTailReader&) = delete;
+
+    // 读取一批完整的行 (最多约 maxBytes 字节)，返回行数；无新数据时返回 0
+    size_t ReadBatch(std::vector<LogLineView>& lines, size_t maxBytes = 1 << 20);
+
+    // 等待新数据，最多 timeoutMs 毫秒；有数据可读时返回 true
+    bool WaitForData(unsigned long timeoutMs);
+
+    // 最后一次返回的行之后的位置
+    LogCursor GetCursor() const { return cursor_; }
+
+private:
+    bool OpenSegment();
+    void CloseSegment();
+    bool AdvanceSegment();
+    long long CurrentGeneration();
+    long long SealedGeneration();
+    long long ReadLockSlot(int slot);
+    void LoadManifest();
+    long long FileSize() const;
+
+    std::string logPath_;
+    std::string filename_;
+    std::string fullPath_;
+
+    LogCursor cursor_;
+    void* segment_;                  // HANDLE，当前段的读取句柄
+    void* lockFile_;                 // HANDLE，用于读取共享滚动代数
+    std::map<long long, std::string> manifest_; // 段号 -> 备份文件名
+
+    std::vector<char> buffer_;       // 可复用的读取缓冲区
+    size_t pending_;                 // 缓冲区中尚未返回的不完整行字节数
+    size_t pendingStart_;            // 不完整行在缓冲区中的起始位置
+};
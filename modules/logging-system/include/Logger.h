@@ -5,38 +5,84 @@
 #include "LogEntry.h"
 #include "FileWriter.h"
 #include "LogConfig.h" 
-#include "Stopwatch.h" //  3.2:  Stopwatch
+#include "Stopwatch.h" // 步骤 3.2: 引入 Stopwatch
+#include "LogFormat.h" // 步骤 4.7: 类型化格式字符串
+#include "LogBatch.h" // 步骤 4.10: 批量写入
 #include <memory>
 #include <string>
 
-//  1.1, 3.2ʵ Logger 
+// 步骤 1.1, 3.2：实现 Logger 类
 class CORELOGGER_API Logger : public ILogger {
 public:
     Logger();
     ~Logger() override;
 
-    //  1.2, 1.5ʵ ILogger ӿڷ
+    // 步骤 1.2, 1.5：实现 ILogger 接口方法
     void Log(const char* message) override;
     void Log(const char* message, const char* sourceClass) override;
 
-    //  3.1ʵ Fatal ־¼
+    // 步骤 3.1：实现 Fatal 级别日志记录
     void Fatal(const char* message, const char* sourceClass) override;
 
-    // ʵִĵ־¼Ǻļ¼
+    // 辅助方法：实现带级别和上下文的日志记录（这是核心记录方法）
     void Log(LogLevel level, const char* message, const char* sourceClass);
 
-    //  2.1ʵ Info/Warn/Error õķ
+    // 步骤 2.1：实现 Info/Warn/Error 辅助宏调用的方法
     void Info(const char* message, const char* sourceClass);
     void Warn(const char* message, const char* sourceClass);
     void Error(const char* message, const char* sourceClass);
 
-    //  3.1ע쳣
+    // 步骤 4.7：类型化格式字符串 ("{}" 占位符)，级别未通过过滤时不做任何格式化
+    // 通过 LOG_INFOF/LOG_WARNF/LOG_ERRORF 宏调用可在编译期检查占位符数量
+    template <typename... Args>
+    void InfoF(const char* sourceClass, const char* fmt, const Args&... args) {
+        LogF(LogLevel::INFO, sourceClass, fmt, args...);
+    }
+
+    template <typename... Args>
+    void WarnF(const char* sourceClass, const char* fmt, const Args&... args) {
+        LogF(LogLevel::WARNING, sourceClass, fmt, args...);
+    }
+
+    template <typename... Args>
+    void ErrorF(const char* sourceClass, const char* fmt, const Args&... args) {
+        LogF(LogLevel::ERROR_LEVEL, sourceClass, fmt, args...);
+    }
+
+    template <typename... Args>
+    void LogF(LogLevel level, const char* sourceClass, const char* fmt, const Args&... args) {
+        if (!ShouldLog(level)) {
+            return;
+        }
+        // 直接格式化到条目的消息字符串中，随条目移动进入队列
+        LogMessage(level, LogFormat::Format(fmt, args...), sourceClass);
+    }
+
+    // 步骤 3.1：注册异常处理器
     void RegisterExceptionHandler();
 
+    // 步骤 4.10：批量写入，整批只获取一次写锁、一次写入
+    // - LogEntryBatch：构建器中的条目被移走，调用后批次为空，可继续复用
+    // - 条目数组：整批只读取一次最低级别，时间戳等字段按调用方填写的值输出
+    // - ILogger 接口：一组 INFO 级别的消息
+    void LogBatch(LogEntryBatch& batch);
+    void LogBatch(const LogEntry* entries, size_t count);
+    void LogBatch(const char* const* messages, int count, const char* sourceClass) override;
+
+    // 步骤 4.1：等待异步队列中的条目全部写入文件
+    void Flush();
+
+    // 步骤 4.1：队列丢弃/阻塞/溢出计数 (精确累计值)
+    LogQueueCounters GetQueueCounters() const;
+
 private:
-    std::unique_ptr<FileWriter> fileWriter_;
+    std::shared_ptr<FileWriter> fileWriter_; // 步骤 4.5：进程内按文件共享
+
+    // 步骤 4.7：级别过滤 (记录被过滤计数) 与提交已格式化的消息
+    bool ShouldLog(LogLevel level);
+    void LogMessage(LogLevel level, std::string&& message, const char* sourceClass);
 
-    // ȡǰ߳ ID (Windows)
+    // 辅助方法：获取当前线程 ID (Windows)
     unsigned long GetThreadId() const;
 
 };
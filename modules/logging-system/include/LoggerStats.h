@@ -0,0 +1,43 @@
+﻿// LoggerStats.h
+#pragma once
+
+#include "ILogger.h"
+#include "LogEntry.h"
+#include <cstddef>
+#include <string>
+
+// 步骤 4.2：写入延迟直方图的桶数。第 i 个桶统计 < 2^i 微秒的写入，最后一个桶为溢出桶
+const int LOGGER_LATENCY_BUCKETS = 22;
+
+// 步骤 4.2：日志系统自身的运行计数快照 (进程内所有 Logger 实例的合计)
+// 纯 POD 结构，可通过 GetLoggerStatsSnapshot 跨 DLL 边界传递
+struct LoggerStatsSnapshot {
+    unsigned long long accepted[4];       // 通过级别过滤的条目 (下标为 LogLevel 数值)
+    unsigned long long filtered[4];       // 被最低级别过滤掉的条目
+    unsigned long long bytesWritten;      // 写入主日志文件的字节数
+    unsigned long long flushes;           // 文件刷新次数
+    unsigned long long rollCount;         // 文件滚动次数
+    unsigned long long rollMicrosTotal;   // 滚动累计耗时 (微秒)
+    unsigned long long rollMicrosMax;     // 单次滚动最长耗时 (微秒)
+    unsigned long long queueHighWater;    // 异步队列深度的历史最大值
+    unsigned long long writeLatency[LOGGER_LATENCY_BUCKETS]; // 每批写入 (含刷新) 耗时直方图
+};
+
+// 步骤 4.2：按线程分片的自监控计数
+// 每个线程只写自己的分片 (无锁、无共享缓存行)，读取快照时才汇总所有分片
+namespace LoggerStats {
+    // 步骤 4.10：count 用于批量写入时一次累加整批的计数
+    void RecordAccepted(LogLevel level, unsigned long long count = 1);
+    void RecordFiltered(LogLevel level, unsigned long long count = 1);
+    void RecordBytesWritten(size_t bytes);
+    void RecordFlush();
+    void RecordRoll(long long micros);
+    void RecordQueueDepth(size_t depth);
+    void RecordWriteLatency(long long micros);
+
+    // 汇总所有线程分片 (包括已退出线程的累计值)
+    CORELOGGER_API LoggerStatsSnapshot Snapshot();
+
+    // 将快照格式化为 JSON，便于监控系统采集
+    CORELOGGER_API std::string ToJson(const LoggerStatsSnapshot& snapshot);
+}
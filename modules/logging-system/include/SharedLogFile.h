@@ -0,0 +1,62 @@
+﻿// SharedLogFile.h
+#pragma once
+
+#include "ILogger.h"
+#include <string>
+
+// 步骤 4.3：多进程共享的追加写日志文件
+// - 以 FILE_APPEND_DATA 打开 (等价于 O_APPEND)，每批数据一次 WriteFile，多进程追加不会交错
+// - 通过锁文件 <filename>.lock 上的 LockFileEx 协调滚动，保证同一时刻只有一个进程执行滚动
+// - 锁文件映射到内存，保存共享的滚动代数；其他进程只需比较代数即可发现滚动并重新打开
+// - 追加不加锁，只在映射中登记正在进行的追加；滚动进程等旧段的追加全部结束后才把它标记为已封闭，
+//   LogTailReader 只在段封闭后才认为段已读完
+// - 步骤 4.4：每次滚动在 <filename>.manifest 中记录 "段号 -> 备份文件名"，段号即滚动代数；
+//   滚动时顺带移除备份文件已被保留策略清理的段
+class CORELOGGER_API SharedLogFile {
+public:
+    // rollable = false 时不创建锁文件 (如溢出文件)
+    SharedLogFile(const std::string& logPath, const std::string& filename, bool rollable);
+    ~SharedLogFile();
+    SharedLogFile(const SharedLogFile&) = delete;
+    SharedLogFile& operator=(const SharedLogFile&) = delete;
+
+    bool IsOpen() const;
+
+    // 一次系统调用追加整批数据 (登记后确认其他进程没有滚动，无额外系统调用)
+    bool Append(const char* data, size_t size);
+
+    // 当前文件大小 (字节)，失败返回 -1
+    long long Size() const;
+
+    // 如果其他进程已完成滚动，则重新打开新的活动文件 (无滚动时不产生系统调用)
+    void ReopenIfRolled();
+
+    // 文件大小达到 maxBytes 时滚动：持有锁文件后再次确认，只有一个进程执行重命名
+    // 返回 true 表示由本进程完成了滚动
+    bool RollIfNeeded(unsigned long long maxBytes);
+
+    // 最近一次由本进程滚动生成的备份文件路径
+    const std::string& GetLastRolledPath() const { return lastRolledPath_; }
+
+private:
+    bool Open();
+    void Close();
+    void OpenLockFile();
+    long long CurrentGeneration() const;
+    volatile long long* AppendingCount(long long generation) const;
+    void SealSegment(long long generation);
+    std::string MakeRolledPath() const;
+    void AppendManifest(long long segmentId, const std::string& rolledName);
+    void PruneManifest();
+
+    std::string logPath_;
+    std::string filename_;
+    std::string fullPath_;
+    std::string lastRolledPath_;
+
+    void* file_;                   // HANDLE (避免在头文件中引入 windows.h)
+    void* lockFile_;               // HANDLE
+    void* lockMapping_;            // HANDLE
+    volatile long long* sharedState_;  // 锁文件映射：滚动代数、已封闭代数、正在追加的计数 (见 SharedLogFile.cpp)
+    long long localGeneration_;
+};
@@ -4,16 +4,16 @@
 
 #include <string>
 #include "ILogger.h"
-#include <windows.h> // Ҫ _EXCEPTION_POINTERS
+#include <windows.h> // 需要定义 _EXCEPTION_POINTERS
 
-//  3.1ջ׷ٸ
+// 步骤 3.1：定义堆栈追踪辅助函数
 namespace StackTrace {
-    // עδ쳣
+    // 注册未处理异常过滤器
     CORELOGGER_API void RegisterUnhandledExceptionHandler(ILogger* logger);
 
-    // ȡǰ̵߳ĶջϢ
+    // 获取当前线程的堆栈信息
     std::string GetStackTrace();
 
-    // δ쳣ص
+    // 未处理异常回调函数
     LONG WINAPI UnhandledExceptionFilter(struct _EXCEPTION_POINTERS* ExceptionInfo);
 }
\ No newline at end of file
@@ -6,7 +6,7 @@
 #include <chrono>
 #include <string>
 
-//  3.2ʵһ򵥵 Stopwatch 
+// 步骤 3.2：实现一个简单的 Stopwatch 类
 class CORELOGGER_API Stopwatch {
 public:
     Stopwatch();
@@ -14,9 +14,9 @@ public:
     void Start();
     void Stop();
 
-    // ȡʱ䣨룩
+    // 获取持续时间（秒）
     double GetElapsedSeconds() const;
-    // ȡʱ䣨룩
+    // 获取持续时间（毫秒）
     long long GetElapsedMilliseconds() const;
 
 private:
@@ -25,7 +25,7 @@ private:
     bool isRunning_;
 };
 
-//  3.2ԶʱʱԶ¼־
+// 步骤 3.2：自动计时器，在析构时自动记录日志
 class CORELOGGER_API ScopedTimer {
 public:
     ScopedTimer(ILogger* logger, const char* sourceClass, const char* contextMessage);
@@ -2,20 +2,76 @@
 #include "pch.h"
 #include "FileWriter.h"
 #include "LogConfig.h" // 引入 LogConfig 获取保留天数
+#include "LoggerStats.h" // 步骤 4.2：自监控计数
+#include "LogContext.h" // 步骤 4.6：诊断上下文
+#include "ProfiledMutex.h" // 步骤 4.9：锁竞争分析
 #include <sstream> 
 #include <ctime>   
 #include <iostream> 
 #include <Windows.h> 
 #include <filesystem> 
+#include <cstring>
+#include <algorithm>
+#include <map>
+#include <cctype>
 
 namespace fs = std::filesystem;
 
 // 固定文件名为 "application.log"
 const std::string DEFAULT_LOG_FILENAME = "application.log";
 
+namespace {
+    // 步骤 4.5：进程内共享 FileWriter 的注册表 (按规范化路径索引)
+    // 只保存 weak_ptr：最后一个使用者释放后 FileWriter 即析构并关闭文件
+    struct WriterRegistry {
+        std::mutex mutex;
+        std::map<std::string, std::weak_ptr<FileWriter>> writers;
+    };
+
+    // 有意泄漏：DLL 卸载时静态对象析构顺序不确定，Logger 可能晚于注册表释放
+    WriterRegistry& GetWriterRegistry() {
+        static WriterRegistry* registry = new WriterRegistry();
+        return *registry;
+    }
+
+    // 绝对路径 + 统一分隔符 + 小写 (Windows 路径不区分大小写)
+    std::string CanonicalLogPath(const std::string& logPath, const std::string& filename) {
+        std::string path = (fs::path(logPath) / filename).string();
+        char fullPath[MAX_PATH];
+        DWORD length = ::GetFullPathNameA(path.c_str(), MAX_PATH, fullPath, nullptr);
+        if (length > 0 && length < MAX_PATH) {
+            path.assign(fullPath, length);
+        }
+        std::replace(path.begin(), path.end(), '/', '\\');
+        std::transform(path.begin(), path.end(), path.begin(),
+            [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return path;
+    }
+}
+
+// 步骤 4.5：同一文件只创建一个 FileWriter，多个 Logger 共享同一队列、缓冲区与滚动
+std::shared_ptr<FileWriter> FileWriter::Acquire(const std::string& filename, const std::string& logPath) {
+    const std::string key = CanonicalLogPath(logPath, filename);
+    WriterRegistry& registry = GetWriterRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    std::shared_ptr<FileWriter> writer = registry.writers[key].lock();
+    if (!writer) {
+        // 清理已释放的条目，避免路径配置频繁变化时注册表无限增长
+        for (auto it = registry.writers.begin(); it != registry.writers.end();) {
+            it = it->second.expired() ? registry.writers.erase(it) : std::next(it);
+        }
+        writer = std::make_shared<FileWriter>(filename, logPath);
+        registry.writers[key] = writer;
+    }
+    return writer;
+}
+
 // 步骤 1.3, 3.4：实现 FileWriter 构造函数 (使用 logPath)
 FileWriter::FileWriter(const std::string& filename, const std::string& logPath)
-    : filename_(filename), logPath_(logPath), isFirstWrite_(true) {
+    : filename_(filename), logPath_(logPath), writeMutex_(std::make_unique<ProfiledMutex>("FileWriter::writeMutex_")), isFirstWrite_(true),
+    queue_(LogConfig::GetInstance().GetQueueCapacity()),
+    lastReportTime_(std::chrono::steady_clock::now()) {
 
     // 步骤 3.4：确保日志目录存在
     try {
@@ -23,21 +79,28 @@ FileWriter::FileWriter(const std::string& filename, const std::string& logPath)
             fs::create_directories(logPath_);
         }
 
-        fs::path fullPath = fs::path(logPath_) / filename_;
-        fileStream_.open(fullPath.string(), std::ios::out | std::ios::app);
-        if (!fileStream_.is_open()) {
-            std::cerr << "Error: Could not open log file: " << fullPath.string() << std::endl;
-        }
+        // 步骤 4.3：以追加模式打开共享文件 (打开失败时 SharedLogFile 会输出错误)
+        file_ = std::make_unique<SharedLogFile>(logPath_, filename_, true);
     }
     catch (const fs::filesystem_error& e) {
         std::cerr << "Error creating log directory or opening file: " << e.what() << std::endl;
     }
+    // 步骤 4.1：后台写线程在第一次异步写入时启动 (见 StartWorker)
+}
+
+// 步骤 4.1：延迟启动后台写线程
+void FileWriter::StartWorker() {
+    std::call_once(workerOnce_, [this]() {
+        worker_ = std::thread(&FileWriter::WorkerLoop, this);
+    });
 }
 
 // 步骤 1.3：实现 ~FileWriter 析构函数
+// 步骤 4.1：先关闭队列并等待后台线程写完剩余条目
 FileWriter::~FileWriter() {
-    if (fileStream_.is_open()) {
-        fileStream_.close();
+    queue_.Close();
+    if (worker_.joinable()) {
+        worker_.join();
     }
 }
 
@@ -64,8 +127,10 @@ void FileWriter::RunCleanup() {
         for (const auto& entry : fs::directory_iterator(logPath_)) {
             if (entry.is_regular_file()) {
                 // 仅处理备份日志文件 (带时间戳)
+                // 步骤 4.3：只处理 .log 文件，跳过滚动锁文件与滚动清单
                 if (entry.path().filename().string().find(DEFAULT_LOG_FILENAME.substr(0, DEFAULT_LOG_FILENAME.find_last_of('.'))) == 0 &&
-                    entry.path().filename().string() != DEFAULT_LOG_FILENAME) {
+                    entry.path().filename().string() != DEFAULT_LOG_FILENAME &&
+                    entry.path().extension() == ".log") {
 
                     // 获取文件最后修改时间
                     auto ftime = fs::last_write_time(entry.path());
@@ -94,84 +159,17 @@ void FileWriter::RunCleanup() {
 
 
 // 步骤 2.4：实现 CheckAndRoll()
+// 步骤 4.3：大小检查使用文件句柄 (GetFileSizeEx)，滚动由持有锁文件的唯一进程执行
 void FileWriter::CheckAndRoll() {
-    // ... (保持不变) ...
-    if (!fileStream_.is_open()) {
-        return;
-    }
-
-    // 1. 确保所有待写入数据已同步到文件
-    fileStream_.flush();
-
-    // 2. 备份当前写入位置
-    std::streampos current_pos = fileStream_.tellp();
-
-    // 3. 将写入指针移动到文件末尾
-    fileStream_.seekp(0, std::ios::end);
-
-    // 4. 获取文件大小 (当前位置即为文件大小)
-    __int64 currentSize = static_cast<__int64>(fileStream_.tellp());
-
-    // 5. 恢复写入位置
-    fileStream_.seekp(current_pos);
-
-    // 6. 检查是否达到最大值
-    if (currentSize >= MAX_LOG_FILE_SIZE_BYTES) {
-        RollFile();
-    }
-}
-
-
-// 步骤 2.4：实现文件滚动逻辑
-void FileWriter::RollFile() {
-    // 1. 关闭当前文件流，确保文件句柄释放
-    if (fileStream_.is_open()) {
-        fileStream_.close();
-    }
-
-    // 强制短暂等待，确保 Windows 释放文件句柄
-    ::Sleep(50);
-
-    // 2. 生成带时间戳的新文件名 (application.YYYYMMDD_HHMMSS.log)
-    auto now = std::chrono::system_clock::now();
-    const auto now_time = std::chrono::system_clock::to_time_t(now);
-    std::tm bt{};
-
-    if (localtime_s(&bt, &now_time) != 0) {
-        std::cerr << "Error generating timestamp for log roll." << std::endl;
-        fs::path fullPath = fs::path(logPath_) / filename_;
-        fileStream_.open(fullPath.string(), std::ios::out | std::ios::app);
+    if (!file_ || !file_->IsOpen()) {
         return;
     }
 
-    char timeBuffer[50];
-    std::strftime(timeBuffer, sizeof(timeBuffer), ".%Y%m%d_%H%M%S.log", &bt);
-
-    size_t dot_pos = filename_.find_last_of('.');
-    std::string newFilenameBase = (dot_pos != std::string::npos) ? filename_.substr(0, dot_pos) : filename_;
-    std::string newFilename = newFilenameBase + timeBuffer;
-
-    fs::path oldFullPath = fs::path(logPath_) / filename_;
-    fs::path newFullPath = fs::path(logPath_) / newFilename;
-
-    // 3. 重命名旧文件 (使用 MoveFileA)
-    if (fs::exists(oldFullPath)) {
-        if (::MoveFileA(oldFullPath.string().c_str(), newFullPath.string().c_str())) {
-            // Success
-            std::cout << "Log file rolled: " << oldFullPath.string() << " -> " << newFullPath.string() << std::endl;
-        }
-        else {
-            // Failure: 打印 Windows 错误码
-            DWORD error = ::GetLastError();
-            std::cerr << "--- ROLL FAILED --- Error renaming file: " << oldFullPath.string()
-                << ", WinError: " << error << ". File is LOCKED by OS." << std::endl;
-        }
-    }
-
-    // 4. 重新打开文件流，创建新的 application.log
-    fileStream_.open(oldFullPath.string(), std::ios::out | std::ios::app);
-    if (!fileStream_.is_open()) {
-        std::cerr << "Error: Could not reopen log file after roll: " << oldFullPath.string() << std::endl;
+    // 步骤 4.2：记录滚动次数与耗时
+    auto rollStart = std::chrono::steady_clock::now();
+    if (file_->RollIfNeeded(MAX_LOG_FILE_SIZE_BYTES)) {
+        LoggerStats::RecordRoll(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - rollStart).count());
     }
 }
 
@@ -192,24 +190,184 @@ std::string FileWriter::FormatLogEntry(const LogEntry& entry) {
     ss << timeBuffer
         << " [" << LogEntry::LevelToString(entry.level) << "] "
         << " [TID:" << entry.threadId << "] "
-        << " [" << entry.sourceClass << "] "
-        << entry.message << "\n";
+        << " [" << entry.sourceClass << "] ";
+    // 步骤 4.6：有诊断上下文时输出预先渲染的 [key=value ...]
+    if (entry.context) {
+        ss << "[" << entry.context->rendered << "] ";
+    }
+    ss << entry.message << "\n";
 
     return ss.str();
 }
 
 // 步骤 1.3, 2.4, 3.3：实现 Write 
 void FileWriter::Write(const LogEntry& entry) {
-    std::lock_guard<std::mutex> lock(writeMutex_);
+    Write(LogEntry(entry));
+}
+
+// 步骤 4.1：FATAL 同步写入 (崩溃前必须落盘)，其余级别交给队列按溢出策略处理
+void FileWriter::Write(LogEntry&& entry) {
+    if (entry.level == LogLevel::FATAL) {
+        std::lock_guard<ProfiledMutex> lock(*writeMutex_);
+        // 先写出队列中更早的条目，保证顺序
+        std::deque<LogEntry> pending;
+        queue_.PopAll(pending);
+        pending.push_back(std::move(entry));
+        WriteBatchLocked(pending); // 批量写入后强制刷新，确保 FATAL 级别的日志能够立刻写入磁盘
+        return;
+    }
+
+    StartWorker();
+
+    // Push 仅在 QUEUED 时移走 entry，SPILL 时 entry 仍然有效
+    if (queue_.Push(std::move(entry)) == EnqueueResult::SPILL) {
+        WriteOverflow(entry);
+    }
+}
+
+// 步骤 4.10：实现 WriteBatch (先写出队列中更早的条目，保证顺序)
+void FileWriter::WriteBatch(std::deque<LogEntry>&& entries) {
+    if (entries.empty()) {
+        return;
+    }
+    std::lock_guard<ProfiledMutex> lock(*writeMutex_);
+    std::deque<LogEntry> pending;
+    queue_.PopAll(pending);
+    if (pending.empty()) {
+        pending.swap(entries);
+    }
+    else {
+        for (auto& entry : entries) {
+            pending.push_back(std::move(entry));
+        }
+        entries.clear();
+    }
+    WriteBatchLocked(pending);
+}
+
+// 步骤 4.1：实现 Flush
+void FileWriter::Flush() {
+    std::lock_guard<ProfiledMutex> lock(*writeMutex_);
+    std::deque<LogEntry> pending;
+    queue_.PopAll(pending);
+    WriteBatchLocked(pending);
+}
+
+// 步骤 4.1：实现 GetQueueCounters
+LogQueueCounters FileWriter::GetQueueCounters() const {
+    return queue_.GetCounters();
+}
+
+// 步骤 4.1：后台线程循环，每批只刷新一次
+void FileWriter::WorkerLoop() {
+    std::deque<LogEntry> batch;
+    bool running = true;
+    while (running) {
+        running = queue_.WaitForEntries(std::chrono::milliseconds(200));
+
+        std::lock_guard<ProfiledMutex> lock(*writeMutex_);
+        queue_.PopAll(batch);
+        WriteBatchLocked(batch);
+        WriteQueueReportLocked(!running);
+    }
+}
+
+// 步骤 4.1：实现 WriteBatchLocked
+void FileWriter::WriteBatchLocked(std::deque<LogEntry>& batch) {
+    if (batch.empty()) {
+        return;
+    }
+    auto batchStart = std::chrono::steady_clock::now();
 
     // 步骤 3.3：在第一次写入前执行清理 (同步/启动时检查)
     RunCleanup();
 
-    // 步骤 2.4：在写入之前检查文件大小
-    CheckAndRoll();
+    // 步骤 4.3：其他进程滚动后先切换到新文件
+    if (file_) {
+        file_->ReopenIfRolled();
+    }
+    long long fileSize = file_ ? (std::max)(file_->Size(), 0LL) : 0;
+
+    // 整批格式化到同一缓冲区；缓冲区将使文件达到滚动阈值时在该条目边界处拆分
+    writeBuffer_.clear();
+    for (const auto& entry : batch) {
+        writeBuffer_ += FormatLogEntry(entry);
+        if (fileSize + static_cast<long long>(writeBuffer_.size()) >= static_cast<long long>(MAX_LOG_FILE_SIZE_BYTES)) {
+            AppendBufferLocked();
+            CheckAndRoll(); // 步骤 2.4：达到阈值后滚动
+            fileSize = file_ ? (std::max)(file_->Size(), 0LL) : 0;
+        }
+    }
+    batch.clear();
+    AppendBufferLocked();
+    // 步骤 4.2：记录每批写入 (含刷新) 的耗时
+    LoggerStats::RecordWriteLatency(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - batchStart).count());
+}
 
-    if (fileStream_.is_open()) {
-        fileStream_ << FormatLogEntry(entry);
-        fileStream_.flush(); // 强制刷新，确保 FATAL 级别的日志能够立刻写入磁盘
+// 步骤 4.3：一次系统调用追加 writeBuffer_ 中的全部数据
+void FileWriter::AppendBufferLocked() {
+    if (writeBuffer_.empty()) {
+        return;
     }
+    if (file_ && file_->Append(writeBuffer_.data(), writeBuffer_.size())) {
+        LoggerStats::RecordBytesWritten(writeBuffer_.size());
+        LoggerStats::RecordFlush();
+    }
+    writeBuffer_.clear();
+}
+
+// 步骤 4.1：实现 WriteOverflow
+void FileWriter::WriteOverflow(const LogEntry& entry) {
+    std::lock_guard<std::mutex> lock(spillMutex_);
+    if (!overflowFile_) {
+        size_t dot_pos = filename_.find_last_of('.');
+        std::string base = (dot_pos != std::string::npos) ? filename_.substr(0, dot_pos) : filename_;
+        overflowFile_ = std::make_unique<SharedLogFile>(logPath_, base + ".overflow.log", false);
+    }
+    std::string line = FormatLogEntry(entry);
+    overflowFile_->Append(line.data(), line.size());
+}
+
+// 步骤 4.1：实现 WriteQueueReportLocked (计数为累计值，仅在变化时写入)
+void FileWriter::WriteQueueReportLocked(bool force) {
+    int interval = LogConfig::GetInstance().GetQueueReportIntervalSeconds();
+    auto now = std::chrono::steady_clock::now();
+    if (!force && (interval <= 0 || now - lastReportTime_ < std::chrono::seconds(interval))) {
+        return;
+    }
+    lastReportTime_ = now;
+
+    LogQueueCounters counters = queue_.GetCounters();
+    if (std::memcmp(&counters, &lastReported_, sizeof(counters)) == 0) {
+        return;
+    }
+    lastReported_ = counters;
+
+    auto appendLevels = [](std::stringstream& ss, const char* name, const unsigned long long* values) {
+        ss << name << "[";
+        for (int i = 0; i < 4; ++i) {
+            ss << (i > 0 ? "," : "") << LogEntry::LevelToString(static_cast<LogLevel>(i)) << "=" << values[i];
+        }
+        ss << "]";
+    };
+
+    std::stringstream ss;
+    ss << "Queue overflow stats: ";
+    appendLevels(ss, "dropped", counters.dropped);
+    ss << " ";
+    appendLevels(ss, "blocked", counters.blocked);
+    ss << " ";
+    appendLevels(ss, "spilled", counters.spilled);
+
+    LogEntry report;
+    report.timestamp = std::chrono::system_clock::now();
+    report.level = LogLevel::WARNING;
+    report.message = ss.str();
+    report.threadId = static_cast<unsigned long>(::GetCurrentThreadId());
+    report.sourceClass = "LogQueue";
+
+    std::deque<LogEntry> reportBatch;
+    reportBatch.push_back(std::move(report));
+    WriteBatchLocked(reportBatch);
 }
\ No newline at end of file
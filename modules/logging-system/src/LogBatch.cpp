@@ -0,0 +1,52 @@
+﻿// LogBatch.cpp
+#include "pch.h"
+#include "LogBatch.h"
+#include "LogConfig.h"
+#include "LogContext.h"
+#include <Windows.h>
+
+// 步骤 4.10：实现 LogEntryBatch 构造函数 (整批只读取一次配置)
+LogEntryBatch::LogEntryBatch()
+    : minLevel_(LogConfig::GetInstance().GetMinLogLevel()),
+    accepted_{ 0, 0, 0, 0 }, filtered_{ 0, 0, 0, 0 } {
+}
+
+bool LogEntryBatch::Accepts(LogLevel level) {
+    if (level < minLevel_) {
+        if (level < LogLevel::NONE) {
+            ++filtered_[static_cast<int>(level)];
+        }
+        return false;
+    }
+    return true;
+}
+
+void LogEntryBatch::Add(LogLevel level, const char* message, const char* sourceClass) {
+    if (!Accepts(level)) {
+        return;
+    }
+    Add(level, std::string(message ? message : ""), sourceClass);
+}
+
+void LogEntryBatch::Add(LogLevel level, std::string&& message, const char* sourceClass) {
+    if (!Accepts(level) || level >= LogLevel::NONE) {
+        return;
+    }
+    entries_.emplace_back();
+    LogEntry& entry = entries_.back();
+    entry.timestamp = std::chrono::system_clock::now();
+    entry.level = level;
+    entry.message = std::move(message);
+    entry.threadId = static_cast<unsigned long>(::GetCurrentThreadId());
+    entry.sourceClass = sourceClass ? sourceClass : "Unknown";
+    entry.context = LogContext::Current();
+    ++accepted_[static_cast<int>(level)];
+}
+
+void LogEntryBatch::Clear() {
+    entries_.clear();
+    for (int i = 0; i < 4; ++i) {
+        accepted_[i] = 0;
+        filtered_[i] = 0;
+    }
+}
@@ -1,58 +1,121 @@
 // LogConfig.cpp
 #include "pch.h"
 #include "LogConfig.h"
+#include "ProfiledMutex.h" // 步骤 4.9：锁竞争分析
 
-// ʼ̬Ա
-std::once_flag LogConfig::initFlag_;
-LogConfig* LogConfig::instance_ = nullptr;
+// 初始化静态成员
+std::atomic<LogConfig*> LogConfig::instance_{ nullptr };
 
-//  2.2 / 3.4ʵ LogConfig::GetInstance()
+// 步骤 2.2 / 3.4：实现 LogConfig::GetInstance()
+// 步骤 4.9：双重检查，首次初始化时的等待计入 "LogConfig::GetInstance" 的锁统计
 LogConfig& LogConfig::GetInstance() {
-    std::call_once(initFlag_, []() {
-        instance_ = new LogConfig();
-        });
-    // ȷڽ˳ʱͷڴ
+    LogConfig* config = instance_.load(std::memory_order_acquire);
+    if (config != nullptr) {
+        return *config;
+    }
+
+    static ProfiledMutex initMutex("LogConfig::GetInstance");
+    std::lock_guard<ProfiledMutex> lock(initMutex);
+    config = instance_.load(std::memory_order_relaxed);
+    if (config == nullptr) {
+        config = new LogConfig();
+        instance_.store(config, std::memory_order_release);
+    }
+    // 确保在进程退出时释放内存
     static struct LogConfigCleaner {
         ~LogConfigCleaner() {
-            delete instance_;
+            delete instance_.exchange(nullptr);
         }
     } cleaner;
 
-    if (instance_ == nullptr) {
-        throw std::runtime_error("LogConfig initialization failed.");
-    }
-    return *instance_;
+    return *config;
 }
 
-//  2.2ʵ SetMinLogLevel
+// 步骤 2.2：实现 SetMinLogLevel
 void LogConfig::SetMinLogLevel(LogLevel level) {
     minLevel_.store(level);
 }
 
-//  2.2ʵ GetMinLogLevel
+// 步骤 2.2：实现 GetMinLogLevel
 LogLevel LogConfig::GetMinLogLevel() const {
     return minLevel_.load();
 }
 
-//  3.3ʵ SetRetentionDays
+// 步骤 3.3：实现 SetRetentionDays
 void LogConfig::SetRetentionDays(int days) {
     if (days >= 0) {
         retentionDays_.store(days);
     }
 }
 
-//  3.3ʵ GetRetentionDays
+// 步骤 3.3：实现 GetRetentionDays
 int LogConfig::GetRetentionDays() const {
     return retentionDays_.load();
 }
 
-//  3.4ʵ SetLogFilePath
+// 步骤 3.4：实现 SetLogFilePath
 void LogConfig::SetLogFilePath(const std::string& path) {
-    // Note: Ӧ·淶̰߳ȫ
+    // Note: 生产环境中应考虑路径规范化和线程安全
     logFilePath_ = path;
 }
 
-//  3.4ʵ GetLogFilePath
+// 步骤 3.4：实现 GetLogFilePath
 std::string LogConfig::GetLogFilePath() const {
     return logFilePath_;
+}
+
+// 步骤 4.1：实现 SetOverflowPolicy (ERROR/FATAL 永不丢弃)
+void LogConfig::SetOverflowPolicy(LogLevel level, OverflowPolicy policy) {
+    if (level == LogLevel::NONE) {
+        return;
+    }
+    if (level >= LogLevel::ERROR_LEVEL &&
+        (policy == OverflowPolicy::DROP_NEWEST || policy == OverflowPolicy::DROP_OLDEST)) {
+        policy = OverflowPolicy::BLOCK;
+    }
+    overflowPolicies_[static_cast<int>(level)].store(policy);
+}
+
+// 步骤 4.1：实现 GetOverflowPolicy
+OverflowPolicy LogConfig::GetOverflowPolicy(LogLevel level) const {
+    if (level == LogLevel::NONE) {
+        return OverflowPolicy::BLOCK;
+    }
+    return overflowPolicies_[static_cast<int>(level)].load();
+}
+
+// 步骤 4.1：实现 SetQueueCapacity
+void LogConfig::SetQueueCapacity(size_t capacity) {
+    if (capacity > 0) {
+        queueCapacity_.store(capacity);
+    }
+}
+
+// 步骤 4.1：实现 GetQueueCapacity
+size_t LogConfig::GetQueueCapacity() const {
+    return queueCapacity_.load();
+}
+
+// 步骤 4.1：实现 SetBlockTimeoutMs
+void LogConfig::SetBlockTimeoutMs(int timeoutMs) {
+    if (timeoutMs >= 0) {
+        blockTimeoutMs_.store(timeoutMs);
+    }
+}
+
+// 步骤 4.1：实现 GetBlockTimeoutMs
+int LogConfig::GetBlockTimeoutMs() const {
+    return blockTimeoutMs_.load();
+}
+
+// 步骤 4.1：实现 SetQueueReportIntervalSeconds
+void LogConfig::SetQueueReportIntervalSeconds(int seconds) {
+    if (seconds >= 0) {
+        queueReportIntervalSeconds_.store(seconds);
+    }
+}
+
+// 步骤 4.1：实现 GetQueueReportIntervalSeconds
+int LogConfig::GetQueueReportIntervalSeconds() const {
+    return queueReportIntervalSeconds_.load();
 }
\ No newline at end of file
@@ -0,0 +1,58 @@
+﻿// LogContext.cpp
+#include "pch.h"
+#include "LogContext.h"
+
+namespace {
+    // 栈中每一层都是完整快照，弹出时直接恢复上一层，无需重新构建
+    thread_local std::vector<std::shared_ptr<const LogContextSnapshot>> t_contextStack;
+}
+
+namespace LogContext {
+    std::shared_ptr<const LogContextSnapshot> Current() {
+        if (t_contextStack.empty()) {
+            return nullptr;
+        }
+        return t_contextStack.back();
+    }
+
+    // 步骤 4.6：基于外层快照生成新快照 (每个作用域只复制一次)
+    void Push(const std::string& key, const std::string& value) {
+        auto snapshot = std::make_shared<LogContextSnapshot>();
+        if (!t_contextStack.empty()) {
+            snapshot->fields = t_contextStack.back()->fields;
+        }
+
+        bool replaced = false;
+        for (auto& field : snapshot->fields) {
+            if (field.first == key) {
+                field.second = value;
+                replaced = true;
+            }
+        }
+        if (!replaced) {
+            snapshot->fields.emplace_back(key, value);
+        }
+
+        for (const auto& field : snapshot->fields) {
+            if (!snapshot->rendered.empty()) {
+                snapshot->rendered += ' ';
+            }
+            snapshot->rendered += field.first + "=" + field.second;
+        }
+        t_contextStack.push_back(std::move(snapshot));
+    }
+
+    void Pop() {
+        if (!t_contextStack.empty()) {
+            t_contextStack.pop_back();
+        }
+    }
+}
+
+LogContextScope::LogContextScope(const std::string& key, const std::string& value) {
+    LogContext::Push(key, value);
+}
+
+LogContextScope::~LogContextScope() {
+    LogContext::Pop();
+}
@@ -0,0 +1,152 @@
+﻿// LogQueue.cpp
+#include "pch.h"
+#include "LogQueue.h"
+#include "LoggerStats.h"
+
+namespace {
+    // INFO/WARN 可丢弃，ERROR/FATAL 永不丢弃
+    bool IsDroppable(LogLevel level) {
+        return level < LogLevel::ERROR_LEVEL;
+    }
+
+    int LevelIndex(LogLevel level) {
+        return static_cast<int>(level);
+    }
+}
+
+// 步骤 4.1：实现 LogQueue 构造函数
+LogQueue::LogQueue(size_t capacity)
+    : capacity_(capacity > 0 ? capacity : 1), closed_(false) {
+    for (int i = 0; i < 4; ++i) {
+        dropped_[i].store(0);
+        blocked_[i].store(0);
+        spilled_[i].store(0);
+    }
+}
+
+// 步骤 4.1：按级别策略入队
+EnqueueResult LogQueue::Push(LogEntry&& entry) {
+    const int idx = LevelIndex(entry.level);
+    const bool droppable = IsDroppable(entry.level);
+    const OverflowPolicy policy = LogConfig::GetInstance().GetOverflowPolicy(entry.level);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (closed_) {
+        spilled_[idx].fetch_add(1);
+        return EnqueueResult::SPILL;
+    }
+
+    if (entries_.size() >= capacity_) {
+        switch (policy) {
+        case OverflowPolicy::DROP_NEWEST:
+            if (droppable) {
+                dropped_[idx].fetch_add(1);
+                return EnqueueResult::DROPPED;
+            }
+            break;
+        case OverflowPolicy::DROP_OLDEST:
+            if (!EvictOldestDroppable() && droppable) {
+                dropped_[idx].fetch_add(1);
+                return EnqueueResult::DROPPED;
+            }
+            break;
+        case OverflowPolicy::SPILL:
+            spilled_[idx].fetch_add(1);
+            return EnqueueResult::SPILL;
+        case OverflowPolicy::BLOCK:
+        default:
+            break;
+        }
+
+        // BLOCK (以及 ERROR 级别无法丢弃时)：等待空位，超时后 INFO/WARN 丢弃，ERROR 溢出
+        if (entries_.size() >= capacity_) {
+            blocked_[idx].fetch_add(1);
+            const auto timeout = std::chrono::milliseconds(LogConfig::GetInstance().GetBlockTimeoutMs());
+            bool hasSpace = notFull_.wait_for(lock, timeout, [this]() {
+                return closed_ || entries_.size() < capacity_;
+                });
+            if (!hasSpace || closed_) {
+                if (droppable) {
+                    dropped_[idx].fetch_add(1);
+                    return EnqueueResult::DROPPED;
+                }
+                spilled_[idx].fetch_add(1);
+                return EnqueueResult::SPILL;
+            }
+        }
+    }
+
+    entries_.push_back(std::move(entry));
+    const size_t depth = entries_.size();
+    lock.unlock();
+    LoggerStats::RecordQueueDepth(depth); // 步骤 4.2：队列深度高水位
+    notEmpty_.notify_one();
+    return EnqueueResult::QUEUED;
+}
+
+// 步骤 4.1：DROP_OLDEST 只淘汰 INFO/WARN 条目
+bool LogQueue::EvictOldestDroppable() {
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        if (IsDroppable(it->level)) {
+            dropped_[LevelIndex(it->level)].fetch_add(1);
+            entries_.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+// 步骤 4.1：消费者等待新条目
+bool LogQueue::WaitForEntries(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    notEmpty_.wait_for(lock, timeout, [this]() {
+        return closed_ || !entries_.empty();
+        });
+    return !(closed_ && entries_.empty());
+}
+
+// 步骤 4.1：一次性取出全部条目，减少加锁次数
+void LogQueue::PopAll(std::deque<LogEntry>& out) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (entries_.empty()) {
+            return;
+        }
+        if (out.empty()) {
+            out.swap(entries_);
+        }
+        else {
+            for (auto& entry : entries_) {
+                out.push_back(std::move(entry));
+            }
+            entries_.clear();
+        }
+    }
+    notFull_.notify_all();
+}
+
+// 步骤 4.1：关闭队列
+void LogQueue::Close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+    }
+    notEmpty_.notify_all();
+    notFull_.notify_all();
+}
+
+size_t LogQueue::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+// 步骤 4.1：读取计数快照
+LogQueueCounters LogQueue::GetCounters() const {
+    LogQueueCounters counters;
+    for (int i = 0; i < 4; ++i) {
+        counters.dropped[i] = dropped_[i].load();
+        counters.blocked[i] = blocked_[i].load();
+        counters.spilled[i] = spilled_[i].load();
+    }
+    return counters;
+}
@@ -0,0 +1,288 @@
+﻿// LogTailReader.cpp
+#include "pch.h"
+#include "LogTailReader.h"
+#include <Windows.h>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace {
+    HANDLE AsHandle(void* h) {
+        return static_cast<HANDLE>(h);
+    }
+
+    // 与 SharedLogFile 一致：允许写入进程在读取期间重命名/删除文件
+    const DWORD SHARE_ALL = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+
+    // 等待新数据时的轮询间隔
+    const DWORD POLL_INTERVAL_MS = 50;
+
+    HANDLE OpenForRead(const std::string& path) {
+        return ::CreateFileA(path.c_str(), GENERIC_READ, SHARE_ALL, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    }
+
+    // 从 offset 处读取最多 size 字节
+    DWORD ReadAt(HANDLE h, unsigned long long offset, char* dest, DWORD size) {
+        LARGE_INTEGER pos{};
+        pos.QuadPart = static_cast<LONGLONG>(offset);
+        DWORD got = 0;
+        if (!::SetFilePointerEx(h, pos, nullptr, FILE_BEGIN) || !::ReadFile(h, dest, size, &got, nullptr)) {
+            return 0;
+        }
+        return got;
+    }
+}
+
+// 步骤 4.4：实现 LogTailReader 构造函数
+LogTailReader::LogTailReader(const std::string& logPath, const std::string& filename, const LogCursor& start)
+    : logPath_(logPath), filename_(filename),
+    fullPath_((fs::path(logPath) / filename).string()),
+    cursor_(start), segment_(INVALID_HANDLE_VALUE), lockFile_(INVALID_HANDLE_VALUE),
+    pending_(0), pendingStart_(0) {
+}
+
+LogTailReader::~LogTailReader() {
+    CloseSegment();
+    if (lockFile_ != INVALID_HANDLE_VALUE) {
+        ::CloseHandle(AsHandle(lockFile_));
+    }
+}
+
+void LogTailReader::CloseSegment() {
+    if (segment_ != INVALID_HANDLE_VALUE) {
+        ::CloseHandle(AsHandle(segment_));
+        segment_ = INVALID_HANDLE_VALUE;
+    }
+}
+
+// 步骤 4.4：读取锁文件中的一个 8 字节计数 (布局见 SharedLogFile.cpp)；锁文件不存在时为 0
+long long LogTailReader::ReadLockSlot(int slot) {
+    if (lockFile_ == INVALID_HANDLE_VALUE) {
+        lockFile_ = OpenForRead(fullPath_ + ".lock");
+        if (lockFile_ == INVALID_HANDLE_VALUE) {
+            return 0;
+        }
+    }
+    long long value = 0;
+    const unsigned long long offset = static_cast<unsigned long long>(slot) * sizeof(value);
+    if (ReadAt(AsHandle(lockFile_), offset, reinterpret_cast<char*>(&value), sizeof(value)) != sizeof(value)) {
+        return 0;
+    }
+    return value;
+}
+
+// 步骤 4.4：共享滚动代数 (即活动文件的段号)
+long long LogTailReader::CurrentGeneration() {
+    return ReadLockSlot(0);
+}
+
+// 步骤 4.4：已封闭代数：小于它的段已滚动且没有进行中的追加，文件大小不会再变化
+long long LogTailReader::SealedGeneration() {
+    return ReadLockSlot(1);
+}
+
+// 步骤 4.4：重新解析滚动清单，只处理完整的行
+// 滚动进程会重写清单以移除已被保留策略清理的段，因此每次整份读取 (清单只保留现存的段，很小)；
+// 格式错误的行跳过，不影响其余段
+void LogTailReader::LoadManifest() {
+    HANDLE h = OpenForRead(fullPath_ + ".manifest");
+    if (h == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    std::string data;
+    char chunk[4096];
+    DWORD got = 0;
+    while ((got = ReadAt(h, data.size(), chunk, sizeof(chunk))) > 0) {
+        data.append(chunk, got);
+    }
+    ::CloseHandle(h);
+
+    manifest_.clear();
+    size_t start = 0;
+    size_t newline = 0;
+    while ((newline = data.find('\n', start)) != std::string::npos) {
+        const char* first = data.data() + start;
+        const char* last = data.data() + newline;
+        const char* tab = std::find(first, last, '\t');
+        long long segmentId = 0;
+        auto parsed = std::from_chars(first, tab, segmentId);
+        if (tab != last && parsed.ec == std::errc() && parsed.ptr == tab && tab + 1 != last) {
+            manifest_[segmentId] = std::string(tab + 1, last);
+        }
+        else {
+            std::cerr << "Warning: Skipping malformed roll manifest line: "
+                << std::string(first, last) << std::endl;
+        }
+        start = newline + 1;
+    }
+}
+
+long long LogTailReader::FileSize() const {
+    LARGE_INTEGER size{};
+    if (segment_ == INVALID_HANDLE_VALUE || !::GetFileSizeEx(AsHandle(segment_), &size)) {
+        return -1;
+    }
+    return size.QuadPart;
+}
+
+// 步骤 4.4：按游标中的段号打开对应文件
+// - 段号等于当前代数：打开活动文件，打开前后代数一致才说明打开的是该段
+// - 段号小于当前代数：从清单中查找备份文件；已被保留策略清理时跳到下一个存在的段
+bool LogTailReader::OpenSegment() {
+    for (;;) {
+        long long generation = CurrentGeneration();
+        if (cursor_.segmentId < 0 || cursor_.segmentId > generation) {
+            if (cursor_.segmentId > generation) {
+                std::cerr << "Warning: Log cursor segment " << cursor_.segmentId
+                    << " is newer than the log files, restarting at segment " << generation << std::endl;
+            }
+            cursor_.segmentId = generation;
+            cursor_.offset = 0;
+        }
+
+        if (cursor_.segmentId == generation) {
+            HANDLE h = OpenForRead(fullPath_);
+            if (h == INVALID_HANDLE_VALUE) {
+                return false;
+            }
+            if (CurrentGeneration() != generation) {
+                // 打开期间发生了滚动，无法确定打开的是哪一段，重试
+                ::CloseHandle(h);
+                continue;
+            }
+            segment_ = h;
+            return true;
+        }
+
+        auto it = manifest_.find(cursor_.segmentId);
+        if (it == manifest_.end()) {
+            LoadManifest();
+            it = manifest_.find(cursor_.segmentId);
+        }
+        if (it != manifest_.end()) {
+            HANDLE h = OpenForRead((fs::path(logPath_) / it->second).string());
+            if (h != INVALID_HANDLE_VALUE) {
+                segment_ = h;
+                return true;
+            }
+        }
+
+        std::cerr << "Warning: Log segment " << cursor_.segmentId
+            << " is no longer available, skipping to the next segment" << std::endl;
+        auto next = manifest_.upper_bound(cursor_.segmentId);
+        cursor_.segmentId = (next != manifest_.end() && next->first < generation) ? next->first : generation;
+        cursor_.offset = 0;
+    }
+}
+
+// 步骤 4.4：当前段已读完且已被滚动，切换到下一段开头
+bool LogTailReader::AdvanceSegment() {
+    CloseSegment();
+    long long generation = CurrentGeneration();
+    LoadManifest();
+    auto next = manifest_.upper_bound(cursor_.segmentId);
+    cursor_.segmentId = (next != manifest_.end() && next->first < generation) ? next->first : generation;
+    cursor_.offset = 0;
+    pending_ = 0;
+    pendingStart_ = 0;
+    return OpenSegment();
+}
+
+// 步骤 4.4：读取一批完整的行
+size_t LogTailReader::ReadBatch(std::vector<LogLineView>& lines, size_t maxBytes) {
+    lines.clear();
+    if (maxBytes == 0) {
+        maxBytes = 1;
+    }
+    if (segment_ == INVALID_HANDLE_VALUE && !OpenSegment()) {
+        return 0;
+    }
+
+    // 上一批返回的行视图已失效，把不完整的行移动到缓冲区开头
+    if (pendingStart_ > 0 && pending_ > 0) {
+        std::memmove(buffer_.data(), buffer_.data() + pendingStart_, pending_);
+    }
+    pendingStart_ = 0;
+
+    for (;;) {
+        const unsigned long long readPos = cursor_.offset + pending_;
+        long long size = FileSize();
+        if (size > static_cast<long long>(readPos)) {
+            size_t want = static_cast<size_t>(size - static_cast<long long>(readPos));
+            if (want > maxBytes) {
+                want = maxBytes;
+            }
+            if (buffer_.size() < pending_ + want) {
+                buffer_.resize(pending_ + want);
+            }
+            DWORD got = ReadAt(AsHandle(segment_), readPos, buffer_.data() + pending_, static_cast<DWORD>(want));
+            const size_t total = pending_ + got;
+
+            size_t start = 0;
+            for (size_t i = pending_; i < total; ++i) {
+                if (buffer_[i] != '\n') {
+                    continue;
+                }
+                size_t length = i - start;
+                if (length > 0 && buffer_[start + length - 1] == '\r') {
+                    --length;
+                }
+                lines.push_back({ buffer_.data() + start, length });
+                start = i + 1;
+            }
+            cursor_.offset += start;
+            pending_ = total - start;
+            pendingStart_ = start;
+
+            if (!lines.empty()) {
+                return lines.size();
+            }
+            if (got > 0) {
+                // 单行超过 maxBytes，继续读取直到遇到换行
+                continue;
+            }
+        }
+
+        if (cursor_.segmentId >= SealedGeneration()) {
+            // 活动段 (或已滚动但仍有进程正在向其追加的段) 暂无完整的新行
+            return 0;
+        }
+
+        // 当前段已封闭：封闭前的最后一批可能刚刚写入，再确认一次文件大小 (之后不会再变化)
+        if (FileSize() > static_cast<long long>(cursor_.offset + pending_)) {
+            continue;
+        }
+        if (pending_ > 0) {
+            // 写入进程每次追加的都是完整的行，只有写入中断 (如进程崩溃) 才会在封闭段末尾留下不完整的行；
+            // 不完整的行不能作为一行返回，丢弃后进入下一段
+            std::cerr << "Warning: Discarding " << pending_ << " bytes of incomplete line at the end of log segment "
+                << cursor_.segmentId << std::endl;
+        }
+        if (!AdvanceSegment()) {
+            return 0;
+        }
+    }
+}
+
+// 步骤 4.4：轮询等待新数据或滚动
+bool LogTailReader::WaitForData(unsigned long timeoutMs) {
+    unsigned long waited = 0;
+    for (;;) {
+        if (segment_ != INVALID_HANDLE_VALUE || OpenSegment()) {
+            if (FileSize() > static_cast<long long>(cursor_.offset + pending_) ||
+                cursor_.segmentId < SealedGeneration()) {
+                return true;
+            }
+        }
+        if (waited >= timeoutMs) {
+            return false;
+        }
+        ::Sleep(POLL_INTERVAL_MS);
+        waited += POLL_INTERVAL_MS;
+    }
+}
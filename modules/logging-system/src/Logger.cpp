@@ -1,69 +1,156 @@
 // Logger.cpp
 #include "pch.h"
 #include "Logger.h"
-#include "StackTrace.h" //  3.1: ջ׷ͷļ
+#include "StackTrace.h" // 步骤 3.1: 引入堆栈追踪头文件
+#include "LoggerStats.h" // 步骤 4.2: 自监控计数
+#include "LogContext.h" // 步骤 4.6: 诊断上下文
+#include "ProfiledMutex.h" // 步骤 4.9: 锁竞争分析
+#include <cstring>
 #include <iostream>
 #include <Windows.h> 
 
-// ̶ļΪ "application.log" 
+// 固定文件名为 "application.log" 
 const std::string DEFAULT_LOG_FILENAME = "application.log";
 
-//  1.1, 10, 3.4ʵ Logger 캯
+// 步骤 1.1, 10, 3.4：实现 Logger 构造函数
 Logger::Logger()
-//  3.4: ʹ LogConfig е·
-    : fileWriter_(std::make_unique<FileWriter>(DEFAULT_LOG_FILENAME, LogConfig::GetInstance().GetLogFilePath()))
+// 步骤 3.4: 使用 LogConfig 中的路径配置
+// 步骤 4.5: 指向同一文件的 Logger 共享一个 FileWriter
+    : fileWriter_(FileWriter::Acquire(DEFAULT_LOG_FILENAME, LogConfig::GetInstance().GetLogFilePath()))
 {
-    // ʱʼ FileWriter
+    // 构造时初始化 FileWriter
 }
 
-//  (޲ unique_ptr ͷ fileWriter_)
+// 析构函数 (无操作，最后一个引用释放时 FileWriter 析构)
 Logger::~Logger() {
 }
 
 
-// ȡǰ߳ ID (Windows)
+// 步骤 4.10：实现 LogBatch (构建器)
+void Logger::LogBatch(LogEntryBatch& batch) {
+    for (int i = 0; i < 4; ++i) {
+        LoggerStats::RecordAccepted(static_cast<LogLevel>(i), batch.accepted_[i]);
+        LoggerStats::RecordFiltered(static_cast<LogLevel>(i), batch.filtered_[i]);
+    }
+    if (fileWriter_) {
+        fileWriter_->WriteBatch(std::move(batch.entries_));
+    }
+    batch.Clear();
+}
+
+// 步骤 4.10：实现 LogBatch (条目数组)
+void Logger::LogBatch(const LogEntry* entries, size_t count) {
+    if (!entries || count == 0) {
+        return;
+    }
+    const LogLevel minLevel = LogConfig::GetInstance().GetMinLogLevel();
+    unsigned long long accepted[4] = { 0, 0, 0, 0 };
+    unsigned long long filtered[4] = { 0, 0, 0, 0 };
+    std::deque<LogEntry> batch;
+    for (size_t i = 0; i < count; ++i) {
+        const LogEntry& entry = entries[i];
+        if (entry.level >= LogLevel::NONE) {
+            continue;
+        }
+        if (entry.level < minLevel) {
+            ++filtered[static_cast<int>(entry.level)];
+            continue;
+        }
+        ++accepted[static_cast<int>(entry.level)];
+        batch.push_back(entry);
+    }
+    for (int i = 0; i < 4; ++i) {
+        LoggerStats::RecordAccepted(static_cast<LogLevel>(i), accepted[i]);
+        LoggerStats::RecordFiltered(static_cast<LogLevel>(i), filtered[i]);
+    }
+    if (fileWriter_) {
+        fileWriter_->WriteBatch(std::move(batch));
+    }
+}
+
+// 步骤 4.10：实现 ILogger::LogBatch (INFO 级别)
+void Logger::LogBatch(const char* const* messages, int count, const char* sourceClass) {
+    if (!messages || count <= 0) {
+        return;
+    }
+    LogEntryBatch batch;
+    for (int i = 0; i < count; ++i) {
+        batch.Info(messages[i], sourceClass);
+    }
+    LogBatch(batch);
+}
+
+// 辅助方法：获取当前线程 ID (Windows)
 unsigned long Logger::GetThreadId() const {
     return static_cast<unsigned long>(::GetCurrentThreadId());
 }
 
 
-//  1.2, 1.5ʵ ILogger ӿڷĬ INFO ģ
+// 步骤 1.2, 1.5：实现 ILogger 接口方法（默认 INFO 级别，无上下文）
 void Logger::Log(const char* message) {
     Log(LogLevel::INFO, message, "ILogger::Log");
 }
 
-//  2.1ʵִĵ־¼
+// 步骤 2.1：实现带上下文的日志记录
 void Logger::Log(const char* message, const char* sourceClass) {
     Log(LogLevel::INFO, message, sourceClass);
 }
 
-//  3.1ʵ Fatal ־¼
+// 步骤 3.1：实现 Fatal 级别日志记录
 void Logger::Fatal(const char* message, const char* sourceClass) {
     Log(LogLevel::FATAL, message, sourceClass);
 }
 
 
-// ־¼ģ
+// 核心日志记录方法（包含级别和上下文）
 void Logger::Log(LogLevel level, const char* message, const char* sourceClass) {
-    //  2.2־й
-    // NONE ֵߣκʵ־𶼵 NONEӶﵽ־Ŀ
+    // 步骤 2.2：检查最低日志级别进行过滤
+    // NONE 级别的数值最高，任何实际日志级别都低于 NONE，从而达到禁用所有日志的目的
+    if (!ShouldLog(level)) {
+        return; // 级别低于设置的最低级别，忽略
+    }
+    LogMessage(level, std::string(message), sourceClass);
+}
+
+// 步骤 4.7：级别过滤，被过滤时记录计数
+bool Logger::ShouldLog(LogLevel level) {
     if (level < LogConfig::GetInstance().GetMinLogLevel()) {
-        return; // õͼ𣬺
+        LoggerStats::RecordFiltered(level); // 步骤 4.2
+        return false;
     }
+    return true;
+}
+
+// 步骤 4.7：构造条目并提交 (消息字符串直接移动进入条目)
+void Logger::LogMessage(LogLevel level, std::string&& message, const char* sourceClass) {
+    LoggerStats::RecordAccepted(level); // 步骤 4.2
 
     LogEntry entry;
     entry.timestamp = std::chrono::system_clock::now();
     entry.level = level;
-    entry.message = message;
-    entry.threadId = GetThreadId();        //  2.3¼߳ ID
-    entry.sourceClass = sourceClass ? sourceClass : "Unknown"; //  2.3¼
+    entry.message = std::move(message);
+    entry.threadId = GetThreadId();        // 步骤 2.3：记录线程 ID
+    entry.sourceClass = sourceClass ? sourceClass : "Unknown"; // 步骤 2.3：记录类名
+    entry.context = LogContext::Current();  // 步骤 4.6：只引用不可变快照，不复制字符串
 
     if (fileWriter_) {
-        fileWriter_->Write(entry);
+        fileWriter_->Write(std::move(entry)); // 步骤 4.1：移动进入异步队列，避免复制
     }
 }
 
-//  2.1ʵ Info/Warn/Error 
+// 步骤 4.1：等待异步队列写完
+void Logger::Flush() {
+    if (fileWriter_) {
+        fileWriter_->Flush();
+    }
+}
+
+// 步骤 4.1：读取队列丢弃/阻塞/溢出计数
+LogQueueCounters Logger::GetQueueCounters() const {
+    return fileWriter_ ? fileWriter_->GetQueueCounters() : LogQueueCounters{};
+}
+
+// 步骤 2.1：实现 Info/Warn/Error 辅助方法
 void Logger::Info(const char* message, const char* sourceClass) {
     Log(LogLevel::INFO, message, sourceClass);
 }
@@ -76,16 +163,16 @@ void Logger::Error(const char* message, const char* sourceClass) {
     Log(LogLevel::ERROR_LEVEL, message, sourceClass);
 }
 
-//  3.1ע쳣
+// 步骤 3.1：注册异常处理器
 void Logger::RegisterExceptionHandler() {
     StackTrace::RegisterUnhandledExceptionHandler(this);
     std::cout << "Unhandled Exception Handler registered." << std::endl;
 }
 
 
-//  1.1, 10ʵ CreateLogger 
+// 步骤 1.1, 10：实现 CreateLogger 导出函数
 extern "C" CORELOGGER_API ILogger* CreateLogger() {
-    //  3.1: ڴ Logger ʵʱע쳣
+    // 步骤 3.1: 在创建 Logger 实例时注册异常处理器
     Logger* logger = new Logger();
     logger->RegisterExceptionHandler();
     return logger;
@@ -94,7 +181,7 @@ extern "C" CORELOGGER_API ILogger* CreateLogger() {
 extern "C" CORELOGGER_API int RunLoggerConsole() {
     std::cout << "=== Logger Console Mode ===" << std::endl;
 
-    // ʹCreateLoggerʵ
+    // 使用CreateLogger创建实例
     Logger* logger = dynamic_cast<Logger*>(CreateLogger());
     if (!logger) {
         std::cerr << "Failed to create logger!" << std::endl;
@@ -103,18 +190,18 @@ extern "C" CORELOGGER_API int RunLoggerConsole() {
 
     std::string message;
     while (true) {
-        std::cout << "־ (quit˳): ";  // ̨
-        std::getline(std::cin, message);    // ӿ̨
+        std::cout << "输入日志内容 (输入quit退出): ";  // 输出到控制台
+        std::getline(std::cin, message);    // 从控制台监听输入
 
         if (message == "quit" || message == "exit") break;
 
-        // ʹеLoggerϵͳ¼
+        // 使用现有的Logger系统记录
         logger->Info(message.c_str(), "ConsoleInput");
-        std::cout << "Ѽ¼־ļ" << std::endl;
+        std::cout << "已记录到日志文件。" << std::endl;
     }
 
     delete logger;
-    std::cout << "Logger Console رա" << std::endl;
+    std::cout << "Logger Console 关闭。" << std::endl;
     return 0;
 }
 
@@ -122,35 +209,72 @@ extern "C" CORELOGGER_API const char* GetLoggerInfo() {
     return "Core Logger DLL v1.0 - Professional logging system with console interface";
 }
 
-// =========== ĺ ===========
+// 步骤 4.2：导出自监控计数 (结构体形式)
+extern "C" CORELOGGER_API void GetLoggerStatsSnapshot(LoggerStatsSnapshot* snapshot) {
+    if (snapshot) {
+        *snapshot = LoggerStats::Snapshot();
+    }
+}
+
+// 步骤 4.2：导出自监控计数 (JSON 形式)
+// 返回包含结尾 '\0' 所需的缓冲区大小；buffer 为空或过小时只返回所需大小，不写入
+extern "C" CORELOGGER_API int GetLoggerStats(char* buffer, int bufferSize) {
+    std::string json = LoggerStats::ToJson(LoggerStats::Snapshot());
+    int required = static_cast<int>(json.size()) + 1;
+    if (buffer && bufferSize >= required) {
+        std::memcpy(buffer, json.c_str(), required);
+    }
+    return required;
+}
+
+// 步骤 4.9：导出锁竞争报告 (文本)，返回值约定与 GetLoggerStats 相同
+extern "C" CORELOGGER_API int GetLockProfileReport(char* buffer, int bufferSize) {
+    std::string report = LockProfiler::Report();
+    int required = static_cast<int>(report.size()) + 1;
+    if (buffer && bufferSize >= required) {
+        std::memcpy(buffer, report.c_str(), required);
+    }
+    return required;
+}
+
+// 步骤 4.6：导出诊断上下文的压入/弹出，供通过 GetProcAddress 使用本 DLL 的模块调用
+extern "C" CORELOGGER_API void PushLogContext(const char* key, const char* value) {
+    LogContext::Push(key ? key : "", value ? value : "");
+}
+
+extern "C" CORELOGGER_API void PopLogContext() {
+    LogContext::Pop();
+}
+
+// =========== 以下是新增的函数 ===========
 
 extern "C" CORELOGGER_API int run() {
-    std::cout << "=== CoreLogger ־ϵͳ ===" << std::endl;
+    std::cout << "=== CoreLogger 日志系统 ===" << std::endl;
 
     while (true) {
-        std::cout << "\nѡģʽ" << std::endl;
-        std::cout << "1. ̨־ģʽ־ļ" << std::endl;
-        std::cout << "2. ٲģʽ¼־" << std::endl;
-        std::cout << "3. 鿴ϵͳϢ" << std::endl;
-        std::cout << "4. Ϣ" << std::endl;
-        std::cout << "5. ּԣϹܣ" << std::endl;
-        std::cout << "0. ˳" << std::endl;
-        std::cout << "ѡ (0-5): ";
+        std::cout << "\n请选择模式：" << std::endl;
+        std::cout << "1. 控制台日志模式（输入日志到文件）" << std::endl;
+        std::cout << "2. 快速测试模式（记录几条测试日志）" << std::endl;
+        std::cout << "3. 查看系统信息" << std::endl;
+        std::cout << "4. 帮助信息" << std::endl;
+        std::cout << "5. 数字计算测试（整合功能）" << std::endl;
+        std::cout << "0. 退出程序" << std::endl;
+        std::cout << "输入选择 (0-5): ";
 
         std::string input;
         std::getline(std::cin, input);
 
-        // ֱ
+        // 处理直接命令
         if (input == "help" || input == "h") {
-            std::cout << "\nϢ" << std::endl;
-            std::cout << "-  0-5 ѡ˵" << std::endl;
-            std::cout << "-  help 鿴˰" << std::endl;
-            std::cout << "-  quit ˳" << std::endl;
+            std::cout << "\n帮助信息：" << std::endl;
+            std::cout << "- 输入数字 0-5 选择菜单项" << std::endl;
+            std::cout << "- 输入 help 查看此帮助" << std::endl;
+            std::cout << "- 输入 quit 退出程序" << std::endl;
             continue;
         }
 
         if (input == "quit" || input == "exit" || input == "0") {
-            std::cout << "ټ" << std::endl;
+            std::cout << "再见！" << std::endl;
             break;
         }
 
@@ -159,72 +283,73 @@ extern "C" CORELOGGER_API int run() {
             choice = std::stoi(input);
         }
         catch (...) {
-            std::cout << " 0-5" << std::endl;
+            std::cout << "错误：请输入数字 0-5" << std::endl;
             continue;
         }
 
         switch (choice) {
         case 1:
-            std::cout << "̨־ģʽ..." << std::endl;
+            std::cout << "进入控制台日志模式..." << std::endl;
             return RunLoggerConsole();
 
         case 2: {
             Logger* logger = dynamic_cast<Logger*>(CreateLogger());
             if (!logger) {
-                std::cerr << " Logger ʧ!" << std::endl;
+                std::cerr << "创建 Logger 失败!" << std::endl;
                 break;
             }
-            logger->Info("һϢ", "Test");
-            logger->Warn("һ", "Test");
-            logger->Error("һ", "Test");
-            std::cout << "Ѽ¼3־ application.log" << std::endl;
+            logger->Info("这是一条测试信息", "Test");
+            logger->Warn("这是一个警告", "Test");
+            logger->Error("这是一个错误", "Test");
+            std::cout << "已记录3条测试日志到 application.log" << std::endl;
             delete logger;
             break;
         }
 
         case 3:
             std::cout << description() << std::endl;
-            std::cout << "־·: " << LogConfig::GetInstance().GetLogFilePath() << std::endl;
-            std::cout << ": " << LogConfig::GetInstance().GetRetentionDays() << "" << std::endl;
+            std::cout << "日志路径: " << LogConfig::GetInstance().GetLogFilePath() << std::endl;
+            std::cout << "保留天数: " << LogConfig::GetInstance().GetRetentionDays() << "天" << std::endl;
+            std::cout << "运行计数: " << LoggerStats::ToJson(LoggerStats::Snapshot()) << std::endl;
             break;
 
         case 4:
-            std::cout << "\n====== Ϣ ======" << std::endl;
-            std::cout << "һרҵ־ϵͳDLL¹ܣ" << std::endl;
-            std::cout << "- ༶־¼" << std::endl;
-            std::cout << "- ̰߳ȫ" << std::endl;
-            std::cout << "- ļ" << std::endl;
-            std::cout << "- 쳣" << std::endl;
-            std::cout << "- ܼʱ" << std::endl;
+            std::cout << "\n====== 帮助信息 ======" << std::endl;
+            std::cout << "这是一个专业的日志系统DLL，包含以下功能：" << std::endl;
+            std::cout << "- 多级别日志记录" << std::endl;
+            std::cout << "- 线程安全" << std::endl;
+            std::cout << "- 文件滚动" << std::endl;
+            std::cout << "- 异常捕获" << std::endl;
+            std::cout << "- 性能计时" << std::endl;
             std::cout << "=====================" << std::endl;
             break;
 
         case 5: {
-            std::cout << "\n====== ּ ======" << std::endl;
-            std::cout << "ϲԹܣ֣ (+1)" << std::endl;
-            std::cout << "֣ 'back' أ: ";
+            std::cout << "\n====== 数字计算测试 ======" << std::endl;
+            std::cout << "这是整合测试功能：输入数字，输出 (数字+1)" << std::endl;
+            std::cout << "输入数字（输入 'back' 返回）: ";
 
             std::string numInput;
             std::getline(std::cin, numInput);
 
             if (numInput == "back" || numInput == "b") {
-                std::cout << "˵" << std::endl;
+                std::cout << "返回主菜单" << std::endl;
                 break;
             }
 
             try {
                 int num = std::stoi(numInput);
-                std::cout << ": " << num << " + 1 = " << (num + 1) << std::endl;
-                return 42;  // ͬѧҪķֵ
+                std::cout << "计算结果: " << num << " + 1 = " << (num + 1) << std::endl;
+                return 42;  // 整合同学要求的返回值
             }
             catch (...) {
-                std::cout << "Ч" << std::endl;
+                std::cout << "错误：请输入有效的数字" << std::endl;
             }
             break;
         }
 
         default:
-            std::cout << "Чѡ 0-5" << std::endl;
+            std::cout << "无效选择，请输入 0-5" << std::endl;
             break;
         }
     }
@@ -235,14 +360,14 @@ extern "C" CORELOGGER_API int run() {
 extern "C" CORELOGGER_API const char* description() {
     static const char* desc =
         "Core Logger DLL v1.0\n"
-        "- ༶־INFO/WARN/ERROR/FATAL\n"
-        "- ̰߳ȫ־¼\n"
-        "- ܼʱߣStopwatch/ScopedTimer\n"
-        "- ־ļ10KBԶ鵵\n"
-        "- ־\n"
-        "- ̨ģʽ\n\n"
-        "- 쳣ƣֲԣ\n"
-        "- ־ԣܣ";
+        "- 多级别日志（INFO/WARN/ERROR/FATAL）\n"
+        "- 线程安全日志记录\n"
+        "- 性能计时工具（Stopwatch/ScopedTimer）\n"
+        "- 日志文件滚动（超过10KB自动归档）\n"
+        "- 基础日志配置\n"
+        "- 控制台交互模式\n\n"
+        "- 异常捕获机制（待充分测试）\n"
+        "- 日志清理策略（基础框架）";
 
     return desc;
 }
@@ -0,0 +1,207 @@
+﻿// LoggerStats.cpp
+#include "pch.h"
+#include "LoggerStats.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <sstream>
+
+namespace {
+    // 每个线程独占的计数分片，按缓存行对齐避免伪共享
+    // 只有所属线程写入，因此使用 relaxed 读改写，无需原子加锁指令
+    struct alignas(64) StatsShard {
+        std::atomic<unsigned long long> accepted[4];
+        std::atomic<unsigned long long> filtered[4];
+        std::atomic<unsigned long long> bytesWritten;
+        std::atomic<unsigned long long> flushes;
+        std::atomic<unsigned long long> rollCount;
+        std::atomic<unsigned long long> rollMicrosTotal;
+        std::atomic<unsigned long long> rollMicrosMax;
+        std::atomic<unsigned long long> queueHighWater;
+        std::atomic<unsigned long long> writeLatency[LOGGER_LATENCY_BUCKETS];
+
+        StatsShard() {
+            for (int i = 0; i < 4; ++i) {
+                accepted[i].store(0);
+                filtered[i].store(0);
+            }
+            bytesWritten.store(0);
+            flushes.store(0);
+            rollCount.store(0);
+            rollMicrosTotal.store(0);
+            rollMicrosMax.store(0);
+            queueHighWater.store(0);
+            for (auto& bucket : writeLatency) {
+                bucket.store(0);
+            }
+        }
+    };
+
+    void Add(std::atomic<unsigned long long>& counter, unsigned long long value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    void Max(std::atomic<unsigned long long>& counter, unsigned long long value) {
+        if (value > counter.load(std::memory_order_relaxed)) {
+            counter.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    void Accumulate(LoggerStatsSnapshot& out, const StatsShard& shard) {
+        for (int i = 0; i < 4; ++i) {
+            out.accepted[i] += shard.accepted[i].load(std::memory_order_relaxed);
+            out.filtered[i] += shard.filtered[i].load(std::memory_order_relaxed);
+        }
+        out.bytesWritten += shard.bytesWritten.load(std::memory_order_relaxed);
+        out.flushes += shard.flushes.load(std::memory_order_relaxed);
+        out.rollCount += shard.rollCount.load(std::memory_order_relaxed);
+        out.rollMicrosTotal += shard.rollMicrosTotal.load(std::memory_order_relaxed);
+        out.rollMicrosMax = (std::max)(out.rollMicrosMax, shard.rollMicrosMax.load(std::memory_order_relaxed));
+        out.queueHighWater = (std::max)(out.queueHighWater, shard.queueHighWater.load(std::memory_order_relaxed));
+        for (int i = 0; i < LOGGER_LATENCY_BUCKETS; ++i) {
+            out.writeLatency[i] += shard.writeLatency[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    // 分片注册表：只在线程首次记录和线程退出时加锁
+    class ShardRegistry {
+    public:
+        StatsShard* Register() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            shards_.push_back(new StatsShard());
+            return shards_.back();
+        }
+
+        // 线程退出时把分片数值并入 retired_，保证计数不丢失
+        void Retire(StatsShard* shard) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Accumulate(retired_, *shard);
+            shards_.erase(std::remove(shards_.begin(), shards_.end(), shard), shards_.end());
+            delete shard;
+        }
+
+        LoggerStatsSnapshot Snapshot() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            LoggerStatsSnapshot out = retired_;
+            for (const StatsShard* shard : shards_) {
+                Accumulate(out, *shard);
+            }
+            return out;
+        }
+
+    private:
+        std::mutex mutex_;
+        std::vector<StatsShard*> shards_;
+        LoggerStatsSnapshot retired_{};
+    };
+
+    // 故意不释放：线程可能在静态对象析构之后才退出
+    ShardRegistry& Registry() {
+        static ShardRegistry* registry = new ShardRegistry();
+        return *registry;
+    }
+
+    struct ShardHolder {
+        StatsShard* shard;
+        ShardHolder() : shard(Registry().Register()) {}
+        ~ShardHolder() { Registry().Retire(shard); }
+    };
+
+    StatsShard& LocalShard() {
+        thread_local ShardHolder holder;
+        return *holder.shard;
+    }
+
+    bool IsRealLevel(LogLevel level) {
+        return level >= LogLevel::INFO && level <= LogLevel::FATAL;
+    }
+
+    int LatencyBucket(long long micros) {
+        int bucket = 0;
+        while (bucket < LOGGER_LATENCY_BUCKETS - 1 && micros >= (1LL << bucket)) {
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    void AppendLevels(std::ostringstream& oss, const unsigned long long* values) {
+        oss << "{";
+        for (int i = 0; i < 4; ++i) {
+            oss << (i > 0 ? "," : "") << "\"" << LogEntry::LevelToString(static_cast<LogLevel>(i)) << "\":" << values[i];
+        }
+        oss << "}";
+    }
+}
+
+namespace LoggerStats {
+
+    // 步骤 4.2：各记录函数只写当前线程的分片
+    void RecordAccepted(LogLevel level, unsigned long long count) {
+        if (IsRealLevel(level)) {
+            Add(LocalShard().accepted[static_cast<int>(level)], count);
+        }
+    }
+
+    void RecordFiltered(LogLevel level, unsigned long long count) {
+        if (IsRealLevel(level)) {
+            Add(LocalShard().filtered[static_cast<int>(level)], count);
+        }
+    }
+
+    void RecordBytesWritten(size_t bytes) {
+        Add(LocalShard().bytesWritten, bytes);
+    }
+
+    void RecordFlush() {
+        Add(LocalShard().flushes, 1);
+    }
+
+    void RecordRoll(long long micros) {
+        StatsShard& shard = LocalShard();
+        Add(shard.rollCount, 1);
+        Add(shard.rollMicrosTotal, static_cast<unsigned long long>(micros));
+        Max(shard.rollMicrosMax, static_cast<unsigned long long>(micros));
+    }
+
+    void RecordQueueDepth(size_t depth) {
+        Max(LocalShard().queueHighWater, depth);
+    }
+
+    void RecordWriteLatency(long long micros) {
+        Add(LocalShard().writeLatency[LatencyBucket(micros)], 1);
+    }
+
+    // 步骤 4.2：汇总快照
+    LoggerStatsSnapshot Snapshot() {
+        return Registry().Snapshot();
+    }
+
+    // 步骤 4.2：快照转 JSON，直方图桶以上界 (微秒) 标注，最后一个为 "inf"
+    std::string ToJson(const LoggerStatsSnapshot& snapshot) {
+        std::ostringstream oss;
+        oss << "{\"accepted\":";
+        AppendLevels(oss, snapshot.accepted);
+        oss << ",\"filtered\":";
+        AppendLevels(oss, snapshot.filtered);
+        oss << ",\"bytesWritten\":" << snapshot.bytesWritten
+            << ",\"flushes\":" << snapshot.flushes
+            << ",\"rollCount\":" << snapshot.rollCount
+            << ",\"rollMicrosTotal\":" << snapshot.rollMicrosTotal
+            << ",\"rollMicrosMax\":" << snapshot.rollMicrosMax
+            << ",\"queueHighWater\":" << snapshot.queueHighWater
+            << ",\"writeLatencyMicros\":[";
+        for (int i = 0; i < LOGGER_LATENCY_BUCKETS; ++i) {
+            oss << (i > 0 ? "," : "") << "{\"lt\":";
+            if (i < LOGGER_LATENCY_BUCKETS - 1) {
+                oss << (1LL << i);
+            }
+            else {
+                oss << "\"inf\"";
+            }
+            oss << ",\"count\":" << snapshot.writeLatency[i] << "}";
+        }
+        oss << "]}";
+        return oss.str();
+    }
+}
@@ -0,0 +1,332 @@
+﻿// SharedLogFile.cpp
+#include "pch.h"
+#include "SharedLogFile.h"
+#include <Windows.h>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace {
+    // 锁文件映射大小：依次为滚动代数、已封闭代数 (小于它的段不会再有追加)、
+    // 按代数奇偶分开的两个正在追加计数，其余保留
+    const DWORD LOCK_MAPPING_SIZE = 64;
+    const int GENERATION_SLOT = 0;
+    const int SEALED_SLOT = 1;
+    const int APPENDING_SLOT = 2;
+
+    // 滚动后等待旧段追加结束的最长时间；超时说明登记的进程已经崩溃，计数作废
+    const DWORD SEAL_TIMEOUT_MS = 1000;
+
+    HANDLE AsHandle(void* h) {
+        return static_cast<HANDLE>(h);
+    }
+
+    // 所有句柄都允许共享读/写/删除，使其他进程可以在文件打开时重命名 (滚动)
+    const DWORD SHARE_ALL = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+}
+
+// 步骤 4.3：实现 SharedLogFile 构造函数
+SharedLogFile::SharedLogFile(const std::string& logPath, const std::string& filename, bool rollable)
+    : logPath_(logPath), filename_(filename),
+    fullPath_((fs::path(logPath) / filename).string()),
+    file_(INVALID_HANDLE_VALUE), lockFile_(INVALID_HANDLE_VALUE), lockMapping_(nullptr),
+    sharedState_(nullptr), localGeneration_(0) {
+    if (rollable) {
+        OpenLockFile();
+    }
+    localGeneration_ = CurrentGeneration();
+    Open();
+}
+
+SharedLogFile::~SharedLogFile() {
+    Close();
+    if (sharedState_) {
+        ::UnmapViewOfFile(const_cast<long long*>(sharedState_));
+    }
+    if (lockMapping_) {
+        ::CloseHandle(AsHandle(lockMapping_));
+    }
+    if (lockFile_ != INVALID_HANDLE_VALUE) {
+        ::CloseHandle(AsHandle(lockFile_));
+    }
+}
+
+bool SharedLogFile::IsOpen() const {
+    return file_ != INVALID_HANDLE_VALUE;
+}
+
+// 步骤 4.3：FILE_APPEND_DATA 打开，写入位置由系统原子地定位到文件末尾
+bool SharedLogFile::Open() {
+    HANDLE h = ::CreateFileA(fullPath_.c_str(),
+        FILE_APPEND_DATA | FILE_READ_ATTRIBUTES | SYNCHRONIZE,
+        SHARE_ALL, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) {
+        std::cerr << "Error: Could not open log file: " << fullPath_
+            << ", WinError: " << ::GetLastError() << std::endl;
+        return false;
+    }
+    file_ = h;
+    return true;
+}
+
+void SharedLogFile::Close() {
+    if (file_ != INVALID_HANDLE_VALUE) {
+        ::CloseHandle(AsHandle(file_));
+        file_ = INVALID_HANDLE_VALUE;
+    }
+}
+
+// 步骤 4.3：打开并映射锁文件；失败时退化为仅进程内滚动 (不影响写入)
+void SharedLogFile::OpenLockFile() {
+    std::string lockPath = fullPath_ + ".lock";
+    HANDLE h = ::CreateFileA(lockPath.c_str(), GENERIC_READ | GENERIC_WRITE,
+        SHARE_ALL, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) {
+        std::cerr << "Warning: Could not open roll lock file: " << lockPath
+            << ", WinError: " << ::GetLastError() << std::endl;
+        return;
+    }
+    lockFile_ = h;
+
+    // 同一文件的映射视图在各进程间是一致的，因此代数可直接用原子操作读写
+    HANDLE mapping = ::CreateFileMappingA(h, nullptr, PAGE_READWRITE, 0, LOCK_MAPPING_SIZE, nullptr);
+    if (mapping == nullptr) {
+        return;
+    }
+    lockMapping_ = mapping;
+    void* view = ::MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, LOCK_MAPPING_SIZE);
+    if (view) {
+        sharedState_ = static_cast<volatile long long*>(view);
+    }
+}
+
+long long SharedLogFile::CurrentGeneration() const {
+    if (!sharedState_) {
+        return localGeneration_;
+    }
+    return ::InterlockedCompareExchange64(const_cast<volatile LONGLONG*>(&sharedState_[GENERATION_SLOT]), 0, 0);
+}
+
+// 相邻两代使用不同的计数：滚动进程等待旧代数清零时，新代数的追加不受影响
+volatile long long* SharedLogFile::AppendingCount(long long generation) const {
+    return &sharedState_[APPENDING_SLOT + (generation & 1)];
+}
+
+// 步骤 4.3：等待旧段上已登记的追加全部结束，再标记旧段已封闭
+void SharedLogFile::SealSegment(long long generation) {
+    volatile LONGLONG* appending = const_cast<volatile LONGLONG*>(AppendingCount(generation));
+    DWORD waited = 0;
+    while (::InterlockedCompareExchange64(appending, 0, 0) > 0) {
+        if (waited >= SEAL_TIMEOUT_MS) {
+            std::cerr << "Warning: Timed out waiting for appends to log segment " << generation
+                << ", resetting the append count" << std::endl;
+            ::InterlockedExchange64(appending, 0);
+            break;
+        }
+        ::Sleep(1);
+        ++waited;
+    }
+    ::InterlockedExchange64(const_cast<volatile LONGLONG*>(&sharedState_[SEALED_SLOT]), generation + 1);
+}
+
+// 步骤 4.3：整批数据一次写入
+// 先在当前代数的计数上登记，再确认代数没有变化：滚动进程递增代数之后才等待该计数清零，
+// 因此登记成功的追加要么在旧段封闭之前完成，要么看到新代数而写入新文件
+bool SharedLogFile::Append(const char* data, size_t size) {
+    if (size == 0) {
+        return false;
+    }
+    volatile LONGLONG* appending = nullptr;
+    if (sharedState_) {
+        long long generation = CurrentGeneration();
+        for (;;) {
+            appending = const_cast<volatile LONGLONG*>(AppendingCount(generation));
+            ::InterlockedIncrement64(appending);
+            long long current = CurrentGeneration();
+            if (current == generation) {
+                break;
+            }
+            // 登记期间发生了滚动，按新代数重新登记
+            ::InterlockedDecrement64(appending);
+            generation = current;
+        }
+        if (generation != localGeneration_ || !IsOpen()) {
+            Close();
+            localGeneration_ = generation;
+            Open();
+        }
+    }
+
+    bool ok = false;
+    DWORD written = 0;
+    if (file_ != INVALID_HANDLE_VALUE) {
+        ok = ::WriteFile(AsHandle(file_), data, static_cast<DWORD>(size), &written, nullptr) && written == size;
+        if (!ok) {
+            std::cerr << "Error: Failed to append to log file: " << fullPath_
+                << ", WinError: " << ::GetLastError() << std::endl;
+        }
+    }
+
+    if (appending) {
+        ::InterlockedDecrement64(appending);
+    }
+    return ok;
+}
+
+long long SharedLogFile::Size() const {
+    LARGE_INTEGER size{};
+    if (file_ == INVALID_HANDLE_VALUE || !::GetFileSizeEx(AsHandle(file_), &size)) {
+        return -1;
+    }
+    return size.QuadPart;
+}
+
+// 步骤 4.3：只比较共享代数，代数变化说明其他进程已滚动
+void SharedLogFile::ReopenIfRolled() {
+    long long generation = CurrentGeneration();
+    if (generation == localGeneration_ && IsOpen()) {
+        return;
+    }
+    Close();
+    localGeneration_ = generation;
+    Open();
+}
+
+// 步骤 4.3：生成不重复的备份文件名 application.YYYYMMDD_HHMMSS[_N].log
+std::string SharedLogFile::MakeRolledPath() const {
+    auto now = std::chrono::system_clock::now();
+    const auto now_time = std::chrono::system_clock::to_time_t(now);
+    std::tm bt{};
+    char timeBuffer[50] = "";
+    if (localtime_s(&bt, &now_time) == 0) {
+        std::strftime(timeBuffer, sizeof(timeBuffer), ".%Y%m%d_%H%M%S", &bt);
+    }
+
+    size_t dot_pos = filename_.find_last_of('.');
+    std::string base = (dot_pos != std::string::npos) ? filename_.substr(0, dot_pos) : filename_;
+    std::string ext = (dot_pos != std::string::npos) ? filename_.substr(dot_pos) : ".log";
+
+    // 同一秒内多次滚动时追加序号，避免重命名失败
+    std::string candidate = (fs::path(logPath_) / (base + timeBuffer + ext)).string();
+    for (int suffix = 1; ::GetFileAttributesA(candidate.c_str()) != INVALID_FILE_ATTRIBUTES; ++suffix) {
+        candidate = (fs::path(logPath_) / (base + timeBuffer + "_" + std::to_string(suffix) + ext)).string();
+    }
+    return candidate;
+}
+
+// 步骤 4.4：在滚动清单 <filename>.manifest 中追加一行 "<段号>\t<备份文件名>"
+// 段号即该文件作为活动文件时的滚动代数，供 LogTailReader 跨滚动续读
+void SharedLogFile::AppendManifest(long long segmentId, const std::string& rolledName) {
+    std::string manifestPath = fullPath_ + ".manifest";
+    HANDLE h = ::CreateFileA(manifestPath.c_str(), FILE_APPEND_DATA | SYNCHRONIZE,
+        SHARE_ALL, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) {
+        std::cerr << "Warning: Could not open roll manifest: " << manifestPath
+            << ", WinError: " << ::GetLastError() << std::endl;
+        return;
+    }
+    std::string line = std::to_string(segmentId) + "\t" + rolledName + "\n";
+    DWORD written = 0;
+    ::WriteFile(h, line.data(), static_cast<DWORD>(line.size()), &written, nullptr);
+    ::CloseHandle(h);
+}
+
+// 步骤 4.4：移除清单中备份文件已被保留策略清理的段，避免清单无限增长
+// 在滚动的独占锁下执行；写入临时文件后整体替换，读取器只会看到完整的旧清单或新清单
+void SharedLogFile::PruneManifest() {
+    std::string manifestPath = fullPath_ + ".manifest";
+    std::ifstream in(manifestPath, std::ios::binary);
+    if (!in) {
+        return;
+    }
+    std::string kept;
+    bool pruned = false;
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t tab = line.find('\t');
+        std::error_code ec;
+        if (tab != std::string::npos && fs::exists(fs::path(logPath_) / line.substr(tab + 1), ec)) {
+            kept += line + "\n";
+        }
+        else {
+            pruned = true;
+        }
+    }
+    in.close();
+    if (!pruned) {
+        return;
+    }
+
+    std::string tempPath = manifestPath + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        out << kept;
+        if (!out) {
+            std::cerr << "Warning: Could not write roll manifest: " << tempPath << std::endl;
+            return;
+        }
+    }
+    if (!::MoveFileExA(tempPath.c_str(), manifestPath.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        std::cerr << "Warning: Could not replace roll manifest: " << manifestPath
+            << ", WinError: " << ::GetLastError() << std::endl;
+        ::DeleteFileA(tempPath.c_str());
+    }
+}
+
+// 步骤 4.3：持锁后再次确认，只有一个进程执行滚动，其余进程仅重新打开
+bool SharedLogFile::RollIfNeeded(unsigned long long maxBytes) {
+    long long size = Size();
+    if (size < 0 || static_cast<unsigned long long>(size) < maxBytes) {
+        return false;
+    }
+
+    OVERLAPPED overlapped{};
+    bool locked = false;
+    if (lockFile_ != INVALID_HANDLE_VALUE) {
+        locked = ::LockFileEx(AsHandle(lockFile_), LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &overlapped) != FALSE;
+    }
+
+    bool rolled = false;
+    if (CurrentGeneration() != localGeneration_) {
+        // 等锁期间其他进程已经滚动，直接打开新文件
+        ReopenIfRolled();
+    }
+    else {
+        size = Size();
+        if (size >= 0 && static_cast<unsigned long long>(size) >= maxBytes) {
+            // 先清理清单：备份文件名可能与已被清理的旧段重名
+            PruneManifest();
+            std::string rolledPath = MakeRolledPath();
+            // 所有句柄都带 FILE_SHARE_DELETE，文件打开时也可以重命名，无需关闭后等待
+            if (::MoveFileExA(fullPath_.c_str(), rolledPath.c_str(), 0)) {
+                rolled = true;
+                lastRolledPath_ = rolledPath;
+                // 先记录清单再递增代数：读取器看到新代数时，旧段一定已经在清单中
+                AppendManifest(localGeneration_, fs::path(rolledPath).filename().string());
+                if (sharedState_) {
+                    ::InterlockedIncrement64(const_cast<volatile LONGLONG*>(&sharedState_[GENERATION_SLOT]));
+                    SealSegment(localGeneration_);
+                }
+                else {
+                    ++localGeneration_;
+                }
+                std::cout << "Log file rolled: " << fullPath_ << " -> " << rolledPath << std::endl;
+            }
+            else {
+                std::cerr << "--- ROLL FAILED --- Error renaming file: " << fullPath_
+                    << ", WinError: " << ::GetLastError() << std::endl;
+            }
+            Close();
+            localGeneration_ = CurrentGeneration();
+            Open();
+        }
+    }
+
+    if (locked) {
+        ::UnlockFileEx(AsHandle(lockFile_), 0, 1, 0, &overlapped);
+    }
+    return rolled;
+}
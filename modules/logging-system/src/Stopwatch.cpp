@@ -3,7 +3,7 @@
 #include "Stopwatch.h"
 #include <sstream>
 
-//  3.2Stopwatch ʵ
+// 步骤 3.2：Stopwatch 实现
 Stopwatch::Stopwatch() : isRunning_(false) {}
 
 void Stopwatch::Start() {
@@ -18,7 +18,7 @@ void Stopwatch::Stop() {
 
 double Stopwatch::GetElapsedSeconds() const {
     if (isRunning_) {
-        // У㵽ڵʱ
+        // 如果仍在运行，计算到现在的时间
         return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime_).count();
     }
     else {
@@ -28,7 +28,7 @@ double Stopwatch::GetElapsedSeconds() const {
 
 long long Stopwatch::GetElapsedMilliseconds() const {
     if (isRunning_) {
-        // У㵽ڵʱ
+        // 如果仍在运行，计算到现在的时间
         return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - startTime_).count();
     }
     else {
@@ -37,7 +37,7 @@ long long Stopwatch::GetElapsedMilliseconds() const {
 }
 
 
-//  3.2ScopedTimer ʵ
+// 步骤 3.2：ScopedTimer 实现
 ScopedTimer::ScopedTimer(ILogger* logger, const char* sourceClass, const char* contextMessage)
     : logger_(logger),
     sourceClass_(sourceClass),
@@ -49,12 +49,12 @@ ScopedTimer::ScopedTimer(ILogger* logger, const char* sourceClass, const char* c
 ScopedTimer::~ScopedTimer() {
     stopwatch_.Stop();
 
-    // Զ¼־
+    // 自动记录日志
     if (logger_) {
         std::stringstream ss;
-        // ¼룬ȷ
+        // 记录毫秒，更精确
         ss << contextMessage_ << " executed in " << stopwatch_.GetElapsedMilliseconds() << "ms.";
-        // ʹ INFO ¼
+        // 使用 INFO 级别记录性能数据
         logger_->Log(ss.str().c_str(), sourceClass_.c_str());
     }
 }
\ No newline at end of file
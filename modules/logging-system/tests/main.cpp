@@ -12,6 +12,12 @@
 #include <stdexcept>
 #include <sstream>
 #include <filesystem>
+#include <fstream>
+#include <set>
+#include <algorithm>
+#include <iterator>
+#include <cstdio>
+#include <cstdlib>
 
 // 引入 CoreLogger 的头文件
 #include "ILogger.h" 
@@ -19,14 +25,23 @@
 #include "LogEntry.h"
 #include "LogConfig.h" 
 #include "Stopwatch.h"
+#include "LogTailReader.h"
+#include "LogContext.h"
+#include "LoggerStats.h"
+#include "LogAnalytics.h"
 
 // 定义工厂函数指针类型
 typedef ILogger* (*CreateLoggerFunc)();
 typedef int (*RunLoggerFunc)();
 typedef const char* (*DescriptionFunc)();
+typedef int (*GetLoggerStatsFunc)(char*, int);
+typedef void (*GetLoggerStatsSnapshotFunc)(LoggerStatsSnapshot*);
+typedef int (*GetLockProfileReportFunc)(char*, int);
 
 // 辅助常量
 const unsigned long MAX_TEST_FILE_SIZE_BYTES = 10 * 1024; // 10KB (来自 FileWriter.h)
+const int QUEUE_TEST_INFO_COUNT = 2000;  // 队列溢出测试写入的 INFO 条数
+const int QUEUE_TEST_ERROR_COUNT = 20;   // 队列溢出测试写入的 ERROR 条数
 
 namespace fs = std::filesystem;
 
@@ -54,7 +69,7 @@ void PrintTestTitle(const std::string& title) {
 void ThreadLog(Logger* logger, int id) {
     std::string source = "ThreadLog_" + std::to_string(id);
     for (int i = 0; i < 3; ++i) {
-        logger->Info(("多线程测试：来自线程 " + std::to_string(id) + ", 消息 " + std::to_string(i)).c_str(), source.c_str());
+        LOG_INFOF(*logger, source.c_str(), "多线程测试：来自线程 {}, 消息 {}", id, i);
         Wait(5);
     }
 }
@@ -71,7 +86,7 @@ void TestFileRolling(Logger* logger) {
     int logsNeeded = (int)(MAX_TEST_FILE_SIZE_BYTES / 1024) + 3;
 
     for (int i = 1; i <= logsNeeded; ++i) {
-        logger->Warn((largeMessage + " 日志 #" + std::to_string(i)).c_str(), "FileRollTest");
+        LOG_WARNF(*logger, "FileRollTest", "{} 日志 #{}", largeMessage, i);
         if (i % 5 == 0) {
             std::cout << "     已写入 " << i << " 条日志..." << std::endl;
         }
@@ -79,6 +94,457 @@ void TestFileRolling(Logger* logger) {
     std::cout << "   - OK. 已完成 " << logsNeeded << " 条日志写入" << std::endl;
 }
 
+// 测试队列溢出策略：小队列 + 突发写入，INFO 可丢弃，ERROR 永不丢弃
+// 返回突发写入的队列计数，供自监控计数测试核对
+LogQueueCounters TestQueueOverflow() {
+    LogConfig& config = LogConfig::GetInstance();
+    size_t oldCapacity = config.GetQueueCapacity();
+    int oldTimeout = config.GetBlockTimeoutMs();
+    std::string oldPath = config.GetLogFilePath();
+
+    // 同一文件的 Logger 共享 FileWriter，使用独立目录才能得到小容量队列
+    const std::string logDir = "./queue_test_logs";
+    fs::remove_all(logDir);
+    config.SetLogFilePath(logDir);
+
+    config.SetQueueCapacity(16);
+    config.SetBlockTimeoutMs(0);
+    config.SetOverflowPolicy(LogLevel::INFO, OverflowPolicy::DROP_NEWEST);
+    config.SetOverflowPolicy(LogLevel::ERROR_LEVEL, OverflowPolicy::DROP_NEWEST); // 应被强制改为 BLOCK
+
+    const int infoCount = QUEUE_TEST_INFO_COUNT;
+    const int errorCount = QUEUE_TEST_ERROR_COUNT;
+    LogQueueCounters counters;
+    {
+        Logger burstLogger;
+        for (int i = 0; i < infoCount; ++i) {
+            burstLogger.Info("队列突发测试", "QueueOverflowTest");
+            if (i % (infoCount / errorCount) == 0) {
+                burstLogger.Error("队列突发测试 - 错误不可丢弃", "QueueOverflowTest");
+            }
+        }
+        burstLogger.Flush();
+        counters = burstLogger.GetQueueCounters();
+    }
+
+    const int info = static_cast<int>(LogLevel::INFO);
+    const int error = static_cast<int>(LogLevel::ERROR_LEVEL);
+    std::cout << "   INFO 丢弃: " << counters.dropped[info]
+        << ", ERROR 阻塞: " << counters.blocked[error]
+        << ", ERROR 溢出文件: " << counters.spilled[error] << std::endl;
+
+    // ERROR 条目必须全部写入日志文件或溢出文件（目录下全部 .log 文件，含滚动后的文件）
+    int errorsWritten = 0;
+    for (const auto& entry : fs::directory_iterator(logDir)) {
+        if (entry.path().extension() != ".log") {
+            continue;
+        }
+        std::ifstream in(entry.path());
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.find("错误不可丢弃") != std::string::npos) {
+                ++errorsWritten;
+            }
+        }
+    }
+    std::cout << "   ERROR 写入/溢出: " << errorsWritten << "/" << errorCount << std::endl;
+
+    std::string failure;
+    if (counters.dropped[info] == 0) {
+        failure = "DROP_NEWEST 策略下 INFO 日志没有被丢弃";
+    } else if (counters.dropped[error] != 0 || errorsWritten != errorCount) {
+        failure = "ERROR 级别日志被丢弃";
+    }
+
+    // 恢复原配置
+    config.SetQueueCapacity(oldCapacity);
+    config.SetBlockTimeoutMs(oldTimeout);
+    config.SetOverflowPolicy(LogLevel::INFO, OverflowPolicy::BLOCK);
+    config.SetLogFilePath(oldPath);
+
+    if (!failure.empty()) {
+        throw std::runtime_error(failure);
+    }
+    std::cout << "   - OK. 溢出策略测试完成" << std::endl;
+    return counters;
+}
+
+// 共享写入器测试：同一文件的两个 Logger 共享一个队列，
+// 对其中一个调用 Flush 即可保证另一个写入的条目已落盘
+void TestSharedWriter() {
+    LogConfig& config = LogConfig::GetInstance();
+    std::string oldPath = config.GetLogFilePath();
+    const std::string logDir = "./shared_writer_logs";
+    fs::remove_all(logDir);
+    config.SetLogFilePath(logDir);
+
+    const int lineCount = 500;
+    {
+        Logger first;
+        Logger second;
+        for (int i = 0; i < lineCount; ++i) {
+            first.Info("共享写入器测试", "SharedWriterTest");
+        }
+        second.Flush();
+
+        // 写入过程中会发生滚动，统计目录下全部 .log 文件
+        int found = 0;
+        for (const auto& entry : fs::directory_iterator(logDir)) {
+            if (entry.path().extension() != ".log") {
+                continue;
+            }
+            std::ifstream in(entry.path());
+            std::string line;
+            while (std::getline(in, line)) {
+                if (line.find("SharedWriterTest") != std::string::npos) {
+                    ++found;
+                }
+            }
+        }
+        std::cout << "   通过第二个实例 Flush 后可见的日志: " << found << "/" << lineCount << std::endl;
+        if (found != lineCount) {
+            config.SetLogFilePath(oldPath);
+            throw std::runtime_error("同一文件的 Logger 未共享 FileWriter");
+        }
+    }
+
+    config.SetLogFilePath(oldPath);
+    std::cout << "   - OK. 共享写入器测试完成" << std::endl;
+}
+
+// 诊断上下文测试：嵌套作用域输出 [key=value ...]，离开作用域后恢复，其他线程不受影响
+void TestLogContext() {
+    LogConfig& config = LogConfig::GetInstance();
+    std::string oldPath = config.GetLogFilePath();
+    const std::string logDir = "./context_test_logs";
+    fs::remove_all(logDir);
+    config.SetLogFilePath(logDir);
+
+    {
+        Logger logger;
+        {
+            LogContextScope request("requestId", "R-1001");
+            logger.Info("外层上下文", "LogContextTest");
+            {
+                LogContextScope job("jobId", "7");
+                logger.Info("内层上下文", "LogContextTest");
+                std::thread other([&logger]() {
+                    logger.Info("其他线程无上下文", "LogContextTest");
+                });
+                other.join();
+            }
+        }
+        logger.Info("作用域结束", "LogContextTest");
+        logger.Flush();
+    }
+    config.SetLogFilePath(oldPath);
+
+    std::ifstream in(fs::path(logDir) / "application.log");
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    auto lineOf = [&content](const std::string& message) {
+        size_t pos = content.find(message);
+        if (pos == std::string::npos) {
+            return std::string();
+        }
+        size_t start = content.rfind('\n', pos);
+        return content.substr(start == std::string::npos ? 0 : start + 1, pos - (start == std::string::npos ? 0 : start + 1));
+    };
+
+    bool ok = lineOf("外层上下文").find("[requestId=R-1001] ") != std::string::npos &&
+        lineOf("内层上下文").find("[requestId=R-1001 jobId=7] ") != std::string::npos &&
+        lineOf("其他线程无上下文").find("requestId") == std::string::npos &&
+        !lineOf("作用域结束").empty() && lineOf("作用域结束").find("requestId") == std::string::npos;
+    if (!ok) {
+        throw std::runtime_error("诊断上下文输出不正确");
+    }
+    std::cout << "   - OK. 诊断上下文测试完成" << std::endl;
+}
+
+// 类型化格式字符串测试：占位符替换、转义、数值转换，以及参数数量不一致时的运行期行为
+void TestFormatString() {
+    std::string name = "BulkSender";
+    struct Case {
+        std::string actual;
+        const char* expected;
+    } cases[] = {
+        { LogFormat::Format("发送第 {} 封，共 {} 封 ({})", 3, 10u, name), "发送第 3 封，共 10 封 (BulkSender)" },
+        { LogFormat::Format("耗时 {} ms, 成功 {}", 12.5, true), "耗时 12.5 ms, 成功 true" },
+        { LogFormat::Format("{{字面量}} {}", -42LL), "{字面量} -42" },
+        { LogFormat::Format("缺少参数 {} {}", 'x'), "缺少参数 x {}" },
+        { LogFormat::Format("多余参数 {}", 1, 2), "多余参数 1" },
+    };
+    static_assert(LogFormat::CountPlaceholders("{} {{}} {}") == 2, "占位符计数错误");
+
+    for (const auto& c : cases) {
+        if (c.actual != c.expected) {
+            throw std::runtime_error("格式化结果不正确: " + c.actual);
+        }
+    }
+    std::cout << "   - OK. 类型化格式字符串测试完成" << std::endl;
+}
+
+// 多进程压力测试的子进程：向共享目录写入 count 条带编号的日志
+int RunMultiProcessChild(const std::string& logDir, int childId, int count) {
+    LogConfig::GetInstance().SetLogFilePath(logDir);
+    LogConfig::GetInstance().SetRetentionDays(0);
+    Logger logger;
+    for (int i = 0; i < count; ++i) {
+        LOG_INFOF(logger, "MultiProcessTest", "MP child {} line {}", childId, i);
+    }
+    return 0;
+}
+
+// 批量写入测试：构建器中被过滤的条目不进入批次，整批写入后与之前排队的单条日志保持顺序
+void TestLogBatch() {
+    LogConfig& config = LogConfig::GetInstance();
+    std::string oldPath = config.GetLogFilePath();
+    const std::string logDir = "./batch_test_logs";
+    fs::remove_all(logDir);
+    config.SetLogFilePath(logDir);
+
+    const int batchSize = 500;
+    {
+        Logger logger;
+        logger.Info("批量写入之前的单条日志", "LogBatchTest");
+
+        config.SetMinLogLevel(LogLevel::WARNING);
+        LogEntryBatch batch;
+        for (int i = 0; i < batchSize; ++i) {
+            batch.Info("应被过滤的批量日志", "LogBatchTest");
+            batch.WarnF("LogBatchTest", "批量日志 {}", i);
+        }
+        config.SetMinLogLevel(LogLevel::INFO);
+        if (batch.Size() != static_cast<size_t>(batchSize)) {
+            config.SetLogFilePath(oldPath);
+            throw std::runtime_error("批次中包含了被过滤的条目");
+        }
+        logger.LogBatch(batch);
+
+        const char* messages[] = { "接口批量日志 A", "接口批量日志 B" };
+        static_cast<ILogger&>(logger).LogBatch(messages, 2, "LogBatchTest");
+        logger.Flush();
+
+        // 统计目录下全部 .log 文件，并检查单条日志位于批次之前
+        int found = 0;
+        int filtered = 0;
+        int singleIndex = -1;
+        int firstBatchIndex = -1;
+        fs::path singleFile;
+        fs::path firstBatchFile;
+        for (const auto& entry : fs::directory_iterator(logDir)) {
+            if (entry.path().extension() != ".log") {
+                continue;
+            }
+            std::ifstream in(entry.path());
+            std::string line;
+            int index = 0;
+            while (std::getline(in, line)) {
+                if (line.find("LogBatchTest") != std::string::npos) {
+                    ++found;
+                    if (line.find("应被过滤") != std::string::npos) {
+                        ++filtered;
+                    }
+                    if (line.find("单条日志") != std::string::npos) {
+                        singleIndex = index;
+                        singleFile = entry.path();
+                    }
+                    if (firstBatchIndex < 0 && line.find("批量日志 0") != std::string::npos) {
+                        firstBatchIndex = index;
+                        firstBatchFile = entry.path();
+                    }
+                }
+                ++index;
+            }
+        }
+        std::cout << "   批量写入的日志: " << found << "/" << (batchSize + 3) << std::endl;
+        if (found != batchSize + 3 || filtered != 0 ||
+            (singleFile == firstBatchFile && singleIndex > firstBatchIndex)) {
+            config.SetLogFilePath(oldPath);
+            throw std::runtime_error("批量写入的条目数量或顺序不正确");
+        }
+    }
+
+    config.SetLogFilePath(oldPath);
+    std::cout << "   - OK. 批量写入测试完成" << std::endl;
+}
+
+// 多进程压力测试：多个进程写同一个 application.log 并频繁滚动，
+// 检查每一行都完整且每条日志恰好出现一次 (不交错、不丢失、不重复)
+void TestMultiProcessStress() {
+    const std::string logDir = "./mp_test_logs";
+    const int processCount = 4;
+    const int linesPerProcess = 2000;
+
+    fs::remove_all(logDir);
+
+    char exePath[MAX_PATH];
+    ::GetModuleFileNameA(NULL, exePath, MAX_PATH);
+
+    std::vector<PROCESS_INFORMATION> children;
+    for (int id = 0; id < processCount; ++id) {
+        std::string cmd = "\"" + std::string(exePath) + "\" --mp-child " + logDir + " " +
+            std::to_string(id) + " " + std::to_string(linesPerProcess);
+        STARTUPINFOA si{};
+        si.cb = sizeof(si);
+        PROCESS_INFORMATION pi{};
+        if (!::CreateProcessA(NULL, &cmd[0], NULL, NULL, FALSE, CREATE_NO_WINDOW, NULL, NULL, &si, &pi)) {
+            throw std::runtime_error("无法启动子进程，WinError: " + std::to_string(::GetLastError()));
+        }
+        children.push_back(pi);
+    }
+
+    for (auto& pi : children) {
+        ::WaitForSingleObject(pi.hProcess, INFINITE);
+        ::CloseHandle(pi.hThread);
+        ::CloseHandle(pi.hProcess);
+    }
+
+    std::set<std::pair<int, int>> seen;
+    int fileCount = 0;
+    int badLines = 0;
+    int duplicates = 0;
+    for (const auto& entry : fs::directory_iterator(logDir)) {
+        if (entry.path().extension() != ".log") {
+            continue;
+        }
+        ++fileCount;
+        std::ifstream in(entry.path());
+        std::string line;
+        while (std::getline(in, line)) {
+            int childId = 0;
+            int lineNo = 0;
+            size_t pos = line.find("MP child ");
+            if (line.compare(0, 2, "20") != 0 || pos == std::string::npos ||
+                std::sscanf(line.c_str() + pos, "MP child %d line %d", &childId, &lineNo) != 2) {
+                ++badLines;
+                continue;
+            }
+            if (!seen.insert({ childId, lineNo }).second) {
+                ++duplicates;
+            }
+        }
+    }
+
+    std::cout << "   文件数: " << fileCount << ", 完整日志: " << seen.size() << "/" << processCount * linesPerProcess
+        << ", 损坏行: " << badLines << ", 重复: " << duplicates << std::endl;
+
+    if (seen.size() != static_cast<size_t>(processCount * linesPerProcess) || badLines != 0 || duplicates != 0) {
+        throw std::runtime_error("多进程写入出现交错、丢失或重复");
+    }
+    std::cout << "   - OK. 多进程追加与滚动测试完成" << std::endl;
+}
+
+// 跟随读取测试：从第一个段开始读取多进程测试产生的全部日志，
+// 中途保存游标并用新的读取器续读，检查跨滚动不丢失、不重复
+void TestTailReader() {
+    const std::string logDir = "./mp_test_logs";
+    const size_t expected = 4 * 2000;
+
+    std::set<std::pair<int, int>> seen;
+    int duplicates = 0;
+    auto consume = [&](LogTailReader& reader, size_t limit) {
+        std::vector<LogLineView> lines;
+        size_t count = 0;
+        while (count < limit && reader.ReadBatch(lines, 4096) > 0) {
+            for (const auto& view : lines) {
+                std::string line(view.data, view.length);
+                int childId = 0;
+                int lineNo = 0;
+                size_t pos = line.find("MP child ");
+                if (pos != std::string::npos &&
+                    std::sscanf(line.c_str() + pos, "MP child %d line %d", &childId, &lineNo) == 2 &&
+                    !seen.insert({ childId, lineNo }).second) {
+                    ++duplicates;
+                }
+            }
+            count += lines.size();
+        }
+    };
+
+    LogCursor cursor;
+    cursor.segmentId = 0;
+    {
+        LogTailReader reader(logDir, "application.log", cursor);
+        consume(reader, expected / 2);
+        cursor = reader.GetCursor();
+    }
+    std::cout << "   中途游标: 段 " << cursor.segmentId << ", 偏移 " << cursor.offset << std::endl;
+
+    LogTailReader resumed(logDir, "application.log", cursor);
+    consume(resumed, expected * 2);
+
+    std::cout << "   读取日志: " << seen.size() << "/" << expected << ", 重复: " << duplicates << std::endl;
+    if (seen.size() != expected || duplicates != 0) {
+        throw std::runtime_error("跟随读取跨滚动出现丢失或重复");
+    }
+    std::cout << "   - OK. 跟随读取测试完成" << std::endl;
+}
+
+// 日志分析：用固定内容的日志文件 (活动文件 + 一个备份文件) 验证每分钟级别计数与前 N 统计
+// 时间选在 1 月中旬，避开各时区的夏令时切换；分钟标签应与日志中的本地时间一致
+void TestLogAnalytics() {
+    const std::string logDir = "./analytics_test_logs";
+    fs::remove_all(logDir);
+    fs::create_directories(logDir);
+    {
+        std::ofstream rolled(logDir + "/application.20240115_100100.log", std::ios::binary);
+        rolled << "2024-01-15 10:00:05 [INFO]  [TID:11]  [SourceA] first\n"
+            << "2024-01-15 10:00:30 [WARNING]  [TID:11]  [SourceA] second\n"
+            << "2024-01-15 10:00:59 [ERROR]  [TID:22]  [SourceB] third\n"
+            << "    at continuation line\n";
+        std::ofstream active(logDir + "/application.log", std::ios::binary);
+        active << "2024-01-15 10:01:00 [INFO]  [TID:22]  [SourceA] fourth\r\n"
+            << "2024-01-15 10:01:10 [FATAL]  [TID:33]  [SourceC] fifth\n"
+            << "2024-01-15 10:03:00 [INFO]  [TID:11]  [SourceB] [req=7] sixth";
+    }
+
+    LogAnalytics::LogTable table;
+    std::string errorMsg;
+    if (!LogAnalytics::Load(LogAnalytics::FindLogFiles(logDir), table, errorMsg, 2)) {
+        throw std::runtime_error("日志分析加载失败: " + errorMsg);
+    }
+    if (table.RowCount() != 6 || table.unparsedLines != 1 || table.Message(5) != "[req=7] sixth") {
+        throw std::runtime_error("日志分析解析的行数或消息不正确");
+    }
+
+    struct ExpectedMinute {
+        const char* label;
+        uint64_t counts[LogAnalytics::LEVEL_COUNT];
+    };
+    const ExpectedMinute expectedMinutes[] = {
+        { "2024-01-15 10:00", { 1, 1, 1, 0 } },
+        { "2024-01-15 10:01", { 1, 0, 0, 1 } },
+        { "2024-01-15 10:03", { 1, 0, 0, 0 } },
+    };
+    auto minutes = LogAnalytics::CountByLevelPerMinute(table, 2);
+    bool minutesOk = minutes.size() == 3;
+    for (size_t i = 0; minutesOk && i < minutes.size(); ++i) {
+        minutesOk = LogAnalytics::FormatMinute(minutes[i].minute) == expectedMinutes[i].label &&
+            std::equal(std::begin(minutes[i].counts), std::end(minutes[i].counts), expectedMinutes[i].counts);
+    }
+    if (!minutesOk) {
+        throw std::runtime_error("每分钟各级别计数不正确");
+    }
+
+    auto sources = LogAnalytics::TopSources(table, 2, 0, 2);
+    auto errorSources = LogAnalytics::TopSources(table, 5, 2, 2);
+    std::set<std::string> errorSourceNames;
+    for (const auto& source : errorSources) {
+        errorSourceNames.insert(source.first);
+    }
+    auto threads = LogAnalytics::TopThreads(table, 1, 0, 2);
+    if (sources.size() != 2 || sources[0] != std::make_pair(std::string("SourceA"), uint64_t(3)) ||
+        sources[1] != std::make_pair(std::string("SourceB"), uint64_t(2)) ||
+        errorSourceNames != std::set<std::string>{ "SourceB", "SourceC" } ||
+        threads.size() != 1 || threads[0] != std::make_pair(uint32_t(11), uint64_t(3))) {
+        throw std::runtime_error("前 N 个来源类/线程统计不正确");
+    }
+
+    table = LogAnalytics::LogTable(); // 释放映射后才能删除目录
+    fs::remove_all(logDir);
+    std::cout << "   - OK. 日志分析测试完成" << std::endl;
+}
+
 // -------------------------------------------------------------------
 // 第一轮功能测试 (Phase 1: 基础功能测试)
 // -------------------------------------------------------------------
@@ -237,28 +703,148 @@ void TestPhase3_Persistence(Logger* concreteLogger) {
     LogConfig::GetInstance().SetLogFilePath(oldPath);
     std::cout << "   - OK. 配置修改测试完成，已恢复原配置" << std::endl;
 
+    // 3.6 的自监控计数以 3.4 开始前的快照为基准
+    HMODULE hDll = GetModuleHandleA("CoreLogger.dll");
+    GetLoggerStatsSnapshotFunc getSnapshot = hDll
+        ? (GetLoggerStatsSnapshotFunc)::GetProcAddress(hDll, "GetLoggerStatsSnapshot") : nullptr;
+    LoggerStatsSnapshot statsBefore = {};
+    if (getSnapshot) {
+        getSnapshot(&statsBefore);
+    }
+
     // 3.4 压力测试（少量）
     std::cout << "\n3.4 压力测试..." << std::endl;
+    const int stressCount = 50;
     Stopwatch stopwatch;
     stopwatch.Start();
 
-    for (int i = 0; i < 50; ++i) {
-        concreteLogger->Info(("压力测试消息 #" + std::to_string(i)).c_str(), "StressTest");
+    for (int i = 0; i < stressCount; ++i) {
+        LOG_INFOF(*concreteLogger, "StressTest", "压力测试消息 #{}", i);
         if (i % 10 == 0) {
             Wait(1);
         }
     }
 
     stopwatch.Stop();
-    std::cout << "   写入 50 条日志耗时: " << stopwatch.GetElapsedMilliseconds() << "ms" << std::endl;
+    std::cout << "   写入 " << stressCount << " 条日志耗时: " << stopwatch.GetElapsedMilliseconds() << "ms" << std::endl;
     std::cout << "   - OK. 压力测试完成" << std::endl;
+
+    // 3.5 测试异步队列溢出策略
+    std::cout << "\n3.5 测试异步队列溢出策略..." << std::endl;
+    LogQueueCounters burstCounters = TestQueueOverflow();
+
+    // 3.6 测试自监控计数导出
+    // 3.4、3.5 期间通过级别过滤的条目 = 写入文件的条目 + 队列丢弃的条目，
+    // 导出的 accepted 增量必须与两步写入的条数一致
+    std::cout << "\n3.6 测试自监控计数导出..." << std::endl;
+    GetLoggerStatsFunc getStats = hDll ? (GetLoggerStatsFunc)::GetProcAddress(hDll, "GetLoggerStats") : nullptr;
+    if (getStats && getSnapshot) {
+        concreteLogger->Flush();
+        LoggerStatsSnapshot statsAfter = {};
+        getSnapshot(&statsAfter);
+        std::vector<char> buffer(getStats(nullptr, 0));
+        getStats(buffer.data(), static_cast<int>(buffer.size()));
+        std::cout << "   " << buffer.data() << std::endl;
+
+        const int info = static_cast<int>(LogLevel::INFO);
+        const int error = static_cast<int>(LogLevel::ERROR_LEVEL);
+        unsigned long long infoAccepted = statsAfter.accepted[info] - statsBefore.accepted[info];
+        unsigned long long errorAccepted = statsAfter.accepted[error] - statsBefore.accepted[error];
+        unsigned long long infoExpected = stressCount + QUEUE_TEST_INFO_COUNT;
+        std::cout << "   INFO 通过过滤: " << infoAccepted << "/" << infoExpected
+            << " (其中队列丢弃 " << burstCounters.dropped[info] << ")"
+            << ", ERROR 通过过滤: " << errorAccepted << "/" << QUEUE_TEST_ERROR_COUNT << std::endl;
+
+        if (infoAccepted != infoExpected || errorAccepted != static_cast<unsigned long long>(QUEUE_TEST_ERROR_COUNT)) {
+            throw std::runtime_error("自监控计数与写入的日志条数不一致");
+        }
+        if (burstCounters.dropped[info] > infoAccepted) {
+            throw std::runtime_error("队列丢弃计数大于写入的日志条数");
+        }
+        if (statsAfter.bytesWritten <= statsBefore.bytesWritten || statsAfter.flushes <= statsBefore.flushes) {
+            throw std::runtime_error("自监控计数中写入字节数或刷新次数没有增加");
+        }
+        std::string expectedJson = "\"INFO\":" + std::to_string(statsAfter.accepted[info]);
+        if (std::string(buffer.data()).find(expectedJson) == std::string::npos) {
+            throw std::runtime_error("GetLoggerStats 导出的 JSON 与计数快照不一致");
+        }
+        std::cout << "   - OK. 自监控计数已导出且与写入条数一致" << std::endl;
+    }
+    else {
+        std::cout << "   警告：无法找到 GetLoggerStats/GetLoggerStatsSnapshot 导出函数" << std::endl;
+    }
+
+    // 3.7 多进程并发追加与滚动
+    std::cout << "\n3.7 多进程并发追加与滚动测试..." << std::endl;
+    TestMultiProcessStress();
+
+    // 3.8 跟随读取 (跨滚动续读)
+    std::cout << "\n3.8 跟随读取与游标续读测试..." << std::endl;
+    TestTailReader();
+
+    // 3.9 同一文件的多个 Logger 共享 FileWriter
+    std::cout << "\n3.9 共享写入器测试..." << std::endl;
+    TestSharedWriter();
+
+    // 3.10 线程局部诊断上下文 (MDC)
+    std::cout << "\n3.10 诊断上下文测试..." << std::endl;
+    TestLogContext();
+
+    // 3.11 类型化格式字符串
+    std::cout << "\n3.11 类型化格式字符串测试..." << std::endl;
+    TestFormatString();
+
+    // 3.12 锁竞争报告：多个线程同时写入并刷新，制造 writeMutex_ 竞争
+    std::cout << "\n3.12 锁竞争报告测试..." << std::endl;
+    {
+        std::vector<std::thread> writers;
+        for (int t = 0; t < 4; ++t) {
+            writers.emplace_back([concreteLogger, t]() {
+                for (int i = 0; i < 200; ++i) {
+                    LOG_INFOF(*concreteLogger, "LockProfileTest", "线程 {} 消息 {}", t, i);
+                    if (i % 20 == 0) {
+                        concreteLogger->Flush();
+                    }
+                }
+            });
+        }
+        for (auto& writer : writers) {
+            writer.join();
+        }
+    }
+    GetLockProfileReportFunc getLockReport = hDll ? (GetLockProfileReportFunc)::GetProcAddress(hDll, "GetLockProfileReport") : nullptr;
+    if (getLockReport) {
+        std::vector<char> buffer(getLockReport(nullptr, 0));
+        getLockReport(buffer.data(), static_cast<int>(buffer.size()));
+        std::cout << buffer.data();
+        if (std::string(buffer.data()).find("FileWriter::writeMutex_") == std::string::npos) {
+            throw std::runtime_error("锁竞争报告中缺少 FileWriter::writeMutex_");
+        }
+        std::cout << "   - OK. 锁竞争报告已导出" << std::endl;
+    }
+    else {
+        std::cout << "   警告：无法找到 GetLockProfileReport 导出函数" << std::endl;
+    }
+
+    // 3.13 批量写入
+    std::cout << "\n3.13 批量写入测试..." << std::endl;
+    TestLogBatch();
+
+    // 3.14 日志分析工具
+    std::cout << "\n3.14 日志分析测试..." << std::endl;
+    TestLogAnalytics();
 }
 
 // -------------------------------------------------------------------
 // 主函数 (Main Function: Setup & Execution)
 // -------------------------------------------------------------------
 
-int main() {
+int main(int argc, char* argv[]) {
+    // 多进程压力测试的子进程入口
+    if (argc >= 5 && std::string(argv[1]) == "--mp-child") {
+        return RunMultiProcessChild(argv[2], std::atoi(argv[3]), std::atoi(argv[4]));
+    }
+
     std::cout << "========================================" << std::endl;
     std::cout << "=== CoreLogger DLL 综合功能测试程序 ===" << std::endl;
     std::cout << "========================================" << std::endl;
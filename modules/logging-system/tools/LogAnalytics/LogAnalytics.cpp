@@ -0,0 +1,589 @@
+﻿// LogAnalytics.cpp
+#include "LogAnalytics.h"
+#include <Windows.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <map>
+#include <thread>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace LogAnalytics {
+
+    // 步骤 4.8：只读映射整个日志文件，解析与查询期间消息直接引用映射区域
+    class MappedFile {
+    public:
+        explicit MappedFile(const std::string& path)
+            : file_(INVALID_HANDLE_VALUE), mapping_(nullptr), data_(nullptr), size_(0) {
+            file_ = ::CreateFileA(path.c_str(), GENERIC_READ,
+                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (file_ == INVALID_HANDLE_VALUE) {
+                return;
+            }
+            LARGE_INTEGER size{};
+            if (!::GetFileSizeEx(file_, &size) || size.QuadPart == 0) {
+                return;
+            }
+            mapping_ = ::CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping_ == nullptr) {
+                return;
+            }
+            data_ = static_cast<const char*>(::MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+            if (data_) {
+                size_ = static_cast<uint64_t>(size.QuadPart);
+            }
+        }
+
+        ~MappedFile() {
+            if (data_) {
+                ::UnmapViewOfFile(data_);
+            }
+            if (mapping_) {
+                ::CloseHandle(mapping_);
+            }
+            if (file_ != INVALID_HANDLE_VALUE) {
+                ::CloseHandle(file_);
+            }
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool IsOpen() const { return file_ != INVALID_HANDLE_VALUE; }
+        const char* Data() const { return data_; }
+        uint64_t Size() const { return size_; }
+
+    private:
+        HANDLE file_;
+        HANDLE mapping_;
+        const char* data_;
+        uint64_t size_;
+    };
+
+    namespace {
+        // 每个解析任务处理的字节数；任务边界对齐到行首
+        const uint64_t CHUNK_BYTES = 32ull * 1024 * 1024;
+
+        // 每分钟计数使用稠密数组的上限 (分钟数 * 级别数)，超过时改用有序映射
+        const int64_t DENSE_MINUTE_SLOTS = 1 << 20;
+
+        unsigned ResolveThreads(unsigned threadCount) {
+            if (threadCount == 0) {
+                threadCount = std::thread::hardware_concurrency();
+            }
+            return threadCount == 0 ? 1 : threadCount;
+        }
+
+        // 把 [0, count) 平均分给 threadCount 个线程并行执行 fn(part, begin, end)
+        template <typename Fn>
+        void ParallelFor(size_t count, unsigned threadCount, Fn fn) {
+            unsigned parts = static_cast<unsigned>((std::min)(static_cast<size_t>(threadCount), (std::max)(count, static_cast<size_t>(1))));
+            std::vector<std::thread> workers;
+            for (unsigned part = 0; part < parts; ++part) {
+                size_t begin = count * part / parts;
+                size_t end = count * (part + 1) / parts;
+                workers.emplace_back(fn, part, begin, end);
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+        }
+
+        // 公历日期 -> 自 1970-01-01 起的天数
+        int64_t DaysFromCivil(int64_t y, unsigned m, unsigned d) {
+            y -= m <= 2;
+            const int64_t era = (y >= 0 ? y : y - 399) / 400;
+            const unsigned yoe = static_cast<unsigned>(y - era * 400);
+            const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+            const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+            return era * 146097 + static_cast<int64_t>(doe) - 719468;
+        }
+
+        // 自 1970-01-01 起的天数 -> 公历日期
+        void CivilFromDays(int64_t days, int64_t& year, unsigned& month, unsigned& day) {
+            const int64_t z = days + 719468;
+            const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+            const unsigned doe = static_cast<unsigned>(z - era * 146097);
+            const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+            const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+            const unsigned mp = (5 * doy + 2) / 153;
+            day = doy - (153 * mp + 2) / 5 + 1;
+            month = mp < 10 ? mp + 3 : mp - 9;
+            year = static_cast<int64_t>(yoe) + era * 400 + (month <= 2);
+        }
+
+        // 日志中的时间是本地时间 (FileWriter 使用 localtime_s)，换算为 UTC 秒数后
+        // 跨夏令时切换的行才能正确排序和分桶
+        // - 时区偏移只在整点变化，按本地小时缓存，每小时只调用一次 mktime
+        // - 夏令时结束时重复的一小时有两个候选：默认取较早的一个，
+        //   结果比上一行早半小时以上 (日志已进入重复的第二遍) 时取较晚的一个
+        // - 每个解析任务独立使用一个实例；任务恰好从重复小时的第二遍开始时，这部分行会按第一遍计算
+        class LocalTimeConverter {
+        public:
+            int64_t ToUtc(int64_t localSeconds) {
+                const int64_t hour = localSeconds / 3600;
+                if (hour != hour_) {
+                    Resolve(hour);
+                }
+                int64_t utc = localSeconds - earlyOffset_;
+                if (lateOffset_ != earlyOffset_ && utc < last_ - 1800) {
+                    utc = localSeconds - lateOffset_;
+                }
+                last_ = utc;
+                return utc;
+            }
+
+        private:
+            void Resolve(int64_t hour) {
+                hour_ = hour;
+                const int64_t local = hour * 3600;
+                int64_t year = 0;
+                unsigned month = 0;
+                unsigned day = 0;
+                CivilFromDays(local / 86400, year, month, day);
+                std::tm bt{};
+                bt.tm_year = static_cast<int>(year - 1900);
+                bt.tm_mon = static_cast<int>(month) - 1;
+                bt.tm_mday = static_cast<int>(day);
+                bt.tm_hour = static_cast<int>(hour % 24);
+                bt.tm_isdst = -1;
+                const std::time_t start = std::mktime(&bt);
+                if (start == static_cast<std::time_t>(-1)) {
+                    // 无法换算 (超出 CRT 支持的范围)：按 UTC 处理
+                    earlyOffset_ = lateOffset_ = 0;
+                    return;
+                }
+                earlyOffset_ = lateOffset_ = local - static_cast<int64_t>(start);
+                // 前后一小时的起点若仍是同一个本地小时，说明这一小时重复出现
+                for (const std::time_t other : { start - 3600, start + 3600 }) {
+                    std::tm ot{};
+                    if (localtime_s(&ot, &other) == 0 && ot.tm_hour == bt.tm_hour &&
+                        ot.tm_mday == bt.tm_mday && ot.tm_min == 0) {
+                        const int64_t offset = local - static_cast<int64_t>(other);
+                        earlyOffset_ = (std::max)(earlyOffset_, offset);
+                        lateOffset_ = (std::min)(lateOffset_, offset);
+                    }
+                }
+            }
+
+            int64_t hour_ = INT64_MIN;
+            int64_t earlyOffset_ = 0;
+            int64_t lateOffset_ = 0;
+            int64_t last_ = INT64_MIN;
+        };
+
+        inline bool IsDigit(char c) {
+            return c >= '0' && c <= '9';
+        }
+
+        inline unsigned Digits2(const char* p) {
+            return static_cast<unsigned>((p[0] - '0') * 10 + (p[1] - '0'));
+        }
+
+        // 一个解析任务的结果 (来源类使用任务内的局部字典)
+        struct ColumnChunk {
+            std::vector<int64_t> timestamp;
+            std::vector<uint8_t> level;
+            std::vector<uint32_t> thread;
+            std::vector<uint32_t> source;
+            std::vector<uint64_t> messageOffset;
+            std::vector<uint32_t> messageLength;
+            std::vector<std::string_view> sourceNames;
+            uint64_t unparsedLines = 0;
+            LocalTimeConverter clock;
+        };
+
+        struct ParseTask {
+            uint32_t file;
+            uint64_t begin;
+            uint64_t end;
+        };
+
+        // 解析一行；格式不符时返回 false
+        bool ParseLine(const char* line, const char* end, const char* base,
+            std::unordered_map<std::string_view, uint32_t>& dictionary, ColumnChunk& out) {
+            // "YYYY-MM-DD HH:MM:SS"
+            if (end - line < 19 || line[4] != '-' || line[7] != '-' || line[10] != ' ' ||
+                line[13] != ':' || line[16] != ':') {
+                return false;
+            }
+            static const int digitPos[] = { 0, 1, 2, 3, 5, 6, 8, 9, 11, 12, 14, 15, 17, 18 };
+            for (int pos : digitPos) {
+                if (!IsDigit(line[pos])) {
+                    return false;
+                }
+            }
+            const int64_t year = Digits2(line) * 100 + Digits2(line + 2);
+            const int64_t localSeconds = DaysFromCivil(year, Digits2(line + 5), Digits2(line + 8)) * 86400 +
+                Digits2(line + 11) * 3600 + Digits2(line + 14) * 60 + Digits2(line + 17);
+
+            // " [LEVEL] "
+            const char* p = line + 19;
+            if (end - p < 3 || p[0] != ' ' || p[1] != '[') {
+                return false;
+            }
+            p += 2;
+            uint8_t level;
+            switch (*p) {
+            case 'I': level = 0; break;
+            case 'W': level = 1; break;
+            case 'E': level = 2; break;
+            case 'F': level = 3; break;
+            default: return false;
+            }
+            p = static_cast<const char*>(std::memchr(p, ']', end - p));
+            if (!p) {
+                return false;
+            }
+
+            // "]  [TID:n] "
+            static const char TID_PREFIX[] = "]  [TID:";
+            if (end - p < static_cast<ptrdiff_t>(sizeof(TID_PREFIX) - 1) ||
+                std::memcmp(p, TID_PREFIX, sizeof(TID_PREFIX) - 1) != 0) {
+                return false;
+            }
+            p += sizeof(TID_PREFIX) - 1;
+            uint32_t tid = 0;
+            while (p < end && IsDigit(*p)) {
+                tid = tid * 10 + static_cast<uint32_t>(*p - '0');
+                ++p;
+            }
+
+            // "]  [SourceClass] "
+            if (end - p < 4 || p[0] != ']' || p[1] != ' ' || p[2] != ' ' || p[3] != '[') {
+                return false;
+            }
+            const char* sourceBegin = p + 4;
+            const char* sourceEnd = sourceBegin;
+            while (sourceEnd + 1 < end && !(sourceEnd[0] == ']' && sourceEnd[1] == ' ')) {
+                ++sourceEnd;
+            }
+            if (sourceEnd + 1 >= end) {
+                return false;
+            }
+            const char* message = sourceEnd + 2;
+
+            std::string_view sourceName(sourceBegin, static_cast<size_t>(sourceEnd - sourceBegin));
+            auto it = dictionary.find(sourceName);
+            uint32_t sourceId;
+            if (it == dictionary.end()) {
+                sourceId = static_cast<uint32_t>(out.sourceNames.size());
+                dictionary.emplace(sourceName, sourceId);
+                out.sourceNames.push_back(sourceName);
+            }
+            else {
+                sourceId = it->second;
+            }
+
+            out.timestamp.push_back(out.clock.ToUtc(localSeconds));
+            out.level.push_back(level);
+            out.thread.push_back(tid);
+            out.source.push_back(sourceId);
+            out.messageOffset.push_back(static_cast<uint64_t>(message - base));
+            out.messageLength.push_back(static_cast<uint32_t>(end - message));
+            return true;
+        }
+
+        // 解析一个任务：只处理起始位置落在 [begin, end) 内的行
+        void ParseChunk(const MappedFile& file, uint64_t begin, uint64_t end, ColumnChunk& out) {
+            const char* base = file.Data();
+            const char* limit = base + file.Size();
+            const char* p = base + begin;
+            if (begin > 0 && p[-1] != '\n') {
+                p = static_cast<const char*>(std::memchr(p, '\n', limit - p));
+                if (!p) {
+                    return;
+                }
+                ++p;
+            }
+
+            std::unordered_map<std::string_view, uint32_t> dictionary;
+            const size_t estimatedRows = static_cast<size_t>((end - begin) / 96);
+            out.timestamp.reserve(estimatedRows);
+            out.level.reserve(estimatedRows);
+            out.thread.reserve(estimatedRows);
+            out.source.reserve(estimatedRows);
+            out.messageOffset.reserve(estimatedRows);
+            out.messageLength.reserve(estimatedRows);
+
+            const char* stop = base + end;
+            while (p < stop) {
+                const char* newline = static_cast<const char*>(std::memchr(p, '\n', limit - p));
+                const char* lineEnd = newline ? newline : limit;
+                const char* contentEnd = (lineEnd > p && lineEnd[-1] == '\r') ? lineEnd - 1 : lineEnd;
+                if (contentEnd > p && !ParseLine(p, contentEnd, base, dictionary, out)) {
+                    ++out.unparsedLines;
+                }
+                if (!newline) {
+                    break;
+                }
+                p = newline + 1;
+            }
+        }
+
+    }
+
+    std::string_view LogTable::Message(size_t row) const {
+        const MappedFile& mapped = *files[file[row]];
+        return std::string_view(mapped.Data() + messageOffset[row], messageLength[row]);
+    }
+
+    // 步骤 4.8：application.log 以及 application.YYYYMMDD_HHMMSS[_N].log 备份文件
+    std::vector<std::string> FindLogFiles(const std::string& logDir) {
+        std::vector<std::string> paths;
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator(logDir, ec)) {
+            const std::string name = entry.path().filename().string();
+            if (entry.is_regular_file() && name.compare(0, 11, "application") == 0 &&
+                entry.path().extension() == ".log") {
+                paths.push_back(entry.path().string());
+            }
+        }
+        std::sort(paths.begin(), paths.end());
+        return paths;
+    }
+
+    // 步骤 4.8：按 32MB 切分所有文件，多线程并行解析后按任务顺序合并，并统一来源类字典
+    bool Load(const std::vector<std::string>& paths, LogTable& table, std::string& errorMsg, unsigned threadCount) {
+        table = LogTable();
+        std::vector<ParseTask> tasks;
+        for (const auto& path : paths) {
+            auto mapped = std::make_shared<MappedFile>(path);
+            if (!mapped->IsOpen()) {
+                errorMsg = "无法打开日志文件: " + path + ", WinError: " + std::to_string(::GetLastError());
+                return false;
+            }
+            const uint32_t fileIndex = static_cast<uint32_t>(table.files.size());
+            for (uint64_t begin = 0; begin < mapped->Size(); begin += CHUNK_BYTES) {
+                tasks.push_back({ fileIndex, begin, (std::min)(begin + CHUNK_BYTES, mapped->Size()) });
+            }
+            table.bytesScanned += mapped->Size();
+            table.files.push_back(std::move(mapped));
+            table.filePaths.push_back(path);
+        }
+
+        // 任务数通常远多于线程数，线程按原子下标领取任务以平衡负载
+        std::vector<ColumnChunk> chunks(tasks.size());
+        std::atomic<size_t> nextTask(0);
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < ResolveThreads(threadCount); ++t) {
+            workers.emplace_back([&]() {
+                for (size_t i = nextTask++; i < tasks.size(); i = nextTask++) {
+                    ParseChunk(*table.files[tasks[i].file], tasks[i].begin, tasks[i].end, chunks[i]);
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        // 先按任务顺序统一来源类字典并计算每个任务在表中的起始行，再并行复制各列
+        std::vector<std::vector<uint32_t>> remaps(chunks.size());
+        std::vector<size_t> rowStart(chunks.size() + 1, 0);
+        std::unordered_map<std::string_view, uint32_t> globalDictionary;
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            const ColumnChunk& chunk = chunks[i];
+            remaps[i].resize(chunk.sourceNames.size());
+            for (size_t local = 0; local < chunk.sourceNames.size(); ++local) {
+                auto it = globalDictionary.find(chunk.sourceNames[local]);
+                if (it == globalDictionary.end()) {
+                    uint32_t id = static_cast<uint32_t>(table.sourceDictionary.size());
+                    // 字典键引用映射区域，表存在期间一直有效
+                    it = globalDictionary.emplace(chunk.sourceNames[local], id).first;
+                    table.sourceDictionary.emplace_back(chunk.sourceNames[local]);
+                }
+                remaps[i][local] = it->second;
+            }
+            rowStart[i + 1] = rowStart[i] + chunk.timestamp.size();
+            table.unparsedLines += chunk.unparsedLines;
+        }
+
+        const size_t totalRows = rowStart.back();
+        table.timestamp.resize(totalRows);
+        table.level.resize(totalRows);
+        table.thread.resize(totalRows);
+        table.source.resize(totalRows);
+        table.file.resize(totalRows);
+        table.messageOffset.resize(totalRows);
+        table.messageLength.resize(totalRows);
+
+        nextTask = 0;
+        workers.clear();
+        for (unsigned t = 0; t < ResolveThreads(threadCount); ++t) {
+            workers.emplace_back([&]() {
+                for (size_t i = nextTask++; i < chunks.size(); i = nextTask++) {
+                    ColumnChunk& chunk = chunks[i];
+                    const size_t at = rowStart[i];
+                    const size_t rows = chunk.timestamp.size();
+                    std::copy(chunk.timestamp.begin(), chunk.timestamp.end(), table.timestamp.begin() + at);
+                    std::copy(chunk.level.begin(), chunk.level.end(), table.level.begin() + at);
+                    std::copy(chunk.thread.begin(), chunk.thread.end(), table.thread.begin() + at);
+                    std::copy(chunk.messageOffset.begin(), chunk.messageOffset.end(), table.messageOffset.begin() + at);
+                    std::copy(chunk.messageLength.begin(), chunk.messageLength.end(), table.messageLength.begin() + at);
+                    std::fill(table.file.begin() + at, table.file.begin() + at + rows, tasks[i].file);
+                    const uint32_t* remap = remaps[i].data();
+                    for (size_t row = 0; row < rows; ++row) {
+                        table.source[at + row] = remap[chunk.source[row]];
+                    }
+                    chunk = ColumnChunk(); // 尽早释放中间结果
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        return true;
+    }
+
+    // 步骤 4.8：时间范围不大时用稠密数组按 (分钟, 级别) 计数，每个线程扫描一段连续的行
+    std::vector<MinuteLevelCount> CountByLevelPerMinute(const LogTable& table, unsigned threadCount) {
+        std::vector<MinuteLevelCount> result;
+        const size_t rows = table.RowCount();
+        if (rows == 0) {
+            return result;
+        }
+        const unsigned threads = ResolveThreads(threadCount);
+
+        auto minmax = std::minmax_element(table.timestamp.begin(), table.timestamp.end());
+        const int64_t firstMinute = *minmax.first / 60;
+        const int64_t lastMinute = *minmax.second / 60;
+        const int64_t slots = (lastMinute - firstMinute + 1) * LEVEL_COUNT;
+
+        if (slots <= DENSE_MINUTE_SLOTS) {
+            std::vector<std::vector<uint64_t>> partials(threads);
+            ParallelFor(rows, threads, [&](unsigned part, size_t begin, size_t end) {
+                std::vector<uint64_t> counts(static_cast<size_t>(slots), 0);
+                const int64_t* ts = table.timestamp.data();
+                const uint8_t* lv = table.level.data();
+                for (size_t i = begin; i < end; ++i) {
+                    counts[static_cast<size_t>((ts[i] / 60 - firstMinute) * LEVEL_COUNT + lv[i])]++;
+                }
+                partials[part] = std::move(counts);
+            });
+
+            for (int64_t minute = 0; minute <= lastMinute - firstMinute; ++minute) {
+                MinuteLevelCount row{ (firstMinute + minute) * 60, { 0, 0, 0, 0 } };
+                uint64_t total = 0;
+                for (const auto& partial : partials) {
+                    if (partial.empty()) {
+                        continue;
+                    }
+                    for (int level = 0; level < LEVEL_COUNT; ++level) {
+                        row.counts[level] += partial[static_cast<size_t>(minute * LEVEL_COUNT + level)];
+                    }
+                }
+                for (int level = 0; level < LEVEL_COUNT; ++level) {
+                    total += row.counts[level];
+                }
+                if (total > 0) {
+                    result.push_back(row);
+                }
+            }
+            return result;
+        }
+
+        // 时间跨度过大 (如混入了时钟异常的行)：退化为有序映射
+        std::vector<std::map<int64_t, MinuteLevelCount>> partials(threads);
+        ParallelFor(rows, threads, [&](unsigned part, size_t begin, size_t end) {
+            auto& counts = partials[part];
+            for (size_t i = begin; i < end; ++i) {
+                int64_t minute = table.timestamp[i] / 60 * 60;
+                auto it = counts.find(minute);
+                if (it == counts.end()) {
+                    it = counts.emplace(minute, MinuteLevelCount{ minute, { 0, 0, 0, 0 } }).first;
+                }
+                it->second.counts[table.level[i]]++;
+            }
+        });
+        std::map<int64_t, MinuteLevelCount> merged;
+        for (const auto& partial : partials) {
+            for (const auto& kv : partial) {
+                auto it = merged.emplace(kv.first, MinuteLevelCount{ kv.first, { 0, 0, 0, 0 } }).first;
+                for (int level = 0; level < LEVEL_COUNT; ++level) {
+                    it->second.counts[level] += kv.second.counts[level];
+                }
+            }
+        }
+        for (const auto& kv : merged) {
+            result.push_back(kv.second);
+        }
+        return result;
+    }
+
+    // 步骤 4.8：来源类已字典编码，直接按编号累加到稠密数组
+    std::vector<std::pair<std::string, uint64_t>> TopSources(const LogTable& table, size_t k, int minLevel, unsigned threadCount) {
+        const unsigned threads = ResolveThreads(threadCount);
+        const size_t dictSize = table.sourceDictionary.size();
+        std::vector<std::vector<uint64_t>> partials(threads);
+        ParallelFor(table.RowCount(), threads, [&](unsigned part, size_t begin, size_t end) {
+            std::vector<uint64_t> counts(dictSize, 0);
+            const uint32_t* src = table.source.data();
+            const uint8_t* lv = table.level.data();
+            for (size_t i = begin; i < end; ++i) {
+                counts[src[i]] += (lv[i] >= minLevel) ? 1 : 0;
+            }
+            partials[part] = std::move(counts);
+        });
+
+        std::vector<std::pair<std::string, uint64_t>> result;
+        for (size_t id = 0; id < dictSize; ++id) {
+            uint64_t total = 0;
+            for (const auto& partial : partials) {
+                total += partial.empty() ? 0 : partial[id];
+            }
+            if (total > 0) {
+                result.emplace_back(table.sourceDictionary[id], total);
+            }
+        }
+        k = (std::min)(k, result.size());
+        std::partial_sort(result.begin(), result.begin() + k, result.end(),
+            [](const auto& a, const auto& b) { return a.second > b.second; });
+        result.resize(k);
+        return result;
+    }
+
+    // 步骤 4.8：线程号取值稀疏，每个扫描线程使用自己的哈希表，最后合并
+    std::vector<std::pair<uint32_t, uint64_t>> TopThreads(const LogTable& table, size_t k, int minLevel, unsigned threadCount) {
+        const unsigned threads = ResolveThreads(threadCount);
+        std::vector<std::unordered_map<uint32_t, uint64_t>> partials(threads);
+        ParallelFor(table.RowCount(), threads, [&](unsigned part, size_t begin, size_t end) {
+            auto& counts = partials[part];
+            const uint32_t* tid = table.thread.data();
+            const uint8_t* lv = table.level.data();
+            for (size_t i = begin; i < end; ++i) {
+                if (lv[i] >= minLevel) {
+                    counts[tid[i]]++;
+                }
+            }
+        });
+
+        std::unordered_map<uint32_t, uint64_t> merged;
+        for (const auto& partial : partials) {
+            for (const auto& kv : partial) {
+                merged[kv.first] += kv.second;
+            }
+        }
+        std::vector<std::pair<uint32_t, uint64_t>> result(merged.begin(), merged.end());
+        k = (std::min)(k, result.size());
+        std::partial_sort(result.begin(), result.begin() + k, result.end(),
+            [](const auto& a, const auto& b) { return a.second > b.second; });
+        result.resize(k);
+        return result;
+    }
+
+    std::string FormatMinute(int64_t seconds) {
+        const std::time_t t = static_cast<std::time_t>(seconds);
+        std::tm bt{};
+        char buffer[64] = { 0 };
+        if (localtime_s(&bt, &t) != 0 || std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M", &bt) == 0) {
+            std::snprintf(buffer, sizeof(buffer), "@%lld", static_cast<long long>(seconds));
+        }
+        return buffer;
+    }
+}
@@ -0,0 +1,68 @@
+﻿// LogAnalytics.h
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// 步骤 4.8：CoreLogger 日志分析引擎
+// 解析 FileWriter::FormatLogEntry 输出的行：
+//   "YYYY-MM-DD HH:MM:SS [LEVEL]  [TID:n]  [SourceClass] message"
+// 按列存放在内存中 (时间戳、级别、线程、字典编码的来源类、消息偏移)，
+// 分组查询只顺序扫描所需的列
+namespace LogAnalytics {
+
+    // 级别列的取值，与 LogLevel 的数值一致
+    const int LEVEL_COUNT = 4;
+    const char* const LEVEL_NAMES[LEVEL_COUNT] = { "INFO", "WARN", "ERROR", "FATAL" };
+
+    // 一个已映射到内存的日志文件 (消息列直接引用映射区域，不复制)
+    class MappedFile;
+
+    // 列式日志表
+    struct LogTable {
+        std::vector<int64_t> timestamp;        // UTC 秒数 (由日志中的本地时间按时区与夏令时换算)
+        std::vector<uint8_t> level;            // 0..3
+        std::vector<uint32_t> thread;          // TID
+        std::vector<uint32_t> source;          // 来源类的字典编号
+        std::vector<uint32_t> file;            // 所在文件下标
+        std::vector<uint64_t> messageOffset;   // 消息在文件中的偏移
+        std::vector<uint32_t> messageLength;   // 消息长度 (不含换行)
+
+        std::vector<std::string> sourceDictionary;        // 字典编号 -> 来源类名
+        std::vector<std::shared_ptr<MappedFile>> files;   // 保持映射有效
+        std::vector<std::string> filePaths;
+
+        uint64_t bytesScanned = 0;
+        uint64_t unparsedLines = 0;            // 不符合格式的行 (如多行消息的后续行)
+
+        size_t RowCount() const { return timestamp.size(); }
+        std::string_view Message(size_t row) const;
+    };
+
+    // 列出目录中的全部 CoreLogger 日志文件 (活动文件与已滚动的备份文件)
+    std::vector<std::string> FindLogFiles(const std::string& logDir);
+
+    // 并行解析多个日志文件到列式表；threadCount 为 0 时使用全部硬件线程
+    bool Load(const std::vector<std::string>& paths, LogTable& table, std::string& errorMsg,
+        unsigned threadCount = 0);
+
+    // 每分钟各级别的条目数：(分钟起始秒, 各级别计数)，按时间排序
+    struct MinuteLevelCount {
+        int64_t minute;
+        uint64_t counts[LEVEL_COUNT];
+    };
+    std::vector<MinuteLevelCount> CountByLevelPerMinute(const LogTable& table, unsigned threadCount = 0);
+
+    // 条目数最多的前 k 个来源类 / 线程 (按计数降序)；minLevel 用于只统计该级别及以上
+    std::vector<std::pair<std::string, uint64_t>> TopSources(const LogTable& table, size_t k,
+        int minLevel = 0, unsigned threadCount = 0);
+    std::vector<std::pair<uint32_t, uint64_t>> TopThreads(const LogTable& table, size_t k,
+        int minLevel = 0, unsigned threadCount = 0);
+
+    // UTC 秒数格式化为本地时间 "YYYY-MM-DD HH:MM"
+    std::string FormatMinute(int64_t seconds);
+}
@@ -0,0 +1,109 @@
+﻿// main.cpp
+// 步骤 4.8：CoreLogger 日志分析命令行工具
+// 用法：LogAnalytics <日志目录> [--top N] [--threads N] [--min-level INFO|WARN|ERROR|FATAL] [--no-minutes]
+#include "LogAnalytics.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    void PrintUsage() {
+        std::cout << "用法: LogAnalytics <日志目录> [--top N] [--threads N] "
+            << "[--min-level INFO|WARN|ERROR|FATAL] [--no-minutes]" << std::endl;
+    }
+
+    int ParseLevel(const char* name) {
+        for (int level = 0; level < LogAnalytics::LEVEL_COUNT; ++level) {
+            if (std::strcmp(name, LogAnalytics::LEVEL_NAMES[level]) == 0) {
+                return level;
+            }
+        }
+        return -1;
+    }
+
+    double SecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        PrintUsage();
+        return 1;
+    }
+
+    std::string logDir = argv[1];
+    size_t top = 10;
+    unsigned threads = 0;
+    int minLevel = 0;
+    bool showMinutes = true;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--top" && i + 1 < argc) {
+            top = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--min-level" && i + 1 < argc) {
+            minLevel = ParseLevel(argv[++i]);
+            if (minLevel < 0) {
+                std::cerr << "未知的日志级别: " << argv[i] << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--no-minutes") {
+            showMinutes = false;
+        }
+        else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    std::vector<std::string> files = LogAnalytics::FindLogFiles(logDir);
+    if (files.empty()) {
+        std::cerr << "目录中没有日志文件: " << logDir << std::endl;
+        return 1;
+    }
+
+    auto loadStart = std::chrono::steady_clock::now();
+    LogAnalytics::LogTable table;
+    std::string errorMsg;
+    if (!LogAnalytics::Load(files, table, errorMsg, threads)) {
+        std::cerr << "加载失败: " << errorMsg << std::endl;
+        return 1;
+    }
+    double loadSeconds = SecondsSince(loadStart);
+    double megabytes = static_cast<double>(table.bytesScanned) / (1024.0 * 1024.0);
+    std::cout << "已加载 " << files.size() << " 个文件, " << table.RowCount() << " 行, "
+        << megabytes << " MB, 无法解析 " << table.unparsedLines << " 行, 耗时 " << loadSeconds << " s ("
+        << (loadSeconds > 0 ? megabytes / loadSeconds : 0.0) << " MB/s)" << std::endl;
+
+    auto queryStart = std::chrono::steady_clock::now();
+    if (showMinutes) {
+        std::cout << "\n== 每分钟各级别条目数 ==" << std::endl;
+        std::cout << "时间\t\t\tINFO\tWARN\tERROR\tFATAL" << std::endl;
+        for (const auto& row : LogAnalytics::CountByLevelPerMinute(table, threads)) {
+            std::cout << LogAnalytics::FormatMinute(row.minute);
+            for (int level = 0; level < LogAnalytics::LEVEL_COUNT; ++level) {
+                std::cout << "\t" << row.counts[level];
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    std::cout << "\n== 前 " << top << " 个来源类 (级别 >= " << LogAnalytics::LEVEL_NAMES[minLevel] << ") ==" << std::endl;
+    for (const auto& kv : LogAnalytics::TopSources(table, top, minLevel, threads)) {
+        std::cout << kv.second << "\t" << kv.first << std::endl;
+    }
+
+    std::cout << "\n== 前 " << top << " 个线程 (级别 >= " << LogAnalytics::LEVEL_NAMES[minLevel] << ") ==" << std::endl;
+    for (const auto& kv : LogAnalytics::TopThreads(table, top, minLevel, threads)) {
+        std::cout << kv.second << "\tTID:" << kv.first << std::endl;
+    }
+
+    std::cout << "\n查询耗时 " << SecondsSince(queryStart) << " s" << std::endl;
+    return 0;
+}